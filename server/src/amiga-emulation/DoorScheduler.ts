@@ -0,0 +1,227 @@
+import {
+  MoiraEmulator, MoiraModule, MoiraBackend, MoiraProfile, DoorHost, DoorThread, ExecEvent, RunResult,
+  loadMoiraModule, defaultBackend, memoryView,
+  TICK_CONTEXT, TICK_EVENT, TICK_EVENT_WORDS, EVENT_RECORD_WORDS,
+  EVENT_REASON, EVENT_PC, EVENT_CYCLES, EVENT_IDLE
+} from './cpu/MoiraEmulator';
+
+/**
+ * Called after every slice of a door. Library calls and JIT events are
+ * serviced before the callback runs (events TRAP, HOT and JIT); every other
+ * event except BUDGET and IDLE leaves the door parked.
+ */
+export type SliceCallback = (result: RunResult) => void;
+
+interface ScheduledDoor {
+  emulator: MoiraEmulator;
+  onSlice: SliceCallback;
+  onError: (error: unknown) => void;
+  thread: DoorThread | null; // Set while the door runs on its own thread
+}
+
+// Atomics.waitAsync is not part of the ES2020 typings
+const atomics = Atomics as typeof Atomics & {
+  waitAsync(array: Int32Array, index: number, value: number): { value: Promise<string> | string };
+};
+
+/**
+ * DoorScheduler - Runs all door sessions on one WASM module
+ * With the pthreads build, every door CPU runs on its own thread and only
+ * the library calls are serviced here, so CPU-heavy doors do not hold up
+ * the event loop. Otherwise the native door host time-slices the door CPUs
+ * round-robin and this class drives its ticks from the event loop.
+ */
+export class DoorScheduler {
+  private static instance: Promise<DoorScheduler> | null = null;
+
+  private doors: Map<number, ScheduledDoor> = new Map();
+  private running: boolean = false;
+  private heap32View: Int32Array | null = null;
+
+  // Cycles per door and round (matches the old per-session slice)
+  private readonly SLICE_CYCLES = 100000;
+
+  // Delay between rounds when every door is parked in an idle loop
+  private readonly IDLE_BACKOFF_MS = 10;
+
+  private constructor(private backend: MoiraBackend, private module: MoiraModule, private host: DoorHost) {}
+
+  static getInstance(): Promise<DoorScheduler> {
+    if (!DoorScheduler.instance) {
+      const backend = defaultBackend();
+      DoorScheduler.instance = loadMoiraModule(backend)
+        .then(module => new DoorScheduler(backend, module, new module.DoorHost()));
+    }
+    return DoorScheduler.instance;
+  }
+
+  getBackend(): MoiraBackend {
+    return this.backend;
+  }
+
+  /**
+   * True if doors run on their own threads (pthreads build loaded)
+   */
+  isThreaded(): boolean {
+    return this.module.DoorThread !== undefined;
+  }
+
+  /**
+   * Create and initialize an emulator that runs as a context of the door host
+   */
+  async createEmulator(memorySize?: number, profile?: MoiraProfile): Promise<MoiraEmulator> {
+    const emulator = new MoiraEmulator(memorySize, this.host, this.backend, profile);
+    await emulator.initialize();
+    return emulator;
+  }
+
+  /**
+   * Start scheduling a door (after its program is loaded and the CPU reset)
+   */
+  start(emulator: MoiraEmulator, onSlice: SliceCallback, onError: (error: unknown) => void): void {
+    const id = emulator.getContextId();
+    const door: ScheduledDoor = { emulator, onSlice, onError, thread: null };
+    this.doors.set(id, door);
+
+    if (this.module.DoorThread) {
+      door.thread = new this.module.DoorThread(emulator.getCPU(), this.SLICE_CYCLES);
+      door.thread.start();
+      this.watchThread(door).catch(onError);
+      return;
+    }
+
+    this.host.resume(id);
+    if (!this.running) {
+      this.running = true;
+      setImmediate(() => this.runRound());
+    }
+  }
+
+  /**
+   * Stop scheduling a door. The emulator is still owned by the caller.
+   */
+  stop(emulator: MoiraEmulator): void {
+    const id = emulator.getContextId();
+    const door = this.doors.get(id);
+    if (!door) return;
+    this.doors.delete(id);
+
+    if (door.thread) {
+      const thread = door.thread;
+      door.thread = null;
+      thread.stop();
+      // Wake the watcher, so it sees the door is gone
+      Atomics.notify(this.heap32(), thread.getSignalPointer() >>> 2);
+      thread.delete();
+    } else {
+      this.host.suspend(id);
+    }
+  }
+
+  /**
+   * Service one event of a door. Returns true if a library call or JIT
+   * event was serviced and the door resumed.
+   */
+  private dispatch(id: number, door: ScheduledDoor, record: Uint32Array, resume: () => void): boolean {
+    const event: ExecEvent = record[EVENT_REASON];
+    let resumed = false;
+    let cycles = record[EVENT_CYCLES];
+
+    try {
+      door.emulator.pumpConsole();
+      const serviced = event === ExecEvent.TRAP || event === ExecEvent.HOT || event === ExecEvent.JIT;
+      if (serviced) {
+        cycles += door.emulator.serviceEvent(event, record, this.SLICE_CYCLES);
+        // The handler may have ended the session
+        if (this.doors.get(id) !== door) return false;
+      }
+      // onSlice reads registers and guest memory, so the door must not run
+      // again (on its own thread in the pthreads build) before it returns
+      door.onSlice({ event, cycles, pc: record[EVENT_PC], idle: record[EVENT_IDLE] });
+      if (serviced && this.doors.get(id) === door) {
+        resume();
+        resumed = true;
+      }
+    } catch (error) {
+      this.stop(door.emulator);
+      door.onError(error);
+    }
+    return resumed;
+  }
+
+  /**
+   * One round: every runnable door runs up to its slice. Library calls are
+   * serviced between ticks, so a door making many calls still gets its whole
+   * slice in the same round.
+   */
+  private runRound(): void {
+    let busy = false;
+    let trapped: boolean;
+
+    do {
+      trapped = false;
+      const count = this.host.tick(this.SLICE_CYCLES);
+      // Copy the events: callbacks may grow the heap or start a new tick
+      const events = memoryView(this.module, Uint32Array, this.host.getEventsPointer(), count * TICK_EVENT_WORDS).slice();
+
+      for (let i = 0; i < count; i++) {
+        const base = i * TICK_EVENT_WORDS;
+        const id = events[base + TICK_CONTEXT];
+        const record = events.subarray(base + TICK_EVENT, base + TICK_EVENT_WORDS);
+        const door = this.doors.get(id);
+        if (!door) continue;
+
+        if (record[EVENT_REASON] !== ExecEvent.IDLE) busy = true;
+        if (this.dispatch(id, door, record, () => this.host.resume(id))) trapped = true;
+      }
+    } while (trapped);
+
+    if (this.doors.size === 0) {
+      this.running = false;
+      return;
+    }
+
+    // Doors parked in a branch to themselves can only be woken by an
+    // interrupt, which never comes, so back off instead of spinning the host CPU
+    if (busy) {
+      setImmediate(() => this.runRound());
+    } else {
+      setTimeout(() => this.runRound(), this.IDLE_BACKOFF_MS);
+    }
+  }
+
+  /**
+   * Service the events of a door running on its own thread. Sleeps on the
+   * thread's signal word between events without blocking the event loop.
+   */
+  private async watchThread(door: ScheduledDoor): Promise<void> {
+    const id = door.emulator.getContextId();
+    const thread = door.thread!;
+    const signal = thread.getSignalPointer() >>> 2;
+    const recordPointer = thread.getEventRecordPointer();
+    const resume = () => thread.resume();
+
+    while (door.thread === thread) {
+      const seen = Atomics.load(this.heap32(), signal);
+      while (door.thread === thread && thread.pollEvent()) {
+        const record = memoryView(this.module, Uint32Array, recordPointer, EVENT_RECORD_WORDS).slice();
+        this.dispatch(id, door, record, resume);
+      }
+      if (door.thread !== thread) return;
+
+      const wait = atomics.waitAsync(this.heap32(), signal, seen).value;
+      if (typeof wait !== 'string') await wait;
+    }
+  }
+
+  /**
+   * Int32 view of the (shared) heap for Atomics, recreated when the heap grows
+   */
+  private heap32(): Int32Array {
+    const buffer = this.module.HEAPU32!.buffer;
+    if (!this.heap32View || this.heap32View.buffer !== buffer) {
+      this.heap32View = new Int32Array(buffer);
+    }
+    return this.heap32View;
+  }
+}
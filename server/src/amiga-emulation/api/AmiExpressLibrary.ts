@@ -11,7 +11,6 @@ import { MoiraEmulator, CPURegister } from '../cpu/MoiraEmulator';
 export class AmiExpressLibrary {
   private emulator: MoiraEmulator;
   private outputCallback: ((data: string) => void) | null = null;
-  private inputQueue: string[] = [];
 
   // AmiExpress library function offsets
   // These are the ACTUAL addresses that the trap handler receives when doors call library functions
@@ -46,14 +45,6 @@ export class AmiExpressLibrary {
     this.outputCallback = callback;
   }
 
-  /**
-   * Queue input from user
-   */
-  queueInput(data: string): void {
-    this.inputQueue.push(data);
-    console.log(`[AmiExpress Library] Input queued: "${data}"`);
-  }
-
   /**
    * Handle library call
    */
@@ -117,20 +108,13 @@ export class AmiExpressLibrary {
 
     try {
       // DEBUG: Read first 16 bytes from memory to see what's there
-      const debugBytes: number[] = [];
-      for (let i = 0; i < 16; i++) {
-        const byte = this.emulator.readMemory(stringPtr + i);
-        debugBytes.push(byte);
-      }
+      const debugBytes = Array.from(this.emulator.readMemoryBlock(stringPtr, 16));
       console.log(`[AmiExpress] Memory at 0x${stringPtr.toString(16)}: [${debugBytes.map(b => `0x${b.toString(16).padStart(2, '0')}`).join(', ')}]`);
       console.log(`[AmiExpress] Memory as ASCII: "${debugBytes.map(b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('')}"`);
 
       // Check what's in the DATA segment (0x3900-0x3A78)
       console.log('[AmiExpress] Checking DATA segment at 0x3900:');
-      const dataBytes: number[] = [];
-      for (let i = 0; i < 64; i++) {
-        dataBytes.push(this.emulator.readMemory(0x3900 + i));
-      }
+      const dataBytes = Array.from(this.emulator.readMemoryBlock(0x3900, 64));
       console.log(`[AmiExpress] DATA at 0x3900 (hex): [${dataBytes.slice(0, 16).map(b => `0x${b.toString(16).padStart(2, '0')}`).join(', ')}]`);
       console.log(`[AmiExpress] DATA at 0x3900 (ASCII): "${dataBytes.map(b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('')}"`);
 
@@ -140,10 +124,7 @@ export class AmiExpressLibrary {
         if (possiblePtr > 0x1000 && possiblePtr < 0x100000) {
           console.log(`[AmiExpress] First 4 bytes look like pointer: 0x${possiblePtr.toString(16)}`);
           // Read 32 bytes from that address to see if there's a string there
-          const derefBytes: number[] = [];
-          for (let i = 0; i < 32; i++) {
-            derefBytes.push(this.emulator.readMemory(possiblePtr + i));
-          }
+          const derefBytes = Array.from(this.emulator.readMemoryBlock(possiblePtr, 32));
           console.log(`[AmiExpress] Memory at dereferenced addr 0x${possiblePtr.toString(16)}: [${derefBytes.map(b => `0x${b.toString(16).padStart(2, '0')}`).join(', ')}]`);
           console.log(`[AmiExpress] Dereferenced as ASCII: "${derefBytes.map(b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('')}"`);
         }
@@ -186,7 +167,7 @@ export class AmiExpressLibrary {
 
     console.log(`[AmiExpress] aeGets() called, buffer at: 0x${bufferPtr.toString(16)}, maxlen: ${maxLength}`);
 
-    if (this.inputQueue.length === 0) {
+    if (!this.emulator.hasConsoleInput()) {
       // No input available, return 0 (non-blocking)
       this.emulator.setRegister(CPURegister.D0, 0);
       console.log('[AmiExpress] aeGets() no input available');
@@ -194,15 +175,17 @@ export class AmiExpressLibrary {
     }
 
     try {
-      const input = this.inputQueue.shift()!;
-      const length = Math.min(input.length, maxLength - 1);
-
-      // Write input to buffer
-      for (let i = 0; i < length; i++) {
-        this.emulator.writeMemory(bufferPtr + i, input.charCodeAt(i));
+      // One line of console input, up to and including CR or LF
+      let input = '';
+      while (input.length < maxLength - 1 && !/[\r\n]$/.test(input)) {
+        const byte = this.emulator.readConsoleInput(1);
+        if (byte.length === 0) break;
+        input += String.fromCharCode(byte[0]);
       }
-      // Null terminate
-      this.emulator.writeMemory(bufferPtr + length, 0);
+      const length = input.length;
+
+      // Write input to buffer, null terminated
+      this.emulator.writeMemoryBlock(bufferPtr, Buffer.from(input + '\0', 'latin1'));
 
       // Return length
       this.emulator.setRegister(CPURegister.D0, length);
@@ -237,19 +220,14 @@ export class AmiExpressLibrary {
   private aeGetCh(): boolean {
     console.log('[AmiExpress] aeGetCh() called');
 
-    if (this.inputQueue.length === 0) {
+    const input = this.emulator.readConsoleInput(1);
+    if (input.length === 0) {
       this.emulator.setRegister(CPURegister.D0, -1);
       console.log('[AmiExpress] aeGetCh() no input available');
       return true;
     }
 
-    const input = this.inputQueue.shift()!;
-    const charCode = input.charCodeAt(0);
-
-    // Put remaining characters back in queue
-    if (input.length > 1) {
-      this.inputQueue.unshift(input.substring(1));
-    }
+    const charCode = input[0];
 
     this.emulator.setRegister(CPURegister.D0, charCode);
     console.log(`[AmiExpress] aeGetCh() returned: 0x${charCode.toString(16)} ('${String.fromCharCode(charCode)}')`);
@@ -292,12 +270,11 @@ export class AmiExpressLibrary {
     if (address === 0) return '';
 
     // ALWAYS try C-style null-terminated string first (most common in door code)
+    const bytes = this.emulator.readMemoryBlock(address, maxLength);
     let result = '';
-    let offset = 0;
     let hasNullTerminator = false;
 
-    while (offset < maxLength) {
-      const byte = this.emulator.readMemory(address + offset);
+    for (const byte of bytes) {
       if (byte === 0) {
         hasNullTerminator = true;
         break;
@@ -306,7 +283,6 @@ export class AmiExpressLibrary {
       if (byte >= 32 || byte === 10 || byte === 13 || byte === 9) {
         result += String.fromCharCode(byte);
       }
-      offset++;
     }
 
     // If we found a null-terminated string, return it
@@ -316,12 +292,12 @@ export class AmiExpressLibrary {
     }
 
     // If C-string didn't work, try BSTR (BCPL string - first byte is length)
-    const firstByte = this.emulator.readMemory(address);
+    const firstByte = bytes.length > 0 ? bytes[0] : 0;
     if (firstByte > 0 && firstByte < 128) {
       const bstrLength = firstByte;
       let bstrResult = '';
-      for (let i = 0; i < bstrLength && i < maxLength; i++) {
-        const byte = this.emulator.readMemory(address + 1 + i);
+      for (let i = 0; i < bstrLength && i + 1 < bytes.length; i++) {
+        const byte = bytes[1 + i];
         if (byte === 0) break;
         if (byte >= 32 || byte === 10 || byte === 13 || byte === 9) {
           bstrResult += String.fromCharCode(byte);
@@ -210,20 +210,25 @@ export class AmigaDosEnvironment {
    * Set callback for stdout/stderr output
    */
   setOutputCallback(callback: (data: string) => void): void {
+    // Console output the CPU collected itself (Write, AEPuts, AEPutCh)
+    this.emulator.setConsoleOutput(callback);
+
+    // Calls that reach the libraries send what the CPU collected first
+    const ordered = (data: string) => {
+      this.emulator.pumpConsole();
+      callback(data);
+    };
     // Forward to AmiExpress BBS library (primary for door I/O)
-    this.amiexpressLibrary.setOutputCallback(callback);
+    this.amiexpressLibrary.setOutputCallback(ordered);
     // Also forward to dos.library (fallback for standard I/O)
-    this.dosLibrary.setOutputCallback(callback);
+    this.dosLibrary.setOutputCallback(ordered);
   }
 
   /**
-   * Queue input data from user
+   * Queue input data from user. dos.library and AEDoor calls share it.
    */
   queueInput(data: string): void {
-    // Forward to AmiExpress BBS library (primary for door I/O)
-    this.amiexpressLibrary.queueInput(data);
-    // Also forward to dos.library (fallback for standard I/O)
-    this.dosLibrary.queueInput(data);
+    this.emulator.queueConsoleInput(data);
   }
 
   /**
@@ -30,7 +30,6 @@ export class DosLibrary {
   private openFiles: Map<number, FileHandle> = new Map();
   private nextFileId: number = 100;
   private outputCallback: ((data: string) => void) | null = null;
-  private inputBuffer: string = '';
   private lastError: number = 0;
 
   // Standard file handles
@@ -80,13 +79,6 @@ export class DosLibrary {
     this.outputCallback = callback;
   }
 
-  /**
-   * Queue input data from user
-   */
-  queueInput(data: string): void {
-    this.inputBuffer += data;
-  }
-
   /**
    * Open - Open a file
    * D1 = filename (pointer to BCPL string or C string)
@@ -148,15 +140,10 @@ export class DosLibrary {
     console.log(`[dos.library] Read(handle=${handle}, buffer=0x${bufferAddr.toString(16)}, length=${length})`);
 
     if (handle === this.STDIN_HANDLE) {
-      // Read from input buffer
-      const bytesToRead = Math.min(length, this.inputBuffer.length);
-
-      for (let i = 0; i < bytesToRead; i++) {
-        this.emulator.writeMemory(bufferAddr + i, this.inputBuffer.charCodeAt(i));
-      }
-
-      // Remove read data from buffer
-      this.inputBuffer = this.inputBuffer.substring(bytesToRead);
+      // Read from the console input (the CPU usually services this itself)
+      const input = this.emulator.readConsoleInput(length);
+      const bytesToRead = input.length;
+      this.emulator.writeMemoryBlock(bufferAddr, input);
 
       this.lastError = this.ERROR_NO_ERROR;
       this.emulator.setRegister(CPURegister.D0, bytesToRead);
@@ -184,12 +171,7 @@ export class DosLibrary {
 
     if (handle === this.STDOUT_HANDLE || handle === this.STDERR_HANDLE) {
       // Read data from emulated memory
-      const bytes: number[] = [];
-      for (let i = 0; i < length; i++) {
-        bytes.push(this.emulator.readMemory(bufferAddr + i));
-      }
-
-      const text = String.fromCharCode(...bytes);
+      const text = Buffer.from(this.emulator.readMemoryBlock(bufferAddr, length)).toString('latin1');
       console.log(`[dos.library] Write output: "${text}"`);
 
       // Send to output callback
@@ -299,8 +281,8 @@ export class DosLibrary {
     console.log(`[dos.library] WaitForChar(handle=${handle}, timeout=${timeout})`);
 
     if (handle === this.STDIN_HANDLE) {
-      // Check if data available in input buffer
-      const hasData = this.inputBuffer.length > 0;
+      // Check if data available in the console input
+      const hasData = this.emulator.hasConsoleInput();
       this.emulator.setRegister(CPURegister.D0, hasData ? -1 : 0);
       console.log(`[dos.library] WaitForChar returned: ${hasData ? 'data available' : 'no data'}`);
     } else {
@@ -312,23 +294,14 @@ export class DosLibrary {
    * Helper: Read null-terminated string from memory
    */
   private readString(address: number, maxLen: number = 256): string {
-    const bytes: number[] = [];
-    for (let i = 0; i < maxLen; i++) {
-      const byte = this.emulator.readMemory(address + i);
-      if (byte === 0) break;
-      bytes.push(byte);
-    }
-    return String.fromCharCode(...bytes);
+    return this.emulator.readString(address, maxLen);
   }
 
   /**
    * Helper: Write 32-bit long to memory (big-endian)
    */
   private writeLong(address: number, value: number): void {
-    this.emulator.writeMemory(address, (value >> 24) & 0xFF);
-    this.emulator.writeMemory(address + 1, (value >> 16) & 0xFF);
-    this.emulator.writeMemory(address + 2, (value >> 8) & 0xFF);
-    this.emulator.writeMemory(address + 3, value & 0xFF);
+    this.emulator.writeLong(address, value);
   }
 
   /**
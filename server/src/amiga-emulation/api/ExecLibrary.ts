@@ -7,26 +7,49 @@ import { LibraryLoader } from '../loader/LibraryLoader';
  *
  * Function offsets (negative values):
  * -198 = AllocMem
- * -204 = FreeMem
+ * -204 = AllocAbs
+ * -210 = FreeMem
+ * -216 = AvailMem
  * -408 = OpenLibrary
  * -414 = CloseLibrary
+ * -684 = AllocVec
+ * -690 = FreeVec
+ *
+ * The memory functions run on the guest heap of the CPU (guest-heap.h).
+ * Calls through ExecBase are serviced by the CPU itself and never get here.
  */
 
-interface MemoryBlock {
-  address: number;
-  size: number;
-}
-
 export class ExecLibrary {
+  // Default heap: from 64 KB up to below the door's stack in 1 MB of RAM.
+  // AmigaDoorSession moves it to the end of the hunks and up to heapEnd of
+  // the RAM the door gets.
+  static readonly HEAP_START = 0x10000;
+  static readonly HEAP_END = 0xF0000;
+
+  /**
+   * Initial stack pointer for a door with the given RAM size: 8 KB below the
+   * top of RAM, which ends below the trap window at 0xFF0000
+   */
+  static stackTop(memorySize: number): number {
+    return Math.min(memorySize, 0xFF0000) - 0x2000;
+  }
+
+  /**
+   * End of the heap for a door with the given RAM size, leaving 56 KB for
+   * the stack
+   */
+  static heapEnd(memorySize: number): number {
+    return ExecLibrary.stackTop(memorySize) - 0xE000;
+  }
+
   private emulator: MoiraEmulator;
-  private allocatedMemory: Map<number, MemoryBlock> = new Map();
-  private nextAllocAddress: number = 0x10000; // Start allocations at 64KB
   private openLibraries: Map<string, number> = new Map();
   private libraryLoader: LibraryLoader | null = null;
   private useNativeLibraries: boolean = false;
 
   constructor(emulator: MoiraEmulator) {
     this.emulator = emulator;
+    this.emulator.initHeap(ExecLibrary.HEAP_START, ExecLibrary.HEAP_END);
   }
 
   /**
@@ -39,33 +62,16 @@ export class ExecLibrary {
 
   /**
    * AllocMem - Allocate memory
-   * A1 = byte size
-   * D0 = requirements (MEMF_* flags)
+   * D0 = byte size
+   * D1 = requirements (MEMF_* flags)
    * Returns: D0 = address (or 0 if failed)
    */
   AllocMem(): void {
-    const size = this.emulator.getRegister(CPURegister.A1);
-    const requirements = this.emulator.getRegister(CPURegister.D0);
-
-    console.log(`[exec.library] AllocMem(size=${size}, requirements=0x${requirements.toString(16)})`);
-
-    // Simple bump allocator
-    const address = this.nextAllocAddress;
-    this.nextAllocAddress += size + 16; // Add padding
-
-    // Store allocation info
-    this.allocatedMemory.set(address, { address, size });
-
-    // Zero memory if MEMF_CLEAR flag is set (bit 16)
-    if (requirements & 0x10000) {
-      for (let i = 0; i < size; i++) {
-        this.emulator.writeMemory(address + i, 0);
-      }
-    }
-
-    // Return address in D0
+    const size = this.emulator.getRegister(CPURegister.D0);
+    const requirements = this.emulator.getRegister(CPURegister.D1);
+    const address = this.emulator.allocMem(size, requirements);
     this.emulator.setRegister(CPURegister.D0, address);
-    console.log(`[exec.library] AllocMem returned: 0x${address.toString(16)}`);
+    console.log(`[exec.library] AllocMem(size=${size}, requirements=0x${requirements.toString(16)}) returned: 0x${address.toString(16)}`);
   }
 
   /**
@@ -76,11 +82,50 @@ export class ExecLibrary {
   FreeMem(): void {
     const address = this.emulator.getRegister(CPURegister.A1);
     const size = this.emulator.getRegister(CPURegister.D0);
-
     console.log(`[exec.library] FreeMem(address=0x${address.toString(16)}, size=${size})`);
+    this.emulator.freeMem(address, size);
+  }
 
-    // Remove from allocation table
-    this.allocatedMemory.delete(address);
+  /**
+   * AllocAbs - Allocate memory at a given address
+   * D0 = size, A1 = location
+   * Returns: D0 = 0, the heap only hands out blocks where it chooses
+   */
+  AllocAbs(): void {
+    const location = this.emulator.getRegister(CPURegister.A1);
+    const size = this.emulator.getRegister(CPURegister.D0);
+    console.log(`[exec.library] AllocAbs(size=${size}, location=0x${location.toString(16)}) not supported`);
+    this.emulator.setRegister(CPURegister.D0, 0);
+  }
+
+  /**
+   * AvailMem - Query free memory
+   * D1 = requirements (MEMF_LARGEST, MEMF_TOTAL)
+   * Returns: D0 = free bytes, largest free block or heap size
+   */
+  AvailMem(): void {
+    const requirements = this.emulator.getRegister(CPURegister.D1);
+    this.emulator.setRegister(CPURegister.D0, this.emulator.availMem(requirements));
+  }
+
+  /**
+   * AllocVec - Allocate memory that remembers its size
+   * D0 = byte size
+   * D1 = requirements (MEMF_* flags)
+   * Returns: D0 = address (or 0 if failed)
+   */
+  AllocVec(): void {
+    const size = this.emulator.getRegister(CPURegister.D0);
+    const requirements = this.emulator.getRegister(CPURegister.D1);
+    this.emulator.setRegister(CPURegister.D0, this.emulator.allocVec(size, requirements));
+  }
+
+  /**
+   * FreeVec - Free memory allocated by AllocVec
+   * A1 = memory address (may be 0)
+   */
+  FreeVec(): void {
+    this.emulator.freeVec(this.emulator.getRegister(CPURegister.A1));
   }
 
   /**
@@ -185,13 +230,7 @@ export class ExecLibrary {
    * Helper: Read null-terminated string from memory
    */
   private readString(address: number, maxLen: number = 256): string {
-    const bytes: number[] = [];
-    for (let i = 0; i < maxLen; i++) {
-      const byte = this.emulator.readMemory(address + i);
-      if (byte === 0) break;
-      bytes.push(byte);
-    }
-    return String.fromCharCode(...bytes);
+    return this.emulator.readString(address, maxLen);
   }
 
   /**
@@ -203,14 +242,26 @@ export class ExecLibrary {
         this.AllocMem();
         return true;
       case -204:
+        this.AllocAbs();
+        return true;
+      case -210:
         this.FreeMem();
         return true;
+      case -216:
+        this.AvailMem();
+        return true;
       case -408:
         this.OpenLibrary();
         return true;
       case -414:
         this.CloseLibrary();
         return true;
+      case -684:
+        this.AllocVec();
+        return true;
+      case -690:
+        this.FreeVec();
+        return true;
       default:
         return false; // Unknown function
     }
@@ -121,13 +121,7 @@ export class IntuitionLibrary {
    * Helper: Read null-terminated string from memory
    */
   private readString(address: number, maxLen: number = 256): string {
-    const bytes: number[] = [];
-    for (let i = 0; i < maxLen; i++) {
-      const byte = this.emulator.readMemory(address + i);
-      if (byte === 0) break;
-      bytes.push(byte);
-    }
-    return String.fromCharCode(...bytes);
+    return this.emulator.readString(address, maxLen);
   }
 
   /**
@@ -1,62 +1,656 @@
-// TypeScript interface for Moira WebAssembly module
+// TypeScript interface for the Moira module (WebAssembly or native addon)
+
+import * as fs from 'fs';
+import * as path from 'path';
+import { MoiraJit } from './jit/MoiraJit';
 
 export interface MoiraModule {
-  MoiraCPU: new (memSize: number) => MoiraCPU;
+  MoiraCPU: new (memSize: number, profile: number) => MoiraCPU;
+  DoorSnapshot: new () => DoorSnapshot;
+  DoorImage: new () => DoorImage;
+  HunkCache: new () => HunkCache;
+  DoorHost: new () => DoorHost;
+  DoorThread?: new (cpu: MoiraCPU, sliceCycles: number) => DoorThread; // pthreads build only
+  HEAPU8?: Uint8Array;   // WASM builds
+  HEAPU32?: Uint32Array; // WASM builds
+  memoryView?(pointer: number, length: number): ArrayBuffer; // Native addon
 }
 
 export interface MoiraCPU {
+  getProfile(): number;
+  takeOver(other: MoiraCPU): void;
+  saveSnapshot(snapshot: DoorSnapshot): void;
+  restoreSnapshot(snapshot: DoorSnapshot): boolean;
+  freeze(image: DoorImage): void;
+  fork(image: DoorImage): boolean;
   setMemoryByte(addr: number, value: number): void;
   getMemoryByte(addr: number): number;
-  loadProgram(program: Uint8Array, address: number): void;
+  getMemoryPointer(): number;
+  getMemorySize(): number;
+  fillMemory(addr: number, value: number, length: number): void;
+  copyMemory(dst: number, src: number, length: number): void;
+  invalidateCode(addr: number, length: number): void;
+  getPageTypesPointer(): number;
+  protectMemory(addr: number, length: number): void;
+  getBusFault(): number;
+  commitMemory(addr: number, length: number): void;
+  getPageBackingPointer(): number;
+  getReadPointer(addr: number): number;
+  getSharedPageCount(): number;
+  getCommittedPageCount(): number;
+  loadHunks(cache: HunkCache, id: number): boolean;
+  initHeap(start: number, end: number): void;
+  allocMem(size: number, requirements: number): number;
+  freeMem(addr: number, size: number): void;
+  allocVec(size: number, requirements: number): number;
+  freeVec(addr: number): void;
+  availMem(requirements: number): number;
+  getConsoleBufferPointer(): number;
+  readOutput(): number;
+  writeInput(length: number): number;
+  readInput(length: number): number;
+  pendingInput(): number;
   resetCPU(): void;
   executeCycles(cycles: number): number;
-  getRegister(reg: number): number;
-  setRegister(reg: number, value: number): void;
-  setTrapHandler(handler: (offset: number) => void): void;
+  getRegisterFilePointer(): number;
+  setBatchedTraps(enable: boolean): void;
+  getEventRecordPointer(): number;
+  executeUntilEvent(maxCycles: number): number;
+  completeTrap(): void;
+  setJitThreshold(threshold: number): void;
+  setJitEntry(pc: number, compiled: boolean): void;
+  delete(): void;
+}
+
+// Machine image of a door CPU (class DoorSnapshot in door-snapshot.h)
+export interface DoorSnapshot {
+  getPointer(): number;
+  getSize(): number;
+  resize(size: number): void;
+  delete(): void;
+}
+
+// Frozen door that CPUs fork from (class DoorImage in door-snapshot.h)
+export interface DoorImage {
+  delete(): void;
+}
+
+// Relocated door executables (class HunkCache in hunk-image.h)
+export interface HunkCache {
+  getFileBuffer(size: number): number;
+  load(size: number, base: number): number;
+  getParseCount(): number;
+  getCapacity(): number;
+  setCapacity(count: number): void;
+  getImageCount(): number;
+  getCodeShareCount(id: number): number;
+  getEntryPoint(id: number): number;
+  getEnd(id: number): number;
+  getSegmentCount(id: number): number;
+  getSegmentAddress(id: number, segment: number): number;
+  getSegmentSize(id: number, segment: number): number;
+  getSegmentType(id: number, segment: number): number;
+  delete(): void;
+}
+
+// Segment types (enum HunkImage::SegmentType in hunk-image.h)
+const SEGMENT_TYPES = ['code', 'data', 'bss'] as const;
+
+// Executable loaded by MoiraEmulator.loadExecutable
+export interface LoadedExecutable {
+  entryPoint: number;
+  end: number; // End of the last segment
+  segments: { type: typeof SEGMENT_TYPES[number]; address: number; size: number }[];
+  cached: boolean; // Relocated image of an earlier load
+}
+
+// Many door CPUs in one module (class DoorHost in door-host.h)
+export interface DoorHost {
+  createContext(memSize: number, profile: number): number;
+  destroyContext(id: number): void;
+  getContext(id: number): MoiraCPU; // Owned by the host, never delete()d from JS
+  setProfile(id: number, profile: number): void;
+  resume(id: number): void;
+  suspend(id: number): void;
+  tick(sliceCycles: number): number;
+  getEventsPointer(): number;
+  delete(): void;
+}
+
+// One door CPU on its own thread (class DoorThread in door-thread.h)
+export interface DoorThread {
+  start(): void;
+  resume(): void;
+  stop(): void;
+  pollEvent(): boolean;
+  getEventRecordPointer(): number;
+  getSignalPointer(): number;
   delete(): void;
 }
 
-// CPU Register indices
+// native - Node addon built by build-native.sh (build/moira-native.node)
+// wasm   - Emscripten module built by build-wasm.sh
+export type MoiraBackend = 'native' | 'wasm';
+
+const NATIVE_BUILD = path.join(__dirname, 'build', 'moira-native.node');
+
+// fast     - stripped core for production doors
+// accurate - precise timing, address errors and 68000 (not Musashi) timing,
+//            for debugging sessions
+// Both are part of every build (enum DoorProfile in door-cpu.h).
+export type MoiraProfile = 'fast' | 'accurate';
+
+const PROFILE_IDS: Record<MoiraProfile, number> = { fast: 0, accurate: 1 };
+
+/**
+ * Profile used when none is requested: MOIRA_PROFILE if set, otherwise fast
+ */
+export function defaultProfile(): MoiraProfile {
+  return process.env.MOIRA_PROFILE === 'accurate' ? 'accurate' : 'fast';
+}
+
+const modulePromises: Map<MoiraBackend, Promise<MoiraModule>> = new Map();
+
+// Relocated executables of each module, shared by all its emulators
+const hunkCaches: Map<MoiraModule, HunkCache> = new Map();
+
+/**
+ * Backend used when none is requested: MOIRA_BACKEND if set, otherwise the
+ * native addon if it has been built, otherwise WASM
+ */
+export function defaultBackend(): MoiraBackend {
+  const requested = process.env.MOIRA_BACKEND;
+  if (requested === 'native' || requested === 'wasm') return requested;
+  return fs.existsSync(NATIVE_BUILD) ? 'native' : 'wasm';
+}
+
+/**
+ * Load a module once per process. Every emulator of a backend shares its
+ * memory and jump tables. For WASM, prefers the pthreads build, then the
+ * statically dispatched build, if present; MOIRA_THREADS=0 skips the
+ * pthreads build.
+ */
+export function loadMoiraModule(backend: MoiraBackend = defaultBackend()): Promise<MoiraModule> {
+  let modulePromise = modulePromises.get(backend);
+  if (!modulePromise) {
+    if (backend === 'native') {
+      modulePromise = Promise.resolve(require(NATIVE_BUILD) as MoiraModule);
+    } else {
+      const builds = ['moira-static.js'];
+      if (process.env.MOIRA_THREADS !== '0') builds.unshift('moira-threads.js');
+      const build = builds.map(name => path.join(__dirname, 'build', name)).find(file => fs.existsSync(file));
+      const createMoiraModule = require(build ?? './build/moira.js');
+      modulePromise = createMoiraModule() as Promise<MoiraModule>;
+    }
+    modulePromises.set(backend, modulePromise);
+  }
+  return modulePromise;
+}
+
+/**
+ * Backing store of a module's memory, or null for the native addon. Views
+ * must be recreated when it changes, because growing the WASM heap detaches
+ * the old ArrayBuffer.
+ */
+export function memoryBuffer(module: MoiraModule): ArrayBufferLike | null {
+  return module.HEAPU8 ? module.HEAPU8.buffer : null;
+}
+
+/**
+ * View of module memory at an address returned by the CPU or door host
+ * (length in elements)
+ */
+export function memoryView<T extends Uint8Array | Uint32Array>(
+  module: MoiraModule,
+  type: { new (buffer: ArrayBufferLike, byteOffset: number, length: number): T; BYTES_PER_ELEMENT: number },
+  pointer: number,
+  length: number
+): T {
+  if (length === 0) return new type(new ArrayBuffer(0), 0, 0);
+  if (module.memoryView) {
+    return new type(module.memoryView(pointer, length * type.BYTES_PER_ELEMENT), 0, length);
+  }
+  return new type(module.HEAPU8!.buffer, pointer, length);
+}
+
+// CPU Register indices (word offsets inside the register file, struct RegisterFile in door-cpu.h)
 export enum CPURegister {
   D0 = 0, D1 = 1, D2 = 2, D3 = 3,
   D4 = 4, D5 = 5, D6 = 6, D7 = 7,
   A0 = 8, A1 = 9, A2 = 10, A3 = 11,
   A4 = 12, A5 = 13, A6 = 14, A7 = 15,
   PC = 16,  // Program Counter
-  SR = 17   // Status Register
+  SR = 17,  // Status Register
+  USP = 18, // User Stack Pointer
+  ISP = 19  // Interrupt (supervisor) Stack Pointer
+}
+
+const REGISTER_DIRTY = 20;
+const REGISTER_CYCLES = 21; // Cycles executed by the JIT, added to the CPU clock
+const REGISTER_FILE_WORDS = 22;
+
+// Guest memory pages (class GuestMemory in guest-memory.h)
+const PAGE_BITS = 12;
+const PAGE_COUNT = 4096;
+const PAGE_CODE = 4; // PageType::CODE, RAM holding code cached by the CPU
+const PAGE_OWN = 0;  // PageBacking::OWN, page committed to guest RAM
+
+// Staging buffer of the console rings (DoorConsole::BUFFER_SIZE in door-console.h)
+const CONSOLE_BUFFER_SIZE = 64 * 1024;
+
+// Why runUntilEvent returned (enum ExecEvent in door-cpu.h)
+export enum ExecEvent {
+  BUDGET = 0,   // Cycle budget used up
+  TRAP = 1,     // Library call (serviced inside runUntilEvent)
+  EXIT = 2,     // Door returned to EXIT_ADDRESS
+  STOP = 3,     // STOP instruction
+  HALTED = 4,   // CPU halted (double fault)
+  ILLEGAL = 5,  // Illegal instruction or unimplemented Line A/F opcode
+  FAULT = 6,    // Bus error or address error
+  IDLE = 7,     // Parked in a branch to itself (cycles fast-forwarded)
+  HOT = 8,      // Hot loop found (compiled inside runUntilEvent)
+  JIT = 9       // Compiled loop reached (run inside runUntilEvent)
+}
+
+/**
+ * Executions of a loop start before the JIT compiles it: MOIRA_JIT_THRESHOLD
+ * if set. MOIRA_JIT=1 enables the JIT on the native addon, MOIRA_JIT=0
+ * disables it on WASM, where it is on by default.
+ */
+function jitThreshold(backend: MoiraBackend): number {
+  const enabled = process.env.MOIRA_JIT;
+  if (enabled === '0' || (backend !== 'wasm' && enabled !== '1')) return 0;
+  return Number(process.env.MOIRA_JIT_THRESHOLD) || 1000;
 }
 
+export interface RunResult {
+  event: ExecEvent;
+  cycles: number;
+  pc: number;   // ILLEGAL, FAULT: address of the instruction
+  idle: number; // Part of cycles skipped in idle loops (DBcc/Bcc to itself)
+}
+
+// Word offsets inside the event record (struct EventRecord in door-cpu.h)
+export const EVENT_REASON = 0;
+export const EVENT_OFFSET = 1;
+export const EVENT_PC = 2;
+export const EVENT_CYCLES = 3;
+export const EVENT_IDLE = 4;
+export const EVENT_RECORD_WORDS = 5;
+
+// Word offsets inside a tick event (struct TickEvent in door-host.h)
+export const TICK_CONTEXT = 0;
+export const TICK_EVENT = 1; // Followed by the EVENT_* words
+export const TICK_EVENT_WORDS = 1 + EVENT_RECORD_WORDS;
+
 export class MoiraEmulator {
   private module: MoiraModule | null = null;
   private cpu: MoiraCPU | null = null;
   private trapHandler: ((offset: number) => void) | null = null;
+  private ram: Uint8Array | null = null; // View of guest RAM
+  private registers: Uint32Array | null = null; // View of the register file
+  private eventRecord: Uint32Array | null = null; // View of the event record
+  private pageTypes: Uint8Array | null = null; // View of the page types
+  private pageBackings: Uint8Array | null = null; // View of the page backings
+  private consoleBuffer: Uint8Array | null = null; // View of the console staging buffer
+  private consoleOutput: ((data: string) => void) | null = null;
+  private consoleInput: string = ''; // Input that did not fit into the ring yet
+  private viewBuffer: ArrayBufferLike | null = null; // Module memory the views were created on
+  private contextId: number = -1; // Context inside the door host, if any
+  private jit: MoiraJit | null = null; // Compiled hot loops, if the JIT is enabled
+
+  // Return address for the door's final RTS (MoiraCPU::EXIT_ADDRESS)
+  static readonly EXIT_ADDRESS = 0x00FF0000;
 
-  constructor(private memorySize: number = 1024 * 1024) {} // Default 1MB
+  /**
+   * With a door host, the CPU is a context of the host and runs in its
+   * scheduler (see DoorScheduler); otherwise it is a standalone CPU. The
+   * host must come from the module of the same backend.
+   */
+  constructor(
+    private memorySize: number = 1024 * 1024, // Default 1MB
+    private host: DoorHost | null = null,
+    private backend: MoiraBackend = defaultBackend(),
+    private profile: MoiraProfile = defaultProfile()
+  ) {}
 
   async initialize(): Promise<void> {
-    // Load the WASM module
-    const createMoiraModule = require('./build/moira.js');
-    this.module = await createMoiraModule();
-    this.cpu = new this.module.MoiraCPU(this.memorySize);
+    this.module = await loadMoiraModule(this.backend);
+    if (this.host) {
+      this.contextId = this.host.createContext(this.memorySize, PROFILE_IDS[this.profile]);
+      this.cpu = this.host.getContext(this.contextId);
+    } else {
+      this.cpu = new this.module.MoiraCPU(this.memorySize, PROFILE_IDS[this.profile]);
+    }
+    this.cpu.setBatchedTraps(true);
     this.cpu.resetCPU();
+    this.setJitThreshold(jitThreshold(this.backend));
+  }
+
+  getProfile(): MoiraProfile {
+    return this.profile;
+  }
+
+  /**
+   * Move the door to a CPU of another profile. It continues where it
+   * stopped, with the same guest RAM, registers and cycle count. Not
+   * possible while the door runs on its own thread (pthreads build).
+   */
+  setProfile(profile: MoiraProfile): void {
+    if (!this.cpu || !this.module) throw new Error('Emulator not initialized');
+    if (profile === this.profile) return;
+    if (this.host) {
+      this.host.setProfile(this.contextId, PROFILE_IDS[profile]);
+      this.cpu = this.host.getContext(this.contextId);
+    } else {
+      const cpu = new this.module.MoiraCPU(this.memorySize, PROFILE_IDS[profile]);
+      cpu.takeOver(this.cpu);
+      this.cpu.delete();
+      this.cpu = cpu;
+    }
+    this.profile = profile;
+    this.ram = null; // The views point into the old CPU
+  }
+
+  /**
+   * Capture the complete machine state: registers, prefetch queue, clock,
+   * guest RAM, page types, heap and debugger. Reuses the given snapshot if
+   * there is one. The snapshot belongs to the caller (delete() it when done)
+   * and can be restored into any emulator of the same module and RAM size,
+   * on either profile. The console is not part of it.
+   */
+  saveSnapshot(snapshot?: DoorSnapshot): DoorSnapshot {
+    if (!this.cpu || !this.module) throw new Error('Emulator not initialized');
+    const image = snapshot ?? new this.module.DoorSnapshot();
+    this.cpu.saveSnapshot(image);
+    return image;
+  }
+
+  /**
+   * Continue from a snapshot. Returns false, leaving the emulator as it
+   * was, if the snapshot is damaged or was taken with another RAM size.
+   */
+  restoreSnapshot(snapshot: DoorSnapshot): boolean {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.restoreSnapshot(snapshot);
+  }
+
+  /**
+   * Copy a snapshot out of module memory (e.g. to store it in a file)
+   */
+  exportSnapshot(snapshot: DoorSnapshot): Uint8Array {
+    if (!this.module) throw new Error('Emulator not initialized');
+    return memoryView(this.module, Uint8Array, snapshot.getPointer(), snapshot.getSize()).slice();
+  }
+
+  /**
+   * Create a snapshot from bytes returned by exportSnapshot
+   */
+  importSnapshot(bytes: Uint8Array): DoorSnapshot {
+    if (!this.module) throw new Error('Emulator not initialized');
+    const snapshot = new this.module.DoorSnapshot();
+    snapshot.resize(bytes.length);
+    memoryView(this.module, Uint8Array, snapshot.getPointer(), bytes.length).set(bytes);
+    return snapshot;
+  }
+
+  /**
+   * Freeze the door into an image that other emulators fork from. Reuses
+   * the given image if there is one; it belongs to the caller (delete() it
+   * when done, running forks keep what they need).
+   */
+  freeze(image?: DoorImage): DoorImage {
+    if (!this.cpu || !this.module) throw new Error('Emulator not initialized');
+    const frozen = image ?? new this.module.DoorImage();
+    this.cpu.freeze(frozen);
+    return frozen;
+  }
+
+  /**
+   * Continue from an image like restoreSnapshot, sharing its guest RAM
+   * pages until the door (or the host) writes to them. Returns false,
+   * leaving the emulator as it was, if the image is of another RAM size.
+   */
+  fork(image: DoorImage): boolean {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.fork(image);
+  }
+
+  /**
+   * Guest RAM pages still shared with the image the emulator was forked from
+   */
+  getSharedPageCount(): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.getSharedPageCount();
+  }
+
+  /**
+   * Guest RAM pages the door has its own copy of. Pages nobody has written
+   * to, or that are still shared with an image, cost no memory.
+   */
+  getCommittedPageCount(): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.getCommittedPageCount();
+  }
+
+  /**
+   * Executions of a loop start before it is compiled to WebAssembly (0
+   * disables the JIT)
+   */
+  setJitThreshold(threshold: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.jit = threshold ? this.jit ?? new MoiraJit() : null;
+    this.cpu.setJitThreshold(threshold);
   }
 
   loadProgram(binary: Uint8Array, address: number = 0x1000): void {
+    this.writeMemoryBlock(address, binary);
+  }
+
+  /**
+   * Load an AmigaDOS executable with its segments from the given base
+   * address. Executables are parsed and relocated natively once per file
+   * contents and base; later loads copy the relocated image into guest RAM
+   * in one go. Throws if the file is damaged or does not fit.
+   */
+  loadExecutable(file: Uint8Array, base: number = 0x1000): LoadedExecutable {
     if (!this.cpu || !this.module) throw new Error('Emulator not initialized');
+    const cache = this.getHunkCache();
+
+    memoryView(this.module, Uint8Array, cache.getFileBuffer(file.length), file.length).set(file);
+    const parsed = cache.getParseCount();
+    const id = cache.load(file.length, base);
+    if (id < 0) throw new Error('Not a loadable AmigaDOS executable');
+    if (!this.cpu.loadHunks(cache, id)) throw new Error('Executable does not fit into guest RAM');
+
+    const segments: LoadedExecutable['segments'] = [];
+    for (let i = 0; i < cache.getSegmentCount(id); i++) {
+      segments.push({
+        type: SEGMENT_TYPES[cache.getSegmentType(id, i)],
+        address: cache.getSegmentAddress(id, i),
+        size: cache.getSegmentSize(id, i)
+      });
+    }
+    return { entryPoint: cache.getEntryPoint(id), end: cache.getEnd(id), segments, cached: cache.getParseCount() === parsed };
+  }
+
+  /**
+   * Set how many executable images the hunk cache of this emulator's module
+   * keeps (16 by default). The least recently loaded ones are evicted.
+   */
+  setHunkCacheCapacity(count: number): void {
+    if (!this.module) throw new Error('Emulator not initialized');
+    this.getHunkCache().setCapacity(count);
+  }
 
-    // Convert Uint8Array to Emscripten vector
-    const vec = new (this.module as any).VectorUint8();
-    for (let i = 0; i < binary.length; i++) {
-      vec.push_back(binary[i]);
+  private getHunkCache(): HunkCache {
+    let cache = hunkCaches.get(this.module!);
+    if (!cache) {
+      cache = new this.module!.HunkCache();
+      hunkCaches.set(this.module!, cache);
     }
+    return cache;
+  }
+
+  /**
+   * Create the views on CPU memory, or recreate them after the WASM heap
+   * has grown (growing detaches the old ArrayBuffer)
+   */
+  private updateViews(): void {
+    if (!this.cpu || !this.module) throw new Error('Emulator not initialized');
+    const buffer = memoryBuffer(this.module);
+    if (this.ram && this.viewBuffer === buffer) return;
+
+    const cpu = this.cpu;
+    this.ram = memoryView(this.module, Uint8Array, cpu.getMemoryPointer(), cpu.getMemorySize());
+    this.registers = memoryView(this.module, Uint32Array, cpu.getRegisterFilePointer(), REGISTER_FILE_WORDS);
+    this.eventRecord = memoryView(this.module, Uint32Array, cpu.getEventRecordPointer(), EVENT_RECORD_WORDS);
+    this.pageTypes = memoryView(this.module, Uint8Array, cpu.getPageTypesPointer(), PAGE_COUNT);
+    this.pageBackings = memoryView(this.module, Uint8Array, cpu.getPageBackingPointer(), PAGE_COUNT);
+    this.consoleBuffer = memoryView(this.module, Uint8Array, cpu.getConsoleBufferPointer(), CONSOLE_BUFFER_SIZE);
+    this.viewBuffer = buffer;
+  }
 
-    this.cpu.loadProgram(vec, address);
-    vec.delete(); // Clean up the temporary vector
+  /**
+   * Direct view of guest RAM. Reads and writes through it never cross the
+   * JS/module boundary. Code must be written with the write* methods, which
+   * keep the CPU's block cache up to date. Every page is committed first,
+   * so prefer the read* and write* methods: reads commit nothing, writes
+   * only the pages they touch.
+   */
+  getMemoryView(): Uint8Array {
+    const ram = this.getRam();
+    this.willAccess(0, ram.length);
+    return ram;
   }
 
+  /**
+   * Code reader for the JIT. Reads pages in place like the read* methods,
+   * so hot loops in shared code pages stay shared.
+   */
+  private readCode(address: number): number {
+    const ram = this.getRam();
+    if (address + 2 > ram.length) return 0x4AFC; // ILLEGAL
+    const bytes = this.isCommitted(address, 2) ? ram.subarray(address, address + 2) : this.readPages(address, 2);
+    return (bytes[0] << 8) | bytes[1];
+  }
+
+  /**
+   * View of guest RAM for the read* and write* methods, which read pages
+   * in place or call willAccess on the range they write
+   */
+  private getRam(): Uint8Array {
+    this.updateViews();
+    return this.ram!;
+  }
+
+  /**
+   * Register file shared with the CPU, indexed by CPURegister. The CPU
+   * publishes it after every slice, library call and reset; writes are
+   * picked up before the CPU runs again.
+   */
+  private getRegisterFile(): Uint32Array {
+    this.updateViews();
+    return this.registers!;
+  }
+
+  /**
+   * Event record shared with the CPU (outcome of the last slice)
+   */
+  private getEventRecord(): Uint32Array {
+    this.updateViews();
+    return this.eventRecord!;
+  }
+
+  /**
+   * Run the CPU for the given number of cycles. Library calls stop the CPU;
+   * they are serviced here, outside the interpreter, and execution resumes
+   * until the budget is used up.
+   */
   execute(cycles: number = 1000): number {
     if (!this.cpu) throw new Error('Emulator not initialized');
-    return this.cpu.executeCycles(cycles);
+    return this.runUntilEvent(cycles).cycles;
+  }
+
+  /**
+   * Run the CPU until something needs the caller (exit, STOP, halt, illegal
+   * instruction, fault) or maxCycles have been executed. Library calls are
+   * serviced here and do not end the run.
+   */
+  runUntilEvent(maxCycles: number): RunResult {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    let cycles = 0;
+    let idle = 0;
+    for (;;) {
+      const event: ExecEvent = this.cpu.executeUntilEvent(maxCycles - cycles);
+      this.pumpConsole();
+      const record = this.getEventRecord();
+      cycles += record[EVENT_CYCLES];
+      idle += record[EVENT_IDLE];
+      if (event !== ExecEvent.TRAP && event !== ExecEvent.HOT && event !== ExecEvent.JIT) {
+        return { event, cycles, pc: record[EVENT_PC], idle };
+      }
+      cycles += this.serviceEvent(event, record, maxCycles - cycles);
+      this.cpu.completeTrap();
+      if (cycles >= maxCycles) {
+        return { event: ExecEvent.BUDGET, cycles, pc: this.getRegister(CPURegister.PC), idle };
+      }
+    }
+  }
+
+  /**
+   * Run the trap handler for a library call reported by the CPU. The caller
+   * resumes the CPU afterwards (completeTrap, or DoorHost.resume).
+   */
+  serviceTrap(offset: number): void {
+    if (this.trapHandler) this.trapHandler(offset);
+  }
+
+  /**
+   * Service an event that stops the CPU without ending the run: a library
+   * call, or a hot or compiled loop for the JIT. Returns the cycles executed
+   * here (compiled loops run for at most about budget cycles); they reach
+   * the CPU clock when the caller resumes the CPU.
+   */
+  serviceEvent(event: ExecEvent, record: Uint32Array, budget: number): number {
+    if (event === ExecEvent.TRAP) {
+      this.serviceTrap(record[EVENT_OFFSET] | 0);
+      return 0;
+    }
+    const pc = record[EVENT_PC];
+    if (!this.jit) return 0;
+
+    if (event === ExecEvent.HOT) {
+      this.cpu!.setJitEntry(pc, this.jit.compile(address => this.readCode(address), pc));
+      return 0;
+    }
+
+    // Trace mode needs the interpreter
+    const registers = this.getRegisterFile();
+    const cycles = registers[CPURegister.SR] & 0x8000 ? -1 :
+      this.jit.run(address => this.readCode(address), pc, registers, budget);
+    if (cycles < 0) {
+      this.cpu!.setJitEntry(pc, false);
+      return 0;
+    }
+    registers[REGISTER_CYCLES] = cycles;
+    registers[REGISTER_DIRTY] = 1;
+    return cycles;
+  }
+
+  /**
+   * The CPU binding (used by DoorScheduler to run the CPU on its own thread)
+   */
+  getCPU(): MoiraCPU {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu;
+  }
+
+  /**
+   * Context id inside the door host, or -1 for a standalone CPU
+   */
+  getContextId(): number {
+    return this.contextId;
   }
 
   reset(): void {
@@ -65,34 +659,295 @@ export class MoiraEmulator {
   }
 
   getRegister(reg: CPURegister): number {
-    if (!this.cpu) throw new Error('Emulator not initialized');
-    return this.cpu.getRegister(reg);
+    return this.getRegisterFile()[reg];
   }
 
   setRegister(reg: CPURegister, value: number): void {
-    if (!this.cpu) throw new Error('Emulator not initialized');
-    this.cpu.setRegister(reg, value);
+    const registers = this.getRegisterFile();
+    registers[reg] = value;
+    registers[REGISTER_DIRTY] = 1;
   }
 
   readMemory(address: number): number {
-    if (!this.cpu) throw new Error('Emulator not initialized');
-    return this.cpu.getMemoryByte(address);
+    const ram = this.getRam();
+    if (address >= ram.length) return 0;
+    return this.isCommitted(address, 1) ? ram[address] : this.readPages(address, 1)[0];
   }
 
   writeMemory(address: number, value: number): void {
+    const ram = this.getRam();
+    if (address >= ram.length) return;
+    this.willAccess(address, 1);
+    this.willWrite(address, 1);
+    ram[address] = value;
+  }
+
+  /**
+   * Copy a block out of guest RAM (clipped to the end of RAM)
+   */
+  readMemoryBlock(address: number, length: number): Uint8Array {
+    const ram = this.getRam();
+    if (!this.isCommitted(address, length)) return this.readPages(address, length);
+    return ram.slice(Math.min(address, ram.length), Math.min(address + length, ram.length));
+  }
+
+  /**
+   * Copy a block into guest RAM (clipped to the end of RAM)
+   */
+  writeMemoryBlock(address: number, data: Uint8Array): void {
+    const ram = this.getRam();
+    if (address >= ram.length) return;
+    const length = Math.min(data.length, ram.length - address);
+    this.willAccess(address, length);
+    this.cpu!.invalidateCode(address, length);
+    ram.set(length < data.length ? data.subarray(0, length) : data, address);
+  }
+
+  fillMemory(address: number, value: number, length: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.cpu.fillMemory(address, value, length);
+  }
+
+  copyMemory(dst: number, src: number, length: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.cpu.copyMemory(dst, src, length);
+  }
+
+  /**
+   * Make a range of guest RAM read-only for the CPU (whole 4 KB pages).
+   * Host writes through the memory view are not affected.
+   */
+  protectMemory(address: number, length: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.cpu.protectMemory(address, length);
+  }
+
+  /**
+   * Address of the last bus error (access to an unmapped page) since reset,
+   * or 0 if there was none
+   */
+  getBusFault(): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.getBusFault();
+  }
+
+  /**
+   * Set up the exec.library heap over [start, end) of guest RAM. Once it is
+   * set up, the CPU services AllocMem, FreeMem, AllocVec, FreeVec and
+   * AvailMem calls through ExecBase itself; they never reach the trap
+   * handler.
+   */
+  initHeap(start: number, end: number): void {
     if (!this.cpu) throw new Error('Emulator not initialized');
-    this.cpu.setMemoryByte(address, value);
+    this.cpu.initHeap(start, end);
   }
 
+  /**
+   * Allocate a block on the heap (requirements: MEMF_* flags). Returns 0 if
+   * there is no block large enough.
+   */
+  allocMem(size: number, requirements: number = 0): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.allocMem(size, requirements);
+  }
+
+  freeMem(address: number, size: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.cpu.freeMem(address, size);
+  }
+
+  /**
+   * Allocate a block that remembers its size (freed with freeVec)
+   */
+  allocVec(size: number, requirements: number = 0): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.allocVec(size, requirements);
+  }
+
+  freeVec(address: number): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    this.cpu.freeVec(address);
+  }
+
+  /**
+   * Free heap memory, the largest free block (MEMF_LARGEST) or the heap
+   * size (MEMF_TOTAL)
+   */
+  availMem(requirements: number = 0): number {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.cpu.availMem(requirements) >>> 0;
+  }
+
+  /**
+   * Receive the console output of the door (Latin-1). The CPU services
+   * dos.library Read and Write on the standard handles and the AEDoor
+   * console functions itself, through rings in the module; pumpConsole
+   * hands the collected output to the handler.
+   */
+  setConsoleOutput(handler: ((data: string) => void) | null): void {
+    this.consoleOutput = handler;
+  }
+
+  /**
+   * Queue input for the door (Latin-1)
+   */
+  queueConsoleInput(data: string): void {
+    this.consoleInput += data;
+    this.pumpConsole();
+  }
+
+  /**
+   * Move queued input into the input ring and pass the door's output to the
+   * console output handler. Runs after every slice; library calls serviced
+   * here run it first, so output stays in order.
+   */
+  pumpConsole(): void {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    if (this.consoleInput.length > 0) {
+      this.updateViews();
+      const input = Buffer.from(this.consoleInput.slice(0, CONSOLE_BUFFER_SIZE), 'latin1');
+      this.consoleBuffer!.set(input);
+      this.consoleInput = this.consoleInput.slice(this.cpu.writeInput(input.length));
+    }
+    for (let length; (length = this.cpu.readOutput()) > 0;) {
+      this.updateViews();
+      const output = Buffer.from(this.consoleBuffer!.subarray(0, length)).toString('latin1');
+      if (this.consoleOutput) this.consoleOutput(output);
+    }
+  }
+
+  /**
+   * Take up to maxLength bytes of console input, for library calls the CPU
+   * left to the trap handler
+   */
+  readConsoleInput(maxLength: number): Uint8Array {
+    this.pumpConsole();
+    const length = this.cpu!.readInput(Math.min(maxLength, CONSOLE_BUFFER_SIZE));
+    this.updateViews();
+    return this.consoleBuffer!.slice(0, length);
+  }
+
+  /**
+   * Whether the door has console input waiting
+   */
+  hasConsoleInput(): boolean {
+    if (!this.cpu) throw new Error('Emulator not initialized');
+    return this.consoleInput.length > 0 || this.cpu.pendingInput() > 0;
+  }
+
+  /**
+   * Read a null-terminated Latin-1 string from guest RAM
+   */
+  readString(address: number, maxLength: number = 256): string {
+    const ram = this.getRam();
+    const bytes = this.isCommitted(address, maxLength)
+      ? ram.subarray(Math.min(address, ram.length), Math.min(address + maxLength, ram.length))
+      : this.readPages(address, maxLength);
+    const end = bytes.indexOf(0);
+    return Buffer.from(bytes.buffer, bytes.byteOffset, end < 0 ? bytes.length : end).toString('latin1');
+  }
+
+  /**
+   * Read a big-endian 32-bit value from guest RAM
+   */
+  readLong(address: number): number {
+    const ram = this.getRam();
+    if (address + 4 > ram.length) return 0;
+    const bytes = this.isCommitted(address, 4) ? ram.subarray(address, address + 4) : this.readPages(address, 4);
+    return ((bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3]) >>> 0;
+  }
+
+  /**
+   * Write a big-endian 32-bit value to guest RAM
+   */
+  writeLong(address: number, value: number): void {
+    const ram = this.getRam();
+    if (address + 4 > ram.length) return;
+    this.willAccess(address, 4);
+    this.willWrite(address, 4);
+    ram[address] = (value >>> 24) & 0xFF;
+    ram[address + 1] = (value >>> 16) & 0xFF;
+    ram[address + 2] = (value >>> 8) & 0xFF;
+    ram[address + 3] = value & 0xFF;
+  }
+
+  /**
+   * Check if every page of a range has its own copy in the RAM view. Ranges
+   * are clipped to guest RAM.
+   */
+  private isCommitted(address: number, length: number): boolean {
+    const backings = this.pageBackings!;
+    const end = Math.min(address + length, this.ram!.length);
+    for (let page = address >>> PAGE_BITS; address < end && page <= (end - 1) >>> PAGE_BITS; page++) {
+      if (backings[page] !== PAGE_OWN) return false;
+    }
+    return true;
+  }
+
+  /**
+   * Let the CPU commit pages that are untouched or shared with other doors
+   * before the host writes them through the RAM view
+   */
+  private willAccess(address: number, length: number): void {
+    if (!this.isCommitted(address, length)) {
+      this.cpu!.commitMemory(address, Math.min(address + length, this.ram!.length) - address);
+    }
+  }
+
+  /**
+   * Copy a range out of guest RAM page by page, reading untouched and shared
+   * pages where the CPU reads them, so they stay uncommitted
+   */
+  private readPages(address: number, length: number): Uint8Array {
+    const ram = this.ram!;
+    const end = Math.min(address + length, ram.length);
+    const bytes = new Uint8Array(Math.max(end - address, 0));
+    for (let pos = address; pos < end;) {
+      const chunk = Math.min(end, ((pos >>> PAGE_BITS) + 1) << PAGE_BITS) - pos;
+      const source = this.pageBackings![pos >>> PAGE_BITS] === PAGE_OWN
+        ? ram.subarray(pos, pos + chunk)
+        : memoryView(this.module!, Uint8Array, this.cpu!.getReadPointer(pos), chunk);
+      bytes.set(source, pos - address);
+      pos += chunk;
+    }
+    return bytes;
+  }
+
+  /**
+   * Let the CPU drop cached code before a small write to guest RAM. Only
+   * pages the CPU has marked as code pages need the call.
+   */
+  private willWrite(address: number, length: number): void {
+    const pages = this.pageTypes!;
+    if (pages[address >>> PAGE_BITS] === PAGE_CODE || pages[(address + length - 1) >>> PAGE_BITS] === PAGE_CODE) {
+      this.cpu!.invalidateCode(address, length);
+    }
+  }
+
+  /**
+   * Set the handler for library calls. It runs between instructions, after
+   * the JSR into the library vector, and may read and write registers.
+   */
   setTrapHandler(handler: (offset: number) => void): void {
     if (!this.cpu) throw new Error('Emulator not initialized');
     this.trapHandler = handler;
-    this.cpu.setTrapHandler(handler);
   }
 
   cleanup(): void {
+    this.ram = null;
+    this.registers = null;
+    this.eventRecord = null;
+    this.pageTypes = null;
+    this.pageBackings = null;
+    this.consoleBuffer = null;
+    this.viewBuffer = null;
     if (this.cpu) {
-      this.cpu.delete();
+      if (this.host) {
+        this.host.destroyContext(this.contextId);
+        this.contextId = -1;
+      } else {
+        this.cpu.delete();
+      }
       this.cpu = null;
     }
   }
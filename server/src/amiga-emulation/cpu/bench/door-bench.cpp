@@ -0,0 +1,131 @@
+// Door hot loop benchmark for the MoiraCPU wrapper class.
+//
+// Runs a small door-like program (string copy, checksum loop, library call)
+// or an ALU-heavy loop (arithmetic and compares on a buffer) in slices like
+// the door host, and reports emulated cycles per second. Built by
+// build-bench.sh with the virtual memory interface, with static dispatch,
+// with static dispatch plus the block cache, with lazy flags on top, and
+// without C++ exceptions. With DOOR_BENCH_PROFILE set, both door profiles
+// are linked and the CPU is created with that profile.
+//
+// Usage: door-bench [cycles] [door|alu]
+
+#ifdef DOOR_BENCH_PROFILE
+#include "../door-cpu.h"
+#else
+#include "../moira-cpu.h"
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+static constexpr uint32_t CODE = 0x1000;
+static constexpr uint32_t MESSAGE = 0x1100;
+static constexpr uint32_t BUFFER = 0x3000;
+static constexpr uint32_t STACK = 0x8000;
+static constexpr uint32_t LIBRARY_BASE = 0xFF8000;
+
+static void poke16(DoorCPU &cpu, uint32_t addr, uint16_t value) {
+    cpu.setMemoryByte(addr, (uint8_t)(value >> 8));
+    cpu.setMemoryByte(addr + 1, (uint8_t)value);
+}
+
+static void poke32(DoorCPU &cpu, uint32_t addr, uint32_t value) {
+    poke16(cpu, addr, (uint16_t)(value >> 16));
+    poke16(cpu, addr + 2, (uint16_t)value);
+}
+
+static void load(DoorCPU &cpu, const uint16_t *program, size_t words) {
+    // Reset vectors
+    poke32(cpu, 0, STACK);
+    poke32(cpu, 4, CODE);
+
+    uint32_t pc = CODE;
+    for (size_t i = 0; i < words; i++) {
+        poke16(cpu, pc, program[i]);
+        pc += 2;
+    }
+}
+
+static void setupDoor(DoorCPU &cpu) {
+    const uint16_t program[] = {
+        0x41FA, (uint16_t)(MESSAGE - (CODE + 2)), // start: lea     message(pc),a0
+        0x43F8, (uint16_t)BUFFER,                 //        lea     buffer.w,a1
+        0x12D8,                              // copy:  move.b  (a0)+,(a1)+
+        0x66FC,                              //        bne.s   copy
+        0x721F,                              //        moveq   #31,d1
+        0xD081,                              // sum:   add.l   d1,d0
+        0xE698,                              //        ror.l   #3,d0
+        0x51C9, 0xFFFA,                      //        dbra    d1,sum
+        0x12C0,                              //        move.b  d0,(a1)+
+        0x4EAE, 0xFFD0,                      //        jsr     -48(a6)
+        0x60E2,                              //        bra.s   start
+    };
+    load(cpu, program, sizeof(program) / sizeof(program[0]));
+
+    const char *message = "\x1b[1;33mWelcome to the AmiExpress door!\x1b[0m\r\n";
+    for (uint32_t i = 0; message[i]; i++) cpu.setMemoryByte(MESSAGE + i, (uint8_t)message[i]);
+
+    cpu.resetCPU();
+    cpu.setRegister(14, LIBRARY_BASE);
+}
+
+static void setupAlu(DoorCPU &cpu) {
+    const uint16_t program[] = {
+        0x41F8, (uint16_t)BUFFER,                 // start: lea     buffer.w,a0
+        0x3E3C, 0x00FF,                      //        move.w  #255,d7
+        0x1218,                              // loop:  move.b  (a0)+,d1
+        0xD001,                              //        add.b   d1,d0
+        0xB101,                              //        eor.b   d0,d1
+        0x9641,                              //        sub.w   d1,d3
+        0xB843,                              //        cmp.w   d3,d4
+        0x6502,                              //        bcs.s   skip
+        0x5245,                              //        addq.w  #1,d5
+        0xC67C, 0x0FFF,                      // skip:  and.w   #$0FFF,d3
+        0x8841,                              //        or.w    d1,d4
+        0x0C00, 0x0040,                      //        cmpi.b  #$40,d0
+        0x6202,                              //        bhi.s   next
+        0x5386,                              //        subq.l  #1,d6
+        0x51CF, 0xFFE2,                      // next:  dbra    d7,loop
+        0x60D6,                              //        bra.s   start
+    };
+    load(cpu, program, sizeof(program) / sizeof(program[0]));
+
+    for (uint32_t i = 0; i < 256; i++) cpu.setMemoryByte(BUFFER + i, (uint8_t)(i * 37 + 11));
+
+    cpu.resetCPU();
+}
+
+#define STRING(x) #x
+#define NAME(x) STRING(x)
+
+int main(int argc, char *argv[]) {
+    long cycles = argc > 1 ? std::atol(argv[1]) : 500000000;
+    bool alu = argc > 2 && std::strcmp(argv[2], "alu") == 0;
+    long traps = 0;
+
+#ifdef DOOR_BENCH_PROFILE
+    std::unique_ptr<DoorCPU> door(DoorCPU::create(1024 * 1024, DoorProfile::DOOR_BENCH_PROFILE));
+    const char *variant = NAME(DOOR_BENCH_PROFILE);
+#else
+    auto door = std::make_unique<MoiraCPU>(1024 * 1024);
+    const char *variant = !MOIRA_THROW_FAULTS ? "nothrow" : MOIRA_LAZY_FLAGS ? "lazy" :
+        MOIRA_BLOCK_CACHE ? "blocks" : MOIRA_VIRTUAL_API ? "virtual" : "static";
+#endif
+    DoorCPU &cpu = *door;
+    alu ? setupAlu(cpu) : setupDoor(cpu);
+
+    // Library calls end a slice like in the door host and are resumed right away
+    cpu.setBatchedTraps(true);
+    auto start = std::chrono::steady_clock::now();
+    while (cpu.getClock() < cycles) {
+        if (cpu.executeUntilEvent(100000) == ExecEvent::TRAP) traps++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-8s %-5s %8.2f M cycles/s  (%ld library calls, %.2f s)\n",
+                variant, alu ? "alu" : "door", cpu.getClock() / elapsed / 1e6, traps, elapsed);
+    return 0;
+}
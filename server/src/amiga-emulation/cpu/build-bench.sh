@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Builds and runs the native door hot loop benchmark (bench/door-bench.cpp)
+# for these variants of MoiraCPU:
+#   virtual  - MOIRA_VIRTUAL_API=true (default Moira configuration)
+#   static   - MOIRA_VIRTUAL_API=false, client API inlined via LTO
+#   blocks   - static with MOIRA_BLOCK_CACHE=true
+#   lazy     - blocks with MOIRA_LAZY_FLAGS=true
+#   nothrow  - lazy with MOIRA_THROW_FAULTS=false, built with -fno-exceptions
+#   fast     - both door profiles linked like the WASM and native builds,
+#              running DoorProfile::FAST
+#   accurate - the same, running DoorProfile::ACCURATE
+#
+# Each variant runs the door program and the ALU-heavy loop.
+#
+# Usage: ./build-bench.sh [cycles]
+
+CXX="${CXX:-c++}"
+
+# Source directory
+SRC_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+MOIRA_DIR="$SRC_DIR/moira-source/Moira"
+
+# Output directory
+OUT_DIR="$SRC_DIR/build/bench"
+mkdir -p "$OUT_DIR"
+
+VARIANTS=(virtual static blocks lazy nothrow fast accurate)
+
+# Settings of the WASM and native builds
+BUILD_FLAGS=(-DMOIRA_VIRTUAL_API=false -DMOIRA_BLOCK_CACHE=true -DMOIRA_LAZY_FLAGS=true
+             -DMOIRA_THROW_FAULTS=false -fno-exceptions)
+
+for VARIANT in "${VARIANTS[@]}"; do
+    SOURCES=("$SRC_DIR/moira-cpu.cpp" "$MOIRA_DIR/Moira.cpp" "$MOIRA_DIR/MoiraDebugger.cpp")
+    case "$VARIANT" in
+        virtual) VARIANT_FLAGS=() ;;
+        static)  VARIANT_FLAGS=(-DMOIRA_VIRTUAL_API=false) ;;
+        blocks)  VARIANT_FLAGS=(-DMOIRA_VIRTUAL_API=false -DMOIRA_BLOCK_CACHE=true) ;;
+        lazy)    VARIANT_FLAGS=(-DMOIRA_VIRTUAL_API=false -DMOIRA_BLOCK_CACHE=true -DMOIRA_LAZY_FLAGS=true) ;;
+        nothrow) VARIANT_FLAGS=("${BUILD_FLAGS[@]}") ;;
+        fast|accurate)
+            VARIANT_FLAGS=("${BUILD_FLAGS[@]}" -DDOOR_BENCH_PROFILE="${VARIANT^^}")
+            SOURCES=("$SRC_DIR/moira-fast.cpp" "$SRC_DIR/moira-accurate.cpp")
+            ;;
+    esac
+
+    echo "Building door-bench ($VARIANT)..."
+    "$CXX" \
+        -std=c++20 \
+        -O3 \
+        -flto \
+        -DNDEBUG \
+        "${VARIANT_FLAGS[@]}" \
+        -I"$MOIRA_DIR" \
+        "$SRC_DIR/bench/door-bench.cpp" \
+        "${SOURCES[@]}" \
+        -o "$OUT_DIR/door-bench-$VARIANT" || { echo "✗ Build failed!"; exit 1; }
+done
+
+for PROGRAM in door alu; do
+    for VARIANT in "${VARIANTS[@]}"; do
+        "$OUT_DIR/door-bench-$VARIANT" "${1:-500000000}" "$PROGRAM"
+    done
+done
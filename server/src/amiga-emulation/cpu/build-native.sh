@@ -0,0 +1,84 @@
+#!/bin/bash
+
+# Builds the door CPU as a Node native addon (build/moira-native.node).
+# MoiraEmulator prefers it over the WASM builds when present. The jump tables
+# are generated first (build/MoiraTables.h).
+#
+# Usage: ./build-native.sh
+#   CXX=...          compiler (default: c++)
+#   MARCH=...        target CPU for -march (default: native)
+#   NODE_INCLUDE=... Node headers (default: next to the running node binary)
+
+CXX="${CXX:-c++}"
+MARCH="${MARCH:-native}"
+
+if ! command -v node &> /dev/null; then
+    echo "Error: node not found."
+    exit 1
+fi
+
+# Source directory
+SRC_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+MOIRA_DIR="$SRC_DIR/moira-source/Moira"
+NODE_INCLUDE="${NODE_INCLUDE:-$(dirname "$(dirname "$(command -v node)")")/include/node}"
+
+if [ ! -f "$NODE_INCLUDE/node_api.h" ]; then
+    echo "Error: node_api.h not found in $NODE_INCLUDE (set NODE_INCLUDE)."
+    exit 1
+fi
+
+# Output directory
+OUT_DIR="$SRC_DIR/build"
+mkdir -p "$OUT_DIR"
+
+# Node resolves the N-API symbols when it loads the addon
+case "$(uname -s)" in
+    Darwin) LINK_FLAGS=(-undefined dynamic_lookup) ;;
+    *)      LINK_FLAGS=() ;;
+esac
+
+echo "Building Moira native addon (-march=$MARCH)..."
+echo "Source: $MOIRA_DIR"
+echo "Output: $OUT_DIR"
+
+# Settings shared by both door profiles
+CORE_FLAGS=(-fno-exceptions -DMOIRA_VIRTUAL_API=false -DMOIRA_SKIP_IDLE_LOOPS=true
+            -DMOIRA_BLOCK_CACHE=true -DMOIRA_LAZY_FLAGS=true -DMOIRA_THROW_FAULTS=false)
+
+# Generate the jump tables of the 68000 (see moira-tables.cpp)
+echo "Generating jump tables..."
+"$CXX" -std=c++20 -O0 "${CORE_FLAGS[@]}" -I"$MOIRA_DIR" \
+    "$SRC_DIR/moira-tables.cpp" -o "$OUT_DIR/moira-tables" &&
+    "$OUT_DIR/moira-tables" > "$OUT_DIR/MoiraTables.h" ||
+    { echo "✗ Generating the jump tables failed!"; exit 1; }
+
+# moira-fast.cpp and moira-accurate.cpp compile the core once per door
+# profile, adding the settings of the profile to these
+"$CXX" \
+    -std=c++20 \
+    -O3 \
+    -march="$MARCH" \
+    -flto=auto \
+    -fPIC \
+    -shared \
+    -fvisibility=hidden \
+    -DNDEBUG \
+    "${CORE_FLAGS[@]}" \
+    -DMOIRA_STATIC_TABLES=true \
+    -I"$MOIRA_DIR" \
+    -I"$OUT_DIR" \
+    -I"$NODE_INCLUDE" \
+    "$SRC_DIR/moira-napi.cpp" \
+    "$SRC_DIR/moira-fast.cpp" \
+    "$SRC_DIR/moira-accurate.cpp" \
+    "${LINK_FLAGS[@]}" \
+    -o "$OUT_DIR/moira-native.node"
+
+if [ $? -eq 0 ]; then
+    echo "✓ Build successful!"
+    echo "Output files:"
+    echo "  - $OUT_DIR/moira-native.node"
+else
+    echo "✗ Build failed!"
+    exit 1
+fi
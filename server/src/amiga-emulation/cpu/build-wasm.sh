@@ -14,32 +14,91 @@ MOIRA_DIR="$SRC_DIR/moira-source/Moira"
 OUT_DIR="$SRC_DIR/build"
 mkdir -p "$OUT_DIR"
 
-echo "Building Moira WASM..."
+# Build variant:
+#   virtual - memory interface through virtual calls (build/moira.js)
+#   static  - MOIRA_VIRTUAL_API=false, memory interface statically dispatched
+#             and inlined across translation units (build/moira-static.js)
+#   threads - static build with pthreads; every door CPU runs on its own
+#             thread and the heap is a SharedArrayBuffer (build/moira-threads.js)
+VARIANT="${1:-virtual}"
+case "$VARIANT" in
+    virtual)
+        OUT_NAME="moira"
+        VARIANT_FLAGS=()
+        ;;
+    static)
+        OUT_NAME="moira-static"
+        VARIANT_FLAGS=(-DMOIRA_VIRTUAL_API=false -flto)
+        ;;
+    threads)
+        OUT_NAME="moira-threads"
+        VARIANT_FLAGS=(-DMOIRA_VIRTUAL_API=false -flto -pthread
+                       -s PTHREAD_POOL_SIZE=16 -Wno-pthreads-mem-growth)
+        ;;
+    *)
+        echo "Usage: $0 [virtual|static|threads]"
+        exit 1
+        ;;
+esac
+
+# How the core signals bus and address errors:
+#   throw  - C++ exceptions (MOIRA_THROW_FAULTS=true), the default
+#   record - pending faults, built with -fno-exceptions
+#            (MOIRA_THROW_FAULTS=false)
+# Compare the .wasm size and bench-backends.ts with both before switching the
+# default; no gain from record has been measured on WASM yet.
+FAULTS="${FAULTS:-throw}"
+case "$FAULTS" in
+    throw)  FAULT_FLAGS=(-fexceptions -DMOIRA_THROW_FAULTS=true) ;;
+    record) FAULT_FLAGS=(-fno-exceptions -DMOIRA_THROW_FAULTS=false) ;;
+    *)
+        echo "Error: FAULTS must be throw or record."
+        exit 1
+        ;;
+esac
+
+echo "Building Moira WASM ($VARIANT, faults: $FAULTS)..."
 echo "Source: $MOIRA_DIR"
 echo "Output: $OUT_DIR"
 
-# Compile to WebAssembly
+# Generate the jump tables of the 68000 (see moira-tables.cpp). They hold
+# no addresses, so the generator runs on the host.
+echo "Generating jump tables..."
+"${CXX:-c++}" -std=c++20 -O0 -fno-exceptions -DMOIRA_THROW_FAULTS=false -I"$MOIRA_DIR" \
+    "$SRC_DIR/moira-tables.cpp" -o "$OUT_DIR/moira-tables" &&
+    "$OUT_DIR/moira-tables" > "$OUT_DIR/MoiraTables.h" ||
+    { echo "Error: generating the jump tables failed."; exit 1; }
+
+# Compile to WebAssembly. moira-fast.cpp and moira-accurate.cpp compile the
+# core once per door profile, adding the settings of the profile to these.
 emcc \
     -std=c++20 \
     -O3 \
+    "${FAULT_FLAGS[@]}" \
+    -DMOIRA_SKIP_IDLE_LOOPS=true \
+    -DMOIRA_BLOCK_CACHE=true \
+    -DMOIRA_LAZY_FLAGS=true \
+    -DMOIRA_STATIC_TABLES=true \
+    "${VARIANT_FLAGS[@]}" \
     -s WASM=1 \
     -s ALLOW_MEMORY_GROWTH=1 \
     -s MODULARIZE=1 \
     -s EXPORT_NAME='createMoiraModule' \
     -s EXPORTED_FUNCTIONS='["_malloc","_free"]' \
-    -s EXPORTED_RUNTIME_METHODS='["ccall","cwrap"]' \
+    -s EXPORTED_RUNTIME_METHODS='["ccall","cwrap","HEAPU8","HEAPU32"]' \
     --bind \
     -I"$MOIRA_DIR" \
+    -I"$OUT_DIR" \
     "$SRC_DIR/moira-wrapper.cpp" \
-    "$MOIRA_DIR/Moira.cpp" \
-    "$MOIRA_DIR/MoiraDebugger.cpp" \
-    -o "$OUT_DIR/moira.js"
+    "$SRC_DIR/moira-fast.cpp" \
+    "$SRC_DIR/moira-accurate.cpp" \
+    -o "$OUT_DIR/$OUT_NAME.js"
 
 if [ $? -eq 0 ]; then
     echo "✓ Build successful!"
     echo "Output files:"
-    echo "  - $OUT_DIR/moira.js"
-    echo "  - $OUT_DIR/moira.wasm"
+    echo "  - $OUT_DIR/$OUT_NAME.js"
+    echo "  - $OUT_DIR/$OUT_NAME.wasm ($(wc -c < "$OUT_DIR/$OUT_NAME.wasm") bytes)"
 else
     echo "✗ Build failed!"
     exit 1
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "spsc-ring.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Terminal of a door: the bytes it writes and the bytes it reads.
+//
+// The CPU services the console calls of the door (dos.library Read and
+// Write on the standard handles, AEDoor AEPuts, AEGets, AEPutCh, AEGetCh)
+// by moving bytes between guest RAM and the rings, without stopping for
+// the host. The host drains the output ring and refills the input ring
+// once per slice, through the staging buffer (JS wraps it in a view), so a
+// full ANSI screen crosses the JS boundary once instead of once per call.
+//
+// The CPU is the producer of the output ring and the consumer of the input
+// ring; the host is the other side of each. With the pthreads build they
+// run on different threads.
+class DoorConsole {
+public:
+    static constexpr size_t OUTPUT_SIZE = 64 * 1024;
+    static constexpr size_t INPUT_SIZE = 4 * 1024;
+    static constexpr size_t BUFFER_SIZE = OUTPUT_SIZE;
+
+    SpscRing<uint8_t, OUTPUT_SIZE> output;
+    SpscRing<uint8_t, INPUT_SIZE> input;
+
+    // Staging buffer of the host
+    uint8_t buffer[BUFFER_SIZE];
+
+    // Host side: moves the pending output into the staging buffer and
+    // returns its length
+    uint32_t readOutput() {
+        return (uint32_t)output.pop(buffer, BUFFER_SIZE);
+    }
+
+    // Host side: queues the first length bytes of the staging buffer as
+    // input and returns how many fit
+    uint32_t writeInput(uint32_t length) {
+        return (uint32_t)input.push(buffer, std::min<size_t>(length, BUFFER_SIZE));
+    }
+
+    // Host side, while the CPU waits for a library call: moves up to length
+    // bytes of input into the staging buffer and returns how many there were
+    uint32_t readInput(uint32_t length) {
+        return (uint32_t)input.pop(buffer, std::min<size_t>(length, BUFFER_SIZE));
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "door-console.h"
+#include "door-snapshot.h"
+#include "guest-heap.h"
+#include "hunk-image.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Register file shared with the host. The word order matches the register
+// numbers of getRegister/setRegister. The CPU publishes it when a slice ends,
+// on a library call and after reset. Host writes set the dirty word and are
+// loaded into the CPU before it runs again.
+struct RegisterFile {
+    uint32_t d[8];      // D0 - D7
+    uint32_t a[8];      // A0 - A7 (A7 is the active stack pointer)
+    uint32_t pc;
+    uint32_t sr;
+    uint32_t usp;
+    uint32_t isp;
+    uint32_t dirty;
+    uint32_t cycles;    // Cycles the host executed for the CPU (JIT), added to the clock
+};
+
+// Why executeUntilEvent returned
+enum class ExecEvent : uint32_t {
+    BUDGET,         // Cycle budget used up
+    TRAP,           // Library call (batched trap mode), waiting for the host
+    EXIT,           // Door returned to the exit address
+    STOP,           // STOP instruction
+    HALTED,         // CPU halted (double fault)
+    ILLEGAL,        // Illegal instruction or unimplemented Line A/F opcode
+    FAULT,          // Bus error or address error
+    IDLE,           // Parked in a branch to itself (cycles fast-forwarded)
+    HOT,            // Reached a hot address the JIT has not seen yet
+    JIT             // Reached a loop compiled by the JIT
+};
+
+// Outcome of the last slice. The host reads it through a view on the WASM
+// heap; a pending library call is serviced and resumed with completeTrap().
+struct EventRecord {
+    ExecEvent reason;
+    int32_t offset;     // TRAP: library offset (same encoding as the trap handler)
+    uint32_t pc;        // ILLEGAL, FAULT: address of the instruction; HOT, JIT: PC
+    uint32_t cycles;    // Cycles executed by the slice
+    uint32_t idle;      // Part of cycles skipped in idle loops
+};
+
+// Moira configuration a door CPU runs on. Every build links both cores
+// (moira-fast.cpp and moira-accurate.cpp), so the profile is picked per CPU
+// at runtime and can be switched while a door runs (see takeOver).
+enum class DoorProfile : uint32_t {
+    FAST,           // Production: no precise timing, address errors or disassembler
+    ACCURATE        // Debugging: precise timing, address errors, disassembler
+};
+
+// CPU state handed over between profiles. Guest RAM is copied separately.
+struct DoorState {
+    RegisterFile regs;
+    EventRecord event;
+    int64_t clock;
+    uint16_t ird;
+    uint16_t irc;
+    bool stopped;
+    bool halted;
+    bool batchedTraps;
+    uint32_t busFault;
+    uint32_t jitThreshold;
+};
+
+// Door CPU as seen by the host (the bindings, DoorHost and DoorThread).
+//
+// MoiraCPU implements it once per profile, each time on top of a core
+// compiled into a namespace of its own. The host calls in once per slice or
+// library call; everything below executeUntilEvent is statically dispatched
+// inside the core.
+class DoorCPU {
+public:
+    virtual ~DoorCPU() = default;
+
+    // Creates a CPU with the given profile
+    template <DoorProfile P> static DoorCPU *create(size_t memSize);
+    static DoorCPU *create(size_t memSize, DoorProfile profile);
+
+    virtual DoorProfile getProfile() = 0;
+
+    // Continues where another CPU (usually of the other profile) stopped:
+    // copies its guest RAM, page types, heap, registers, clock and pending
+    // event, and shares its console. Both CPUs must have the same RAM size.
+    // The block cache and the JIT entries start empty.
+    virtual void takeOver(DoorCPU *other) = 0;
+    virtual void saveState(DoorState &state) = 0;
+
+    // Machine image (see DoorSnapshot). A CPU restored from an image
+    // continues where the saved one was, on either profile. Restoring fails,
+    // without changing the CPU, if the image is damaged, of another version
+    // or taken with another RAM size.
+    virtual void saveSnapshot(DoorSnapshot *snapshot) = 0;
+    virtual bool restoreSnapshot(DoorSnapshot *snapshot) = 0;
+
+    // Copy-on-write forks (see DoorImage). freeze captures the CPU in an
+    // image; fork continues from one like restoreSnapshot, but shares the
+    // guest RAM pages of the image until it writes to them.
+    virtual void freeze(DoorImage *image) = 0;
+    virtual bool fork(DoorImage *image) = 0;
+
+    // Guest RAM
+    virtual void setMemoryByte(uint32_t addr, uint8_t value) = 0;
+    virtual uint8_t getMemoryByte(uint32_t addr) = 0;
+    virtual uintptr_t getMemoryPointer() = 0;
+    virtual uint32_t getMemorySize() = 0;
+    virtual void fillMemory(uint32_t addr, uint8_t value, uint32_t length) = 0;
+    virtual void copyMemory(uint32_t dst, uint32_t src, uint32_t length) = 0;
+    virtual void invalidateCode(uint32_t addr, uint32_t length) = 0;
+    virtual uintptr_t getPageTypesPointer() = 0;
+    virtual void protectMemory(uint32_t addr, uint32_t length) = 0;
+    virtual uint32_t getBusFault() = 0;
+    virtual void commitMemory(uint32_t addr, uint32_t length) = 0;
+    virtual uintptr_t getPageBackingPointer() = 0;
+    virtual uintptr_t getReadPointer(uint32_t addr) = 0;
+    virtual uint32_t getSharedPageCount() = 0;
+    virtual uint32_t getCommittedPageCount() = 0;
+    virtual GuestMemory &getMemory() = 0;
+
+    // Copies a relocated executable from the cache into guest RAM at its
+    // load base, sharing its code pages with the other CPUs that load it.
+    // Returns false if there is no such image or it does not fit.
+    virtual bool loadHunks(HunkCache *cache, int id) = 0;
+
+    // exec.library memory functions on the guest heap. The CPU services
+    // them itself when a door calls them through ExecBase, once the host
+    // has set up the heap; the host calls them for everything else.
+    virtual void initHeap(uint32_t start, uint32_t end) = 0;
+    virtual uint32_t allocMem(uint32_t size, uint32_t requirements) = 0;
+    virtual void freeMem(uint32_t addr, uint32_t size) = 0;
+    virtual uint32_t allocVec(uint32_t size, uint32_t requirements) = 0;
+    virtual void freeVec(uint32_t addr) = 0;
+    virtual uint32_t availMem(uint32_t requirements) = 0;
+    virtual GuestHeap &getHeap() = 0;
+
+    // Console (see DoorConsole). The host moves bytes through the staging
+    // buffer: readOutput drains the output into it, writeInput queues input
+    // from it, and readInput takes input for library calls the CPU left to
+    // the host.
+    virtual uintptr_t getConsoleBufferPointer() = 0;
+    virtual uint32_t readOutput() = 0;
+    virtual uint32_t writeInput(uint32_t length) = 0;
+    virtual uint32_t readInput(uint32_t length) = 0;
+    virtual uint32_t pendingInput() = 0;
+    virtual std::shared_ptr<DoorConsole> getConsole() = 0;
+
+    // Running the CPU
+    virtual void resetCPU() = 0;
+    virtual int executeCycles(int cycles) = 0;
+    virtual ExecEvent executeUntilEvent(int maxCycles) = 0;
+    virtual void completeTrap() = 0;
+    virtual int64_t getClock() const = 0;
+    virtual void setBatchedTraps(bool enable) = 0;
+    virtual uintptr_t getRegisterFilePointer() = 0;
+    virtual uintptr_t getEventRecordPointer() = 0;
+    virtual const EventRecord &getEventRecord() const = 0;
+    virtual void setJitThreshold(uint32_t threshold) = 0;
+    virtual void setJitEntry(uint32_t pc, bool compiled) = 0;
+    virtual uint32_t getRegister(int reg) = 0;
+    virtual void setRegister(int reg, uint32_t value) = 0;
+};
+
+// Defined in moira-fast.cpp and moira-accurate.cpp
+template <> DoorCPU *DoorCPU::create<DoorProfile::FAST>(size_t memSize);
+template <> DoorCPU *DoorCPU::create<DoorProfile::ACCURATE>(size_t memSize);
+
+inline DoorCPU *DoorCPU::create(size_t memSize, DoorProfile profile) {
+    if (profile == DoorProfile::ACCURATE) return create<DoorProfile::ACCURATE>(memSize);
+    return create<DoorProfile::FAST>(memSize);
+}
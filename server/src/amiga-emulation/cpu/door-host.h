@@ -0,0 +1,147 @@
+#pragma once
+
+#include "door-cpu.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Outcome of one context in a scheduler tick
+struct TickEvent {
+    uint32_t context;
+    EventRecord event;
+};
+
+static_assert(sizeof(TickEvent) == 6 * sizeof(uint32_t), "TickEvent layout is shared with JS");
+
+// Door host: many door CPUs in one module, time-sliced by a round-robin
+// scheduler.
+//
+// Every context is a door CPU with its own guest RAM and profile; all CPUs of
+// a profile share the jump tables, and all of them share the module heap. A
+// context runs in tick() until it has used up its slice or hits an event.
+// Library calls, JIT events and terminal events (exit, STOP, halt, illegal
+// instruction, fault) park the context until the host calls resume(); budget
+// and idle slices keep it runnable.
+//
+// A slice is a budget per round, not per tick: a context that stopped at a
+// library call continues with the rest of its slice in the next tick, while
+// contexts that have used up their slice sit out until every context has.
+// The host can thus service library calls and tick again right away without
+// giving CPU-bound doors extra time.
+class DoorHost {
+private:
+    struct Context {
+        std::unique_ptr<DoorCPU> cpu;
+        bool runnable = false;
+
+        // Cycles used in the current round
+        int64_t used = 0;
+    };
+
+    std::vector<Context> contexts;
+    std::vector<TickEvent> events;
+
+    // Index of the context that runs first in the next tick
+    size_t next = 0;
+
+public:
+    // Creates a parked context and returns its id (ids of destroyed contexts
+    // are reused)
+    int createContext(size_t memSize, DoorProfile profile) {
+        size_t id = 0;
+        while (id < contexts.size() && contexts[id].cpu) id++;
+        if (id == contexts.size()) contexts.emplace_back();
+
+        contexts[id].cpu.reset(DoorCPU::create(memSize, profile));
+        contexts[id].cpu->setBatchedTraps(true);
+        contexts[id].runnable = false;
+        contexts[id].used = 0;
+        return (int)id;
+    }
+
+    void destroyContext(int id) {
+        if (valid(id)) contexts[id] = Context();
+    }
+
+    // The context's CPU (owned by the host, valid until destroyContext or
+    // setProfile)
+    DoorCPU *getContext(int id) {
+        return valid(id) ? contexts[id].cpu.get() : nullptr;
+    }
+
+    // Moves a context to a CPU of another profile, which continues where the
+    // old one stopped. The context keeps its id, slice and run state.
+    void setProfile(int id, DoorProfile profile) {
+        if (!valid(id) || contexts[id].cpu->getProfile() == profile) return;
+        Context &ctx = contexts[id];
+        std::unique_ptr<DoorCPU> cpu(DoorCPU::create(ctx.cpu->getMemorySize(), profile));
+        cpu->takeOver(ctx.cpu.get());
+        ctx.cpu = std::move(cpu);
+    }
+
+    // Makes a context runnable again, completing a pending library call.
+    // Cycles the host executed for the CPU (JIT) count against its slice.
+    void resume(int id) {
+        if (!valid(id)) return;
+        Context &ctx = contexts[id];
+        int64_t clock = ctx.cpu->getClock();
+        ctx.cpu->completeTrap();
+        ctx.used += ctx.cpu->getClock() - clock;
+        ctx.runnable = true;
+    }
+
+    // Parks a context without an event (e.g. while its session is paused)
+    void suspend(int id) {
+        if (valid(id)) contexts[id].runnable = false;
+    }
+
+    // Runs every runnable context with slice time left for the rest of its
+    // slice and returns the number of events. Starts a new round first if no
+    // such context is left. The start position of a round rotates, so no
+    // context is always first to see fresh input.
+    int tick(int sliceCycles) {
+        events.clear();
+        size_t count = contexts.size();
+
+        if (!pending(sliceCycles)) {
+            for (Context &ctx : contexts) ctx.used = 0;
+            next = count ? (next + 1) % count : 0;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            size_t id = (next + i) % count;
+            Context &ctx = contexts[id];
+            if (!ctx.cpu || !ctx.runnable || ctx.used >= sliceCycles) continue;
+
+            ExecEvent reason = ctx.cpu->executeUntilEvent((int)(sliceCycles - ctx.used));
+            ctx.used += ctx.cpu->getEventRecord().cycles;
+
+            if (reason == ExecEvent::BUDGET || reason == ExecEvent::IDLE) {
+                ctx.used = sliceCycles;
+            } else {
+                ctx.runnable = false;
+            }
+            events.push_back({ (uint32_t)id, ctx.cpu->getEventRecord() });
+        }
+
+        return (int)events.size();
+    }
+
+    // Events of the last tick inside the WASM heap (JS wraps them in a HEAPU32 view)
+    uintptr_t getEventsPointer() {
+        return reinterpret_cast<uintptr_t>(events.data());
+    }
+
+private:
+    bool valid(int id) const {
+        return id >= 0 && (size_t)id < contexts.size() && contexts[id].cpu;
+    }
+
+    // Checks if a runnable context has slice time left in this round
+    bool pending(int sliceCycles) const {
+        for (const Context &ctx : contexts) {
+            if (ctx.cpu && ctx.runnable && ctx.used < sliceCycles) return true;
+        }
+        return false;
+    }
+};
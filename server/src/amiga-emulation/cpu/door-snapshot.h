@@ -0,0 +1,102 @@
+#pragma once
+
+#include "guest-memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Machine image of a door CPU (see DoorCPU::saveSnapshot).
+//
+// The image is a flat little-endian byte stream, so it can be kept in native
+// memory and restored into any number of CPUs, or copied out through its
+// view and stored elsewhere. Layout (version 1):
+//
+//   header      magic "MDSN", version, guest RAM size
+//   cpu         D0-D7, A0-A7, PC, SR, USP, ISP, prefetch queue, IPL,
+//               execution flags, clock, idle cycles
+//   door        event record, batched traps, bus fault, JIT threshold
+//   debugger    breakpoints, watchpoints, catchpoints
+//   pages       page types, run-length encoded
+//   heap        range and allocated blocks
+//   ram         pages that are not all zero, with their page numbers
+//
+// Images are independent of the door profile. The console, the block cache
+// and the JIT entries are not part of them.
+class DoorSnapshot {
+public:
+    static constexpr uint32_t MAGIC = 0x4E53444D; // "MDSN"
+    static constexpr uint32_t VERSION = 1;
+
+    std::vector<uint8_t> data;
+
+    // Image location (JS wraps it in a HEAPU8 view to store it)
+    uintptr_t getPointer() { return reinterpret_cast<uintptr_t>(data.data()); }
+    uint32_t getSize() { return (uint32_t)data.size(); }
+
+    // Makes room for an image of the given size, which the host then copies
+    // in through the view
+    void resize(uint32_t size) { data.resize(size); }
+
+    //
+    // Writing
+    //
+
+    void clear() { data.clear(); }
+
+    void put8(uint8_t value) { data.push_back(value); }
+    void put16(uint16_t value) { put8((uint8_t)value); put8((uint8_t)(value >> 8)); }
+    void put32(uint32_t value) { put16((uint16_t)value); put16((uint16_t)(value >> 16)); }
+    void put64(uint64_t value) { put32((uint32_t)value); put32((uint32_t)(value >> 32)); }
+
+    void putBytes(const uint8_t *bytes, size_t length) {
+        data.insert(data.end(), bytes, bytes + length);
+    }
+};
+
+// Reads an image front to back. Reads past the end return zeros and make
+// the reader fail, so the caller checks once at the end.
+class SnapshotReader {
+    const DoorSnapshot &snapshot;
+    size_t pos = 0;
+    bool failed = false;
+
+public:
+    explicit SnapshotReader(const DoorSnapshot &snapshot) : snapshot(snapshot) { }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return pos == snapshot.data.size(); }
+
+    uint8_t get8() {
+        if (pos >= snapshot.data.size()) {
+            failed = true;
+            return 0;
+        }
+        return snapshot.data[pos++];
+    }
+    uint16_t get16() { uint16_t lo = get8(); return (uint16_t)(lo | get8() << 8); }
+    uint32_t get32() { uint32_t lo = get16(); return lo | (uint32_t)get16() << 16; }
+    uint64_t get64() { uint64_t lo = get32(); return lo | (uint64_t)get32() << 32; }
+
+    // Returns a pointer to the next length bytes, or null if there are fewer
+    const uint8_t *getBytes(size_t length) {
+        if (length > snapshot.data.size() - pos) {
+            failed = true;
+            return nullptr;
+        }
+        const uint8_t *bytes = snapshot.data.data() + pos;
+        pos += length;
+        return bytes;
+    }
+};
+
+// Frozen door that CPUs fork from (see DoorCPU::fork).
+//
+// Holds the machine state as an image without guest RAM, and a frozen copy
+// of guest RAM whose pages every fork shares until it writes to them. Forks
+// keep the copy alive, so the image can be deleted while they run.
+class DoorImage {
+public:
+    DoorSnapshot state;
+    std::shared_ptr<const GuestMemory::Frozen> ram;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "door-cpu.h"
+#include "spsc-ring.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/threading.h>
+#endif
+
+// Runs one door CPU on its own thread (pthreads build).
+//
+// The thread executes the CPU in slices and reports events to the host
+// through an SPSC ring. Library calls and terminal events park the thread
+// until the host calls resume(); while it is parked, the host owns the CPU
+// and may access registers and guest memory. Budget and idle events are
+// progress reports: they are only queued when the host has drained the
+// ring, otherwise their cycles are added to the next event.
+//
+// Every queued event increments the signal word, so the host can sleep on it
+// (Atomics.waitAsync in JS) instead of polling.
+class DoorThread {
+public:
+    // Delay before the next slice while the door spins in a branch to itself
+    static constexpr auto IDLE_BACKOFF = std::chrono::milliseconds(10);
+
+private:
+    enum State : uint32_t { RUNNING, PARKED, QUIT };
+
+    DoorCPU *cpu;
+    int sliceCycles;
+
+    SpscRing<EventRecord, 16> events;
+    std::atomic<uint32_t> state {PARKED};
+    std::atomic<uint32_t> signal {0};
+    std::thread thread;
+
+    // Last event taken from the ring (host side)
+    EventRecord current {};
+
+public:
+    // The CPU stays owned by the caller and must outlive the thread
+    DoorThread(DoorCPU *cpu, int sliceCycles) : cpu(cpu), sliceCycles(sliceCycles) {}
+
+    DoorThread(const DoorThread &) = delete;
+    DoorThread &operator=(const DoorThread &) = delete;
+
+    ~DoorThread() { stop(); }
+
+    // Starts the thread with the CPU running
+    void start() {
+        if (thread.joinable()) return;
+        state.store(RUNNING);
+        thread = std::thread([this] { run(); });
+    }
+
+    // Makes a parked CPU run again, completing a pending library call
+    void resume() {
+        uint32_t expected = PARKED;
+        if (state.compare_exchange_strong(expected, RUNNING)) state.notify_one();
+    }
+
+    // Ends the thread and waits for it. The host owns the CPU afterwards.
+    void stop() {
+        state.store(QUIT);
+        state.notify_one();
+        if (thread.joinable()) thread.join();
+    }
+
+    // Takes the next event from the ring into the event record (host side)
+    bool pollEvent() {
+        return events.pop(current);
+    }
+
+    uintptr_t getEventRecordPointer() {
+        return reinterpret_cast<uintptr_t>(&current);
+    }
+
+    // Futex word incremented for every queued event
+    uintptr_t getSignalPointer() {
+        return reinterpret_cast<uintptr_t>(&signal);
+    }
+
+private:
+    void run() {
+        uint32_t cycles = 0, idle = 0;
+
+        for (;;) {
+            uint32_t s = state.load();
+            if (s == QUIT) break;
+            if (s == PARKED) {
+                state.wait(PARKED);
+                continue;
+            }
+
+            ExecEvent reason = cpu->executeUntilEvent(sliceCycles);
+            EventRecord record = cpu->getEventRecord();
+            cycles += record.cycles;
+            idle += record.idle;
+
+            bool parks = reason != ExecEvent::BUDGET && reason != ExecEvent::IDLE;
+            if (parks || events.empty()) {
+                // Park before queueing, so a resume() for this event is not lost
+                if (parks) {
+                    uint32_t expected = RUNNING;
+                    state.compare_exchange_strong(expected, PARKED);
+                }
+                record.cycles = cycles;
+                record.idle = idle;
+                cycles = idle = 0;
+                // The ring holds at most one progress report and one parking
+                // event, so this never spins in practice
+                while (!events.push(record)) std::this_thread::yield();
+                notifyHost();
+            }
+
+            if (reason == ExecEvent::IDLE) std::this_thread::sleep_for(IDLE_BACKOFF);
+        }
+    }
+
+    void notifyHost() {
+        signal.fetch_add(1);
+#ifdef __EMSCRIPTEN__
+        emscripten_futex_wake(&signal, INT_MAX);
+#else
+        signal.notify_all();
+#endif
+    }
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Allocator behind the exec.library memory functions of a door.
+//
+// Manages a range of guest RAM with TLSF (two-level segregated fit): free
+// blocks are kept in lists by size class, 16 classes per power of two, and
+// two bitmaps tell which lists hold blocks. Allocating takes the first block
+// of the smallest class that fits and splits off the rest; freeing merges a
+// block with its free neighbours. Both are a few bit scans and list updates.
+//
+// Block headers live on the host instead of in guest RAM, so a door that
+// writes past the end of a block cannot corrupt the heap. The heap only
+// hands out addresses; clearing blocks (MEMF_CLEAR) is up to the caller.
+class GuestHeap {
+public:
+    // Blocks are 8-byte aligned like Exec's MemChunks
+    static constexpr uint32_t ALIGN_BITS = 3;
+    static constexpr uint32_t ALIGN = 1u << ALIGN_BITS;
+
+    // An allocated block (see allocations)
+    struct Allocation {
+        uint32_t addr;
+        uint32_t size;
+    };
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Second level: 16 classes per power of two. Sizes below SMALL_BLOCK get
+    // one class per 8 bytes in the first list.
+    static constexpr uint32_t SL_BITS = 4;
+    static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+    static constexpr uint32_t FL_SHIFT = SL_BITS + ALIGN_BITS;
+    static constexpr uint32_t SMALL_BLOCK = 1u << FL_SHIFT;
+
+    // First level: enough powers of two for the 24-bit address space
+    static constexpr uint32_t FL_COUNT = 24 - FL_SHIFT + 2;
+
+    struct Block {
+        uint32_t addr;
+        uint32_t size;
+        uint32_t prev, next;            // Neighbours in guest RAM (NONE at the ends)
+        uint32_t prevFree, nextFree;    // Free list; nextFree chains unused nodes
+        bool free;
+    };
+
+    // Block nodes, indexed by the links above
+    std::vector<Block> blocks;
+    uint32_t unusedNodes = NONE;
+
+    uint32_t flBitmap = 0;
+    uint16_t slBitmap[FL_COUNT];
+    uint32_t freeLists[FL_COUNT][SL_COUNT];
+
+    // Allocated blocks by address: open addressing with linear probing,
+    // at most half full (addr 0 marks an empty slot)
+    struct Entry {
+        uint32_t addr;
+        uint32_t node;
+    };
+    std::vector<Entry> allocated;
+    uint32_t allocatedCount = 0;
+
+    uint32_t heapStart = 0;
+    uint32_t heapEnd = 0;
+    uint32_t freeBytes = 0;
+
+public:
+    GuestHeap() { init(0, 0); }
+
+    // Starts over with [start, end) as one free block. Address 0 is never
+    // handed out (it means failure).
+    void init(uint32_t start, uint32_t end) {
+        clear(start, end);
+        uint32_t last = NONE;
+        if (heapEnd > heapStart) append(heapStart, heapEnd - heapStart, true, last);
+    }
+
+    // Starts over with [start, end) and the given blocks allocated (in
+    // address order, as returned by allocations). Returns false, with an
+    // empty heap, if a block is misaligned, overlaps another one or lies
+    // outside the heap.
+    bool restore(uint32_t start, uint32_t end, const std::vector<Allocation> &used) {
+        clear(start, end);
+        uint32_t last = NONE;
+        uint32_t cursor = heapStart;
+        for (const Allocation &block : used) {
+            if (block.addr < cursor || block.addr > heapEnd || block.size > heapEnd - block.addr ||
+                block.size == 0 || (block.addr | block.size) & (ALIGN - 1)) {
+                init(start, end);
+                return false;
+            }
+            if (block.addr > cursor) append(cursor, block.addr - cursor, true, last);
+            append(block.addr, block.size, false, last);
+            cursor = block.addr + block.size;
+        }
+        if (heapEnd > cursor) append(cursor, heapEnd - cursor, true, last);
+        return true;
+    }
+
+    // Allocated blocks in address order
+    std::vector<Allocation> allocations() const {
+        std::vector<Allocation> result;
+        result.reserve(allocatedCount);
+        for (const Entry &entry : allocated) {
+            if (entry.addr) result.push_back({ entry.addr, blocks[entry.node].size });
+        }
+        std::sort(result.begin(), result.end(), [](const Allocation &a, const Allocation &b) {
+            return a.addr < b.addr;
+        });
+        return result;
+    }
+
+    // Returns the address of a block of at least size bytes, or 0
+    uint32_t alloc(uint32_t size) {
+        if (size == 0 || size > heapEnd - heapStart) return 0;
+        size = (size + ALIGN - 1) & ~(ALIGN - 1);
+
+        uint32_t node = findFree(size);
+        if (node == NONE) return 0;
+        removeFree(node);
+        if (blocks[node].size - size >= ALIGN) split(node, size);
+
+        insertAllocated(blocks[node].addr, node);
+        return blocks[node].addr;
+    }
+
+    // Returns false if addr is not the address of an allocated block
+    bool free(uint32_t addr) {
+        uint32_t node = removeAllocated(addr);
+        if (node == NONE) return false;
+
+        uint32_t next = blocks[node].next;
+        if (next != NONE && blocks[next].free) {
+            removeFree(next);
+            merge(node, next);
+        }
+        uint32_t prev = blocks[node].prev;
+        if (prev != NONE && blocks[prev].free) {
+            removeFree(prev);
+            merge(prev, node);
+            node = prev;
+        }
+        insertFree(node);
+        return true;
+    }
+
+    // Range of guest RAM covered by the heap
+    uint32_t start() const { return heapStart; }
+    uint32_t end() const { return heapEnd; }
+
+    // Size of the heap
+    uint32_t total() const { return heapEnd - heapStart; }
+
+    // Free bytes, in all blocks together
+    uint32_t available() const { return freeBytes; }
+
+    // Size of the largest free block
+    uint32_t largest() const {
+        if (!flBitmap) return 0;
+        uint32_t fl = std::bit_width(flBitmap) - 1;
+        uint32_t sl = std::bit_width((uint32_t)slBitmap[fl]) - 1;
+        uint32_t size = 0;
+        for (uint32_t node = freeLists[fl][sl]; node != NONE; node = blocks[node].nextFree) {
+            size = std::max(size, blocks[node].size);
+        }
+        return size;
+    }
+
+private:
+    // Empties the heap and sets its range
+    void clear(uint32_t start, uint32_t end) {
+        blocks.clear();
+        allocated.assign(64, {});
+        allocatedCount = 0;
+        unusedNodes = NONE;
+        flBitmap = 0;
+        std::fill(std::begin(slBitmap), std::end(slBitmap), 0);
+        std::fill(&freeLists[0][0], &freeLists[0][0] + FL_COUNT * SL_COUNT, NONE);
+        freeBytes = 0;
+
+        heapStart = (std::max(start, ALIGN) + ALIGN - 1) & ~(ALIGN - 1);
+        heapEnd = std::max(heapStart, end & ~(ALIGN - 1));
+    }
+
+    // Adds a block behind the last one (building the heap in address order)
+    void append(uint32_t addr, uint32_t size, bool free, uint32_t &last) {
+        uint32_t node = newNode();
+        blocks[node] = { addr, size, last, NONE, NONE, NONE, false };
+        if (last != NONE) blocks[last].next = node;
+        last = node;
+        if (free) insertFree(node);
+        else insertAllocated(addr, node);
+    }
+
+    // Size class of a block size
+    static void mapping(uint32_t size, uint32_t &fl, uint32_t &sl) {
+        if (size < SMALL_BLOCK) {
+            fl = 0;
+            sl = size >> ALIGN_BITS;
+        } else {
+            uint32_t msb = std::bit_width(size) - 1;
+            fl = msb - FL_SHIFT + 1;
+            sl = (size >> (msb - SL_BITS)) & (SL_COUNT - 1);
+        }
+    }
+
+    // First block of the smallest non-empty class whose blocks all fit
+    uint32_t findFree(uint32_t size) const {
+        if (size >= SMALL_BLOCK) size += (1u << (std::bit_width(size) - 1 - SL_BITS)) - 1;
+
+        uint32_t fl, sl;
+        mapping(size, fl, sl);
+        uint32_t slMap = slBitmap[fl] & (~0u << sl);
+        if (!slMap) {
+            uint32_t flMap = flBitmap & (~0u << (fl + 1));
+            if (!flMap) return NONE;
+            fl = std::countr_zero(flMap);
+            slMap = slBitmap[fl];
+        }
+        return freeLists[fl][std::countr_zero(slMap)];
+    }
+
+    void insertFree(uint32_t node) {
+        Block &block = blocks[node];
+        uint32_t fl, sl;
+        mapping(block.size, fl, sl);
+
+        block.free = true;
+        block.prevFree = NONE;
+        block.nextFree = freeLists[fl][sl];
+        if (block.nextFree != NONE) blocks[block.nextFree].prevFree = node;
+        freeLists[fl][sl] = node;
+        flBitmap |= 1u << fl;
+        slBitmap[fl] |= (uint16_t)(1u << sl);
+        freeBytes += block.size;
+    }
+
+    void removeFree(uint32_t node) {
+        Block &block = blocks[node];
+        uint32_t fl, sl;
+        mapping(block.size, fl, sl);
+
+        if (block.prevFree != NONE) blocks[block.prevFree].nextFree = block.nextFree;
+        else freeLists[fl][sl] = block.nextFree;
+        if (block.nextFree != NONE) blocks[block.nextFree].prevFree = block.prevFree;
+        if (freeLists[fl][sl] == NONE) {
+            slBitmap[fl] &= (uint16_t)~(1u << sl);
+            if (!slBitmap[fl]) flBitmap &= ~(1u << fl);
+        }
+        block.free = false;
+        freeBytes -= block.size;
+    }
+
+    // Cuts a used block down to size and puts the rest on a free list
+    void split(uint32_t node, uint32_t size) {
+        uint32_t rest = newNode();
+        Block &block = blocks[node];
+        blocks[rest] = { block.addr + size, block.size - size, node, block.next, NONE, NONE, false };
+        if (block.next != NONE) blocks[block.next].prev = rest;
+        block.next = rest;
+        block.size = size;
+        insertFree(rest);
+    }
+
+    // Appends a block to its neighbour below and drops its node
+    void merge(uint32_t node, uint32_t next) {
+        Block &block = blocks[node];
+        block.size += blocks[next].size;
+        block.next = blocks[next].next;
+        if (block.next != NONE) blocks[block.next].prev = node;
+        blocks[next].nextFree = unusedNodes;
+        unusedNodes = next;
+    }
+
+    // Home slot of an address (Fibonacci hashing)
+    uint32_t slotOf(uint32_t addr) const {
+        return ((addr >> ALIGN_BITS) * 0x9E3779B1u) & (uint32_t)(allocated.size() - 1);
+    }
+
+    // Empty slot for addr
+    uint32_t probe(uint32_t addr) const {
+        uint32_t slot = slotOf(addr);
+        while (allocated[slot].addr) slot = (slot + 1) & (uint32_t)(allocated.size() - 1);
+        return slot;
+    }
+
+    void insertAllocated(uint32_t addr, uint32_t node) {
+        if (2 * (allocatedCount + 1) > allocated.size()) {
+            std::vector<Entry> old(2 * allocated.size());
+            old.swap(allocated);
+            for (const Entry &entry : old) {
+                if (entry.addr) allocated[probe(entry.addr)] = entry;
+            }
+        }
+        allocated[probe(addr)] = { addr, node };
+        allocatedCount++;
+    }
+
+    // Returns the node of the block at addr (NONE if there is none)
+    uint32_t removeAllocated(uint32_t addr) {
+        if (!addr) return NONE;
+        uint32_t mask = (uint32_t)(allocated.size() - 1);
+        uint32_t slot = slotOf(addr);
+        while (allocated[slot].addr != addr) {
+            if (!allocated[slot].addr) return NONE;
+            slot = (slot + 1) & mask;
+        }
+        uint32_t node = allocated[slot].node;
+        allocatedCount--;
+
+        // Move later entries of the probe sequence up into the gap
+        for (uint32_t next = (slot + 1) & mask; allocated[next].addr; next = (next + 1) & mask) {
+            uint32_t home = slotOf(allocated[next].addr);
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                allocated[slot] = allocated[next];
+                slot = next;
+            }
+        }
+        allocated[slot] = {};
+        return node;
+    }
+
+    uint32_t newNode() {
+        if (unusedNodes == NONE) {
+            blocks.push_back({});
+            return (uint32_t)blocks.size() - 1;
+        }
+        uint32_t node = unusedNodes;
+        unusedNodes = blocks[node].nextFree;
+        return node;
+    }
+};
@@ -0,0 +1,461 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifndef __EMSCRIPTEN__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Guest address space of the door CPU.
+//
+// The 24-bit address space is split into 4 KB pages. Each page has a type
+// and, for pages backed by guest RAM, a direct host pointer in the read and
+// write tables. A CPU access is a table lookup on the top address bits plus
+// an add; only a null entry leaves the fast path, and the CPU then dispatches
+// on the page type (trap window, write to ROM, unmapped page).
+//
+// Guest RAM is one contiguous block starting at address 0, so the host can
+// still wrap it in a single HEAPU8 view. The block is committed lazily, page
+// by page. A page nobody has written to reads from a static zero page; a page
+// of a door forked from an image (see share) or holding code that other doors
+// load too (see sharePages) reads from a frozen copy. The first write gives
+// the page its own copy in the block and points both tables at it. Host
+// access through the block must commit the range first.
+//
+// Native builds map the block from the OS (see Block), so a door only pays
+// for the pages it writes, and pages it clears go back to the OS. Under WASM
+// the block comes from malloc, whose heap never shrinks: a block recycled
+// from an earlier door is already backed, and only the module's first doors
+// save the pages they do not write.
+class GuestMemory {
+public:
+    static constexpr uint32_t ADDRESS_MASK = 0x00FFFFFF;
+    static constexpr uint32_t PAGE_BITS = 12;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+    static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+    static constexpr uint32_t PAGE_COUNT = (ADDRESS_MASK + 1) >> PAGE_BITS;
+
+    enum class PageType : uint8_t {
+        UNMAPPED,   // Bus error on access
+        RAM,        // Guest RAM, read and write
+        ROM,        // Guest RAM, writes from the CPU are ignored
+        TRAP,       // Library vectors, fetches are routed to the trap handler
+        CODE        // Guest RAM holding cached code, CPU writes take the slow path
+    };
+
+    // Where the contents of a RAM page live
+    enum class PageBacking : uint8_t {
+        OWN,        // In the block (also pages outside guest RAM)
+        SHARED,     // In a frozen copy shared with other CPUs
+        ZERO        // Never written, reads as zeros
+    };
+
+    // Guest RAM frozen for sharing (see freeze). Only pages that are not all
+    // zero are stored, back to back, plus a spare byte like the block. Pages
+    // that were shared when the copy was made stay in the copies they came
+    // from, which the copy keeps alive.
+    struct Frozen {
+        std::vector<uint8_t> data;
+        std::vector<const uint8_t *> pages; // Contents of each page, null for zero pages
+        std::vector<std::shared_ptr<const Frozen>> sources;
+
+        uint32_t size() const { return (uint32_t)pages.size() << PAGE_BITS; }
+    };
+
+    // Contents of untouched pages (with a spare byte like the block)
+    static constexpr uint8_t zeroPage[PAGE_SIZE + 1] {};
+
+private:
+    // Memory of the RAM block. Aborts if there is not enough address space.
+    class Block {
+        uint8_t *data;
+        size_t length;
+
+    public:
+        explicit Block(size_t length) : length(length) {
+#ifdef __EMSCRIPTEN__
+            data = static_cast<uint8_t *>(std::malloc(length));
+#else
+            void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            data = p == MAP_FAILED ? nullptr : static_cast<uint8_t *>(p);
+#endif
+            if (!data) {
+                std::fprintf(stderr, "GuestMemory: cannot allocate %zu bytes of guest RAM\n", length);
+                std::abort();
+            }
+        }
+
+        ~Block() {
+#ifdef __EMSCRIPTEN__
+            std::free(data);
+#else
+            munmap(data, length);
+#endif
+        }
+
+        Block(const Block &) = delete;
+        Block &operator=(const Block &) = delete;
+
+        uint8_t *get() const { return data; }
+
+        // Hands whole guest pages back to the OS. Their contents are
+        // undefined afterwards. Hosts with larger pages than the guest keep
+        // them, as the OS would drop the neighbouring guest pages too.
+        void release([[maybe_unused]] uint32_t offset, [[maybe_unused]] uint32_t size) {
+#ifndef __EMSCRIPTEN__
+            static const bool supported = sysconf(_SC_PAGESIZE) <= (long)PAGE_SIZE;
+            if (supported) madvise(data + offset, size, MADV_DONTNEED);
+#endif
+        }
+    };
+    uint32_t ramSize;
+    Block ram;
+
+    const uint8_t *readPage[PAGE_COUNT];
+    uint8_t *writePage[PAGE_COUNT];
+    PageType pageType[PAGE_COUNT];
+
+    // Backing of each page, and its contents unless it is in the block
+    PageBacking pageBacking[PAGE_COUNT] {};
+    const uint8_t *pageSource[PAGE_COUNT] {};
+    uint32_t sharedCount = 0;
+    uint32_t zeroCount = 0;
+
+    // Frozen copies the shared pages point into (kept until no page is
+    // shared any more)
+    std::vector<std::shared_ptr<const Frozen>> frozen;
+
+    // Pages turned into code pages by protectCode
+    std::vector<uint32_t> codePages;
+
+public:
+    // RAM is rounded up to whole pages and ends below the trap window. One
+    // spare byte keeps a misaligned word read at the last page in bounds.
+    // The block is left uninitialized; every page starts out untouched.
+    GuestMemory(size_t size, uint32_t trapStart) :
+        ramSize((uint32_t)std::min<size_t>((size + PAGE_MASK) & ~(size_t)PAGE_MASK, trapStart)),
+        ram((size_t)ramSize + 1) {
+        ram.get()[ramSize] = 0;
+
+        map(0, ADDRESS_MASK + 1, PageType::UNMAPPED);
+        map(0, ramSize, PageType::RAM);
+        map(trapStart, ADDRESS_MASK + 1 - trapStart, PageType::TRAP);
+        share(nullptr);
+    }
+
+    GuestMemory(const GuestMemory &) = delete;
+    GuestMemory &operator=(const GuestMemory &) = delete;
+
+    // Sets the type of all pages overlapping [addr, addr + size). RAM and ROM
+    // pages must lie inside guest RAM; pages outside become unmapped.
+    void map(uint32_t addr, uint32_t size, PageType type) {
+        if (size == 0) return;
+        uint64_t start = addr & ADDRESS_MASK;
+        uint32_t first = (uint32_t)(start >> PAGE_BITS);
+        uint32_t last = (uint32_t)std::min<uint64_t>((start + size - 1) >> PAGE_BITS, PAGE_COUNT - 1);
+
+        for (uint32_t page = first; page <= last; page++) {
+            bool backed = (page << PAGE_BITS) < ramSize &&
+                (type == PageType::RAM || type == PageType::ROM || type == PageType::CODE);
+            pageType[page] = backed || type == PageType::TRAP ? type : PageType::UNMAPPED;
+            updatePage(page);
+        }
+    }
+
+    PageType typeOf(uint32_t addr) const { return pageType[(addr & ADDRESS_MASK) >> PAGE_BITS]; }
+
+    // Page types indexed by page number (JS wraps them in a HEAPU8 view)
+    const PageType *pageTypes() const { return pageType; }
+
+    // Turns the RAM page holding addr into a code page, so that CPU writes to
+    // it can invalidate cached code. Returns false if the page is no RAM page.
+    bool protectCode(uint32_t addr) {
+        uint32_t page = (addr & ADDRESS_MASK) >> PAGE_BITS;
+        if (pageType[page] == PageType::CODE) return true;
+        if (pageType[page] != PageType::RAM) return false;
+
+        pageType[page] = PageType::CODE;
+        updatePage(page);
+        codePages.push_back(page);
+        return true;
+    }
+
+    // Turns all code pages back into RAM pages
+    void unprotectCode() {
+        for (uint32_t page : codePages) {
+            if (pageType[page] == PageType::CODE) {
+                pageType[page] = PageType::RAM;
+                updatePage(page);
+            }
+        }
+        codePages.clear();
+    }
+
+    //
+    // Page backing
+    //
+
+    // Copy of guest RAM to share with other CPUs. Shared pages are not
+    // copied again.
+    std::shared_ptr<const Frozen> freeze() const {
+        std::vector<uint32_t> stored;
+        for (uint32_t base = 0; base < ramSize; base += PAGE_SIZE) {
+            if (pageBacking[base >> PAGE_BITS] == PageBacking::OWN && !isZeroPage(hostData(base))) {
+                stored.push_back(base);
+            }
+        }
+
+        auto copy = std::make_shared<Frozen>();
+        copy->data.resize(stored.size() * PAGE_SIZE + 1);
+        copy->pages.assign(ramSize >> PAGE_BITS, nullptr);
+        copy->sources = frozen;
+        for (uint32_t page = 0; page < ramSize >> PAGE_BITS; page++) {
+            if (pageBacking[page] == PageBacking::SHARED) copy->pages[page] = pageSource[page];
+        }
+        for (size_t i = 0; i < stored.size(); i++) {
+            uint8_t *page = copy->data.data() + i * PAGE_SIZE;
+            std::memcpy(page, hostData(stored[i]), PAGE_SIZE);
+            copy->pages[stored[i] >> PAGE_BITS] = page;
+        }
+        return copy;
+    }
+
+    // Resets guest RAM to a frozen copy of the same size, or to all zeros
+    // without one. Pages are shared with the copy until they are written.
+    void share(std::shared_ptr<const Frozen> copy) {
+        if (copy && copy->size() != ramSize) copy = nullptr;
+        for (uint32_t page = 0; page < ramSize >> PAGE_BITS; page++) {
+            const uint8_t *contents = copy ? copy->pages[page] : nullptr;
+            if (contents) setBacking(page, PageBacking::SHARED, contents);
+            else setBacking(page, PageBacking::ZERO, zeroPage);
+        }
+        frozen.clear();
+        if (sharedCount) frozen.push_back(std::move(copy));
+    }
+
+    // Shares the pages a frozen copy holds inside guest RAM, leaving the
+    // other pages as they are. Used for pages that many CPUs load the same
+    // contents into, like the code of a door (see HunkImage).
+    void sharePages(std::shared_ptr<const Frozen> copy) {
+        bool used = false;
+        for (uint32_t page = 0; page < std::min<size_t>(copy->pages.size(), ramSize >> PAGE_BITS); page++) {
+            if (const uint8_t *contents = copy->pages[page]) {
+                setBacking(page, PageBacking::SHARED, contents);
+                used = true;
+            }
+        }
+        if (used && std::find(frozen.begin(), frozen.end(), copy) == frozen.end()) {
+            frozen.push_back(std::move(copy));
+        }
+    }
+
+    // Gives the page holding addr its own copy in the block. Returns false if
+    // it has one.
+    bool commit(uint32_t addr) {
+        uint32_t page = (addr & ADDRESS_MASK) >> PAGE_BITS;
+        if (pageBacking[page] == PageBacking::OWN) return false;
+
+        std::memcpy(ram.get() + (page << PAGE_BITS), pageSource[page], PAGE_SIZE);
+        setBacking(page, PageBacking::OWN, nullptr);
+        if (!sharedCount) frozen.clear();
+        return true;
+    }
+
+    // Gives every page overlapping the range its own copy
+    void commit(uint32_t addr, uint32_t length) {
+        if (!(sharedCount + zeroCount) || !(length = clipLength(addr, length))) return;
+        for (uint32_t page = addr >> PAGE_BITS; page <= (addr + length - 1) >> PAGE_BITS; page++) {
+            commit(page << PAGE_BITS);
+        }
+    }
+
+    // Page backings indexed by page number (JS wraps them in a HEAPU8 view)
+    const PageBacking *pageBackings() const { return pageBacking; }
+
+    // Pages shared with a frozen copy, and pages with their own copy
+    uint32_t sharedPageCount() const { return sharedCount; }
+    uint32_t committedPageCount() const { return (ramSize >> PAGE_BITS) - sharedCount - zeroCount; }
+
+    // Takes over the contents and page types of another CPU's memory of the
+    // same size, sharing what it shares. Code pages turn into RAM pages.
+    void copyFrom(const GuestMemory &other) {
+        unprotectCode();
+        share(nullptr);
+        for (uint32_t page = 0; page < PAGE_COUNT; page++) {
+            PageType type = other.pageType[page];
+            pageType[page] = type == PageType::CODE ? PageType::RAM : type;
+            updatePage(page);
+        }
+        for (uint32_t base = 0; base < std::min(ramSize, other.ramSize); base += PAGE_SIZE) {
+            uint32_t page = base >> PAGE_BITS;
+            if (other.pageBacking[page] == PageBacking::SHARED) {
+                setBacking(page, PageBacking::SHARED, other.pageSource[page]);
+            } else if (other.pageBacking[page] == PageBacking::OWN) {
+                write(base, other.ram.get() + base, PAGE_SIZE);
+            }
+        }
+        frozen.clear();
+        if (sharedCount) frozen = other.frozen;
+    }
+
+    // Checks if a block of at most a page holds nothing but zeros
+    static bool isZero(const uint8_t *p, uint32_t length) {
+        return std::memcmp(p, zeroPage, length) == 0;
+    }
+    static bool isZeroPage(const uint8_t *page) { return isZero(page, PAGE_SIZE); }
+
+    //
+    // CPU access (fast path). Return false if the page needs the slow path.
+    // The core masks addresses to 24 bits before calling into memory. A word
+    // at the last byte of a page (odd addresses, fast profile only) takes
+    // the slow path too, because the next page may be backed elsewhere.
+    //
+
+    bool read8(uint32_t addr, uint8_t &value) const {
+        if (const uint8_t *p = readPage[addr >> PAGE_BITS]) [[likely]] {
+            value = p[addr & PAGE_MASK];
+            return true;
+        }
+        return false;
+    }
+
+    bool read16(uint32_t addr, uint16_t &value) const {
+        const uint8_t *p = readPage[addr >> PAGE_BITS];
+        if (p && (addr & PAGE_MASK) != PAGE_MASK) [[likely]] {
+            p += addr & PAGE_MASK;
+            value = (uint16_t)(p[0] << 8 | p[1]);
+            return true;
+        }
+        return false;
+    }
+
+    bool write8(uint32_t addr, uint8_t value) const {
+        if (uint8_t *p = writePage[addr >> PAGE_BITS]) [[likely]] {
+            p[addr & PAGE_MASK] = value;
+            return true;
+        }
+        return false;
+    }
+
+    bool write16(uint32_t addr, uint16_t value) const {
+        uint8_t *p = writePage[addr >> PAGE_BITS];
+        if (p && (addr & PAGE_MASK) != PAGE_MASK) [[likely]] {
+            p += addr & PAGE_MASK;
+            p[0] = (uint8_t)(value >> 8);
+            p[1] = (uint8_t)value;
+            return true;
+        }
+        return false;
+    }
+
+    //
+    // Host access to guest RAM (ignores page protection)
+    //
+
+    // The block. Pages must be committed before using it.
+    uint8_t *data() { return ram.get(); }
+    const uint8_t *data() const { return ram.get(); }
+    uint32_t size() const { return ramSize; }
+
+    // Byte at addr in RAM, committed or not. Valid up to the end of its page.
+    const uint8_t *hostData(uint32_t addr) const {
+        const uint8_t *source = pageSource[addr >> PAGE_BITS];
+        return source ? source + (addr & PAGE_MASK) : ram.get() + addr;
+    }
+
+    // Clip a block transfer to the end of guest RAM
+    uint32_t clipLength(uint32_t addr, uint32_t length) const {
+        if (addr >= ramSize) return 0;
+        return std::min(length, ramSize - addr);
+    }
+
+    // Whole pages filled with zeros go back to being untouched
+    void fill(uint32_t addr, uint8_t value, uint32_t length) {
+        for (uint32_t left = clipLength(addr, length); left;) {
+            uint32_t chunk = std::min(left, PAGE_SIZE - (addr & PAGE_MASK));
+            uint32_t page = addr >> PAGE_BITS;
+            if (value == 0 && (chunk == PAGE_SIZE || pageBacking[page] == PageBacking::ZERO)) {
+                if (pageBacking[page] == PageBacking::OWN) ram.release(addr, PAGE_SIZE);
+                setBacking(page, PageBacking::ZERO, zeroPage);
+            } else {
+                commit(addr);
+                std::memset(ram.get() + addr, value, chunk);
+            }
+            addr += chunk;
+            left -= chunk;
+        }
+        if (!sharedCount) frozen.clear();
+    }
+
+    // Zeros written to untouched pages leave them untouched
+    void write(uint32_t addr, const uint8_t *bytes, uint32_t length) {
+        for (uint32_t left = clipLength(addr, length); left;) {
+            uint32_t chunk = std::min(left, PAGE_SIZE - (addr & PAGE_MASK));
+            if (pageBacking[addr >> PAGE_BITS] != PageBacking::ZERO || !isZero(bytes, chunk)) {
+                commit(addr);
+                std::memcpy(ram.get() + addr, bytes, chunk);
+            }
+            addr += chunk;
+            bytes += chunk;
+            left -= chunk;
+        }
+    }
+
+    // Ranges may overlap. Only the destination is committed; the source is
+    // read where it lives, so copying out of shared or untouched pages
+    // leaves them as they are. Pages in both ranges are committed first and
+    // then read from the block, and the copy runs backwards when the
+    // destination lies above the source, like memmove.
+    void copy(uint32_t dst, uint32_t src, uint32_t length) {
+        uint32_t len = std::min(clipLength(dst, length), clipLength(src, length));
+        if (!len) return;
+        commit(dst, len);
+
+        bool backwards = dst > src;
+        for (uint32_t left = len; left;) {
+            uint32_t d = backwards ? dst + left : dst + len - left;
+            uint32_t s = backwards ? src + left : src + len - left;
+            uint32_t chunk;
+            if (backwards) {
+                // Bytes down to the nearest page start below d or s
+                chunk = std::min({ left, ((d - 1) & PAGE_MASK) + 1, ((s - 1) & PAGE_MASK) + 1 });
+                d -= chunk;
+                s -= chunk;
+            } else {
+                chunk = std::min({ left, PAGE_SIZE - (d & PAGE_MASK), PAGE_SIZE - (s & PAGE_MASK) });
+            }
+            std::memmove(ram.get() + d, hostData(s), chunk);
+            left -= chunk;
+        }
+    }
+
+private:
+    // Sets the host pointers of a page from its type and backing
+    void updatePage(uint32_t page) {
+        uint32_t base = page << PAGE_BITS;
+        PageType type = pageType[page];
+        bool backed = type == PageType::RAM || type == PageType::ROM || type == PageType::CODE;
+        readPage[page] = backed ? hostData(base) : nullptr;
+        writePage[page] = type == PageType::RAM && pageBacking[page] == PageBacking::OWN ? ram.get() + base : nullptr;
+    }
+
+    // Moves a page to another backing. What the block held for it is dropped
+    // unless the page stays in the block.
+    void setBacking(uint32_t page, PageBacking backing, const uint8_t *source) {
+        sharedCount -= pageBacking[page] == PageBacking::SHARED;
+        zeroCount -= pageBacking[page] == PageBacking::ZERO;
+        pageBacking[page] = backing;
+        pageSource[page] = source;
+        sharedCount += backing == PageBacking::SHARED;
+        zeroCount += backing == PageBacking::ZERO;
+        updatePage(page);
+    }
+};
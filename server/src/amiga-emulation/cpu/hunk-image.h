@@ -0,0 +1,360 @@
+#pragma once
+
+#include "guest-memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// Door executable in the AmigaDOS hunk format, loaded and relocated once.
+//
+// The image is the executable as it sits in guest RAM after loading: one
+// flat block from the load base to the end of the last segment, with the
+// relocations applied and BSS cleared, plus the segment table. Loading a
+// door is then a single copy (see DoorCPU::loadHunks). Segments follow each
+// other from the load base, aligned to 256 bytes like in
+// loader/HunkLoader.ts.
+//
+// The pages holding code are frozen once more on their own. Every CPU
+// loading the image shares them instead of copying them, until it writes
+// to one (see GuestMemory::sharePages).
+//
+// Understands HUNK_HEADER, HUNK_CODE, HUNK_DATA, HUNK_BSS, HUNK_RELOC32,
+// HUNK_RELOC32SHORT (and HUNK_DREL32, which V37 executables use for it),
+// HUNK_NAME, HUNK_SYMBOL, HUNK_DEBUG and HUNK_END. Overlays and object file
+// hunks are refused.
+class HunkImage {
+public:
+    enum class SegmentType : uint8_t { CODE, DATA, BSS };
+
+    struct Segment {
+        uint32_t address;
+        uint32_t size;
+        SegmentType type;
+    };
+
+    static constexpr uint32_t ALIGNMENT = 256;
+
+    // Executables must fit below the trap window of the 24-bit address space
+    static constexpr uint32_t ADDRESS_LIMIT = 0xFF0000;
+
+    uint32_t base = 0;
+    std::vector<uint8_t> data;
+    std::vector<Segment> segments;
+
+    // Guest pages that lie within the image, overlap a code segment and are
+    // not all zero, with the image's contents
+    std::shared_ptr<const GuestMemory::Frozen> code;
+
+    uint32_t end() const { return base + (uint32_t)data.size(); }
+
+    // Start of the first code segment, as in loader/HunkLoader.ts
+    uint32_t entryPoint() const {
+        for (const Segment &segment : segments) {
+            if (segment.type == SegmentType::CODE) return segment.address;
+        }
+        return base;
+    }
+
+    // Parses an executable and relocates it to the load base. Returns false
+    // if the file is damaged, does not fit or holds hunks it cannot load.
+    bool load(const uint8_t *file, size_t size, uint32_t loadBase) {
+        enum : uint32_t {
+            HUNK_NAME = 0x3E8, HUNK_CODE = 0x3E9, HUNK_DATA = 0x3EA, HUNK_BSS = 0x3EB,
+            HUNK_RELOC32 = 0x3EC, HUNK_SYMBOL = 0x3F0, HUNK_DEBUG = 0x3F1, HUNK_END = 0x3F2,
+            HUNK_HEADER = 0x3F3, HUNK_DREL32 = 0x3F7, HUNK_RELOC32SHORT = 0x3FC
+        };
+        Reader in { file, size };
+        base = loadBase;
+        data.clear();
+        segments.clear();
+        code.reset();
+
+        // Resident library names are not used by executables
+        if (in.get32() != HUNK_HEADER) return false;
+        while (uint32_t longs = in.get32()) in.skip((uint64_t)longs * 4);
+
+        uint32_t tableSize = in.get32();
+        uint32_t first = in.get32();
+        uint32_t last = in.get32();
+        if (!in.ok() || first > last || last >= tableSize) return false;
+
+        // Sizes in longwords, memory flags in the top two bits. Both bits set
+        // means the flags follow in the next longword.
+        uint64_t address = loadBase;
+        for (uint32_t i = first; i <= last && in.ok(); i++) {
+            uint32_t longs = in.get32();
+            if (longs >> 30 == 3) in.get32();
+            uint32_t length = (longs & 0x3FFFFFFF) * 4;
+            if (address + length > ADDRESS_LIMIT) return false;
+            segments.push_back({ (uint32_t)address, length, SegmentType::BSS });
+            address = (address + length + ALIGNMENT - 1) & ~(uint64_t)(ALIGNMENT - 1);
+        }
+        if (!in.ok()) return false;
+        const Segment &lastSegment = segments.back();
+        data.assign(lastSegment.address + lastSegment.size - loadBase, 0);
+
+        size_t index = 0;
+        while (!in.atEnd()) {
+            // Hunk ids may carry memory flags too
+            uint32_t type = in.get32() & 0x3FFFFFFF;
+
+            switch (type) {
+
+                case HUNK_NAME:
+                case HUNK_DEBUG:
+                    in.skip((uint64_t)in.get32() * 4);
+                    break;
+
+                case HUNK_CODE:
+                case HUNK_DATA: {
+                    if (index >= segments.size()) return false;
+                    Segment &segment = segments[index];
+                    uint32_t length = (in.get32() & 0x3FFFFFFF) * 4;
+                    const uint8_t *bytes = in.getBytes(length);
+                    if (!bytes || length > segment.size) return false;
+                    std::memcpy(data.data() + (segment.address - loadBase), bytes, length);
+                    segment.type = type == HUNK_CODE ? SegmentType::CODE : SegmentType::DATA;
+                    break;
+                }
+
+                case HUNK_BSS:
+                    if (index >= segments.size()) return false;
+                    in.get32();
+                    segments[index].type = SegmentType::BSS;
+                    break;
+
+                case HUNK_RELOC32:
+                    while (uint32_t count = in.get32()) {
+                        uint32_t target = in.get32();
+                        for (uint32_t i = 0; i < count && in.ok(); i++) {
+                            if (!relocate(index, target, in.get32())) return false;
+                        }
+                    }
+                    break;
+
+                case HUNK_RELOC32SHORT:
+                case HUNK_DREL32: {
+                    // Words, padded to a longword at the end
+                    uint64_t words = 0;
+                    while (uint16_t count = in.get16()) {
+                        uint16_t target = in.get16();
+                        for (uint32_t i = 0; i < count && in.ok(); i++) {
+                            if (!relocate(index, target, in.get16())) return false;
+                        }
+                        words += 2 + count;
+                    }
+                    if (words % 2 == 0) in.get16();
+                    break;
+                }
+
+                case HUNK_SYMBOL:
+                    while (uint32_t longs = in.get32()) in.skip((uint64_t)longs * 4 + 4);
+                    break;
+
+                case HUNK_END:
+                    index++;
+                    break;
+
+                default:
+                    return false;
+            }
+            if (!in.ok()) return false;
+        }
+        if (index != segments.size()) return false;
+
+        freezeCode();
+        return true;
+    }
+
+private:
+    // Big-endian reader over the file. Reads past the end return zeros and
+    // make the reader fail.
+    struct Reader {
+        const uint8_t *file;
+        size_t size;
+        size_t pos = 0;
+        bool failed = false;
+
+        bool ok() const { return !failed; }
+        bool atEnd() const { return failed || pos == size; }
+
+        const uint8_t *getBytes(uint64_t length) {
+            if (failed || length > size - pos) {
+                failed = true;
+                return nullptr;
+            }
+            const uint8_t *bytes = file + pos;
+            pos += length;
+            return bytes;
+        }
+        void skip(uint64_t length) { getBytes(length); }
+
+        uint16_t get16() {
+            const uint8_t *p = getBytes(2);
+            return p ? (uint16_t)(p[0] << 8 | p[1]) : 0;
+        }
+        uint32_t get32() {
+            const uint8_t *p = getBytes(4);
+            return p ? (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3] : 0;
+        }
+    };
+
+    // Sets up the shared code pages once the image is complete
+    void freezeCode() {
+        constexpr uint32_t PAGE_BITS = GuestMemory::PAGE_BITS;
+        constexpr uint32_t PAGE_SIZE = GuestMemory::PAGE_SIZE;
+        uint32_t first = (base + PAGE_SIZE - 1) >> PAGE_BITS;
+        uint32_t last = end() >> PAGE_BITS;
+
+        std::vector<uint32_t> stored;
+        for (uint32_t page = first; page < last; page++) {
+            uint32_t start = page << PAGE_BITS;
+            bool isCode = false;
+            for (const Segment &segment : segments) {
+                isCode |= segment.type == SegmentType::CODE &&
+                    segment.address < start + PAGE_SIZE && start < segment.address + segment.size;
+            }
+            if (isCode && !GuestMemory::isZeroPage(data.data() + (start - base))) stored.push_back(page);
+        }
+
+        auto copy = std::make_shared<GuestMemory::Frozen>();
+        copy->data.resize(stored.size() * PAGE_SIZE + 1);
+        copy->pages.assign(last, nullptr);
+        for (size_t i = 0; i < stored.size(); i++) {
+            uint8_t *page = copy->data.data() + i * PAGE_SIZE;
+            std::memcpy(page, data.data() + ((stored[i] << PAGE_BITS) - base), PAGE_SIZE);
+            copy->pages[stored[i]] = page;
+        }
+        code = std::move(copy);
+    }
+
+    // Adds the address of the target segment to a longword of a segment
+    bool relocate(size_t index, uint32_t target, uint32_t offset) {
+        if (index >= segments.size() || target >= segments.size()) return false;
+        const Segment &segment = segments[index];
+        if ((uint64_t)offset + 4 > segment.size) return false;
+
+        uint8_t *p = data.data() + (segment.address - base) + offset;
+        uint32_t value = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        value += segments[target].address;
+        p[0] = (uint8_t)(value >> 24);
+        p[1] = (uint8_t)(value >> 16);
+        p[2] = (uint8_t)(value >> 8);
+        p[3] = (uint8_t)value;
+        return true;
+    }
+};
+
+// Images of the executables loaded so far, by file contents and load base.
+//
+// The host copies a file in through the view of getFileBuffer and calls
+// load, which only parses and relocates files it has not seen at that base
+// before. Damaged files are not kept. The cache holds up to getCapacity()
+// images; loading another one evicts the least recently loaded image and
+// its reference to the frozen code pages, which are freed once no CPU or
+// frozen door shares them any more. Ids of evicted images are not reused.
+class HunkCache {
+    using Key = std::tuple<uint64_t, uint32_t, uint32_t>; // Hash, file size, load base
+
+    struct Entry {
+        HunkImage image;
+        Key key;
+        uint64_t lastUsed;
+    };
+
+    std::vector<uint8_t> file;
+    std::map<int, Entry> images;
+    std::map<Key, int> index;
+    int nextId = 0;
+    uint32_t capacity = 16;
+
+    // Loads so far, for finding the least recently used image
+    uint64_t loads = 0;
+
+    // Files parsed so far (loads that missed the cache)
+    uint32_t parsed = 0;
+
+    void evictLeastRecentlyUsed() {
+        auto oldest = images.begin();
+        for (auto it = images.begin(); it != images.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+        }
+        index.erase(oldest->second.key);
+        images.erase(oldest);
+    }
+
+public:
+    // Makes room for a file of the given size (JS wraps it in a HEAPU8
+    // view and copies the file in)
+    uintptr_t getFileBuffer(uint32_t size) {
+        file.resize(size);
+        return reinterpret_cast<uintptr_t>(file.data());
+    }
+
+    // Id of the image of the file in the buffer at the given load base, or
+    // -1 if the file cannot be loaded
+    int load(uint32_t size, uint32_t base) {
+        if (size > file.size()) return -1;
+
+        // FNV-1a
+        uint64_t hash = 0xCBF29CE484222325;
+        for (uint32_t i = 0; i < size; i++) hash = (hash ^ file[i]) * 0x100000001B3;
+
+        Key key { hash, size, base };
+        if (auto it = index.find(key); it != index.end()) {
+            images.at(it->second).lastUsed = ++loads;
+            return it->second;
+        }
+
+        HunkImage image;
+        parsed++;
+        if (!image.load(file.data(), size, base)) return -1;
+        while (!images.empty() && images.size() >= capacity) evictLeastRecentlyUsed();
+        images.emplace(nextId, Entry { std::move(image), key, ++loads });
+        return index[key] = nextId++;
+    }
+
+    const HunkImage *get(int id) const {
+        auto it = images.find(id);
+        return it != images.end() ? &it->second.image : nullptr;
+    }
+
+    uint32_t getParseCount() { return parsed; }
+
+    // Number of images kept (at least 1), evicting images above it
+    uint32_t getCapacity() { return capacity; }
+    void setCapacity(uint32_t count) {
+        capacity = count > 0 ? count : 1;
+        while (images.size() > capacity) evictLeastRecentlyUsed();
+    }
+    uint32_t getImageCount() { return (uint32_t)images.size(); }
+
+    // Holders of the code pages of an image besides the cache: CPUs that
+    // loaded it and doors frozen from them (their forks share the pages
+    // through the frozen door)
+    uint32_t getCodeShareCount(int id) {
+        return get(id) && get(id)->code ? (uint32_t)get(id)->code.use_count() - 1 : 0;
+    }
+
+    //
+    // Segment table (JS reads it after load)
+    //
+
+    uint32_t getEntryPoint(int id) { return get(id) ? get(id)->entryPoint() : 0; }
+    uint32_t getEnd(int id) { return get(id) ? get(id)->end() : 0; }
+    uint32_t getSegmentCount(int id) { return get(id) ? (uint32_t)get(id)->segments.size() : 0; }
+
+    uint32_t getSegmentAddress(int id, uint32_t segment) {
+        return get(id) && segment < get(id)->segments.size() ? get(id)->segments[segment].address : 0;
+    }
+    uint32_t getSegmentSize(int id, uint32_t segment) {
+        return get(id) && segment < get(id)->segments.size() ? get(id)->segments[segment].size : 0;
+    }
+    uint32_t getSegmentType(int id, uint32_t segment) {
+        return get(id) && segment < get(id)->segments.size() ? (uint32_t)get(id)->segments[segment].type : 0;
+    }
+};
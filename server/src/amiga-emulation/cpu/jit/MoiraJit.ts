@@ -0,0 +1,777 @@
+/**
+ * MoiraJit - Translates hot 68000 loops into WebAssembly
+ *
+ * The CPU counts how often execute() returns to an address and reports hot
+ * ones with ExecEvent.HOT. If the code there is a loop of register-only
+ * instructions closed by a DBcc or Bcc back to its start, it is translated
+ * into a WebAssembly function that runs whole iterations with the same
+ * register, flag and cycle results as the interpreter. The CPU then reports
+ * the address with ExecEvent.JIT and the host runs the function instead.
+ *
+ * Translated code never touches guest memory, so it cannot fault or call a
+ * library; everything else stays with the interpreter. A loop whose code
+ * has been overwritten since it was translated is translated again.
+ */
+
+import { Op, FunctionBuilder, buildModule } from './WasmBuilder';
+
+// WebAssembly is not part of the ES2020 typings
+interface WasmApi {
+  Memory: new (descriptor: { initial: number }) => { buffer: ArrayBuffer };
+  Module: new (bytes: Uint8Array) => object;
+  Instance: new (module: object, imports: object) => { exports: Record<string, unknown> };
+}
+const wasm = (globalThis as unknown as { WebAssembly: WasmApi }).WebAssembly;
+
+// Word offsets in JIT memory (same order as the register file)
+const MEM_D = 0;
+const MEM_A = 8;
+const MEM_PC = 16;
+const MEM_SR = 17;
+export const JIT_REGISTER_WORDS = 18;
+
+// Longest loop body that is translated
+const MAX_INSTRUCTIONS = 64;
+
+type Size = 1 | 2 | 4;
+
+interface Operand {
+  kind: 'd' | 'a' | 'imm';
+  value: number; // Register number or immediate value
+}
+
+interface Instruction {
+  length: number;   // Bytes
+  cycles: number;   // Fixed cost
+  emit(gen: Generator): void;
+}
+
+/**
+ * Reads a big-endian word of guest memory (ILLEGAL outside of guest RAM)
+ */
+export type WordReader = (address: number) => number;
+
+/**
+ * Loop found at a hot address. The body holds instructions and conditional
+ * branches out of the loop; `close` is the branch back to the start.
+ */
+interface Loop {
+  start: number;
+  end: number;      // Address after the closing branch
+  body: (Instruction | Exit)[];
+  close: Close;
+}
+
+interface Exit {
+  exit: true;
+  cc: number;
+  target: number;
+  taken: number;    // Cycles
+  notTaken: number;
+  length: number;
+}
+
+interface Close {
+  kind: 'dbcc' | 'bcc';
+  cc: number;
+  reg: number;      // DBcc counter
+  notTaken: number; // Bcc cycles when falling through
+}
+
+function mask(size: Size): number {
+  return size === 4 ? -1 : size === 2 ? 0xFFFF : 0xFF;
+}
+
+function bits(size: Size): number {
+  return size * 8;
+}
+
+function immCycles(op: Operand, size: Size): number {
+  return op.kind === 'imm' ? (size === 4 ? 8 : 4) : 0;
+}
+
+/**
+ * Code generation state: locals mirror the registers and flags
+ */
+class Generator {
+  readonly fb = new FunctionBuilder();
+  readonly d: number[] = [];
+  readonly a: number[] = [];
+  readonly x: number;
+  readonly n: number;
+  readonly z: number;
+  readonly v: number;
+  readonly c: number;
+  readonly cycles: number;
+  readonly pc: number;
+  readonly t0: number;
+  readonly t1: number;
+  readonly t2: number;
+
+  // Block nesting inside the loop (branch depths)
+  depth = 0;
+
+  constructor() {
+    const fb = this.fb;
+    for (let i = 0; i < 8; i++) this.d.push(fb.local());
+    for (let i = 0; i < 8; i++) this.a.push(fb.local());
+    this.x = fb.local();
+    this.n = fb.local();
+    this.z = fb.local();
+    this.v = fb.local();
+    this.c = fb.local();
+    this.cycles = fb.local();
+    this.pc = fb.local();
+    this.t0 = fb.local();
+    this.t1 = fb.local();
+    this.t2 = fb.local();
+  }
+
+  // Pushes the operand, truncated to size
+  operand(op: Operand, size: Size): void {
+    const fb = this.fb;
+    if (op.kind === 'imm') {
+      fb.const(op.value & mask(size));
+      return;
+    }
+    fb.get(op.kind === 'd' ? this.d[op.value] : this.a[op.value]);
+    if (size !== 4) fb.const(mask(size)).op(Op.I32And);
+  }
+
+  // Writes local `value` (truncated to size) into the low bits of Dn
+  writeD(reg: number, size: Size, value: number): void {
+    const fb = this.fb;
+    if (size === 4) {
+      fb.get(value).set(this.d[reg]);
+      return;
+    }
+    fb.get(this.d[reg]).const(~mask(size)).op(Op.I32And);
+    fb.get(value).const(mask(size)).op(Op.I32And);
+    fb.op(Op.I32Or).set(this.d[reg]);
+  }
+
+  // Pushes bit `bit` of local `value`
+  bit(value: number, bit: number): void {
+    this.fb.get(value).const(bit).op(Op.I32ShrU).const(1).op(Op.I32And);
+  }
+
+  flag(flag: number, emitValue: () => void): void {
+    emitValue();
+    this.fb.set(flag);
+  }
+
+  // N and Z from a truncated result, V and C cleared
+  logicFlags(result: number, size: Size): void {
+    const fb = this.fb;
+    this.flag(this.z, () => fb.get(result).op(Op.I32Eqz));
+    this.flag(this.n, () => this.bit(result, bits(size) - 1));
+    fb.const(0).set(this.v);
+    fb.const(0).set(this.c);
+  }
+
+  // result = (dst + src) & mask with XNZVC (src, dst truncated)
+  add(src: number, dst: number, result: number, size: Size, setX: boolean): void {
+    const fb = this.fb;
+    fb.get(dst).get(src).op(Op.I32Add);
+    if (size === 4) {
+      fb.set(result);
+      this.flag(this.c, () => fb.get(result).get(dst).op(Op.I32LtU));
+    } else {
+      fb.tee(result);
+      fb.const(bits(size)).op(Op.I32ShrU).set(this.c);
+      fb.get(result).const(mask(size)).op(Op.I32And).set(result);
+    }
+    this.flag(this.v, () => {
+      fb.get(src).get(result).op(Op.I32Xor);
+      fb.get(dst).get(result).op(Op.I32Xor);
+      fb.op(Op.I32And).const(bits(size) - 1).op(Op.I32ShrU).const(1).op(Op.I32And);
+    });
+    this.flag(this.z, () => fb.get(result).op(Op.I32Eqz));
+    this.flag(this.n, () => this.bit(result, bits(size) - 1));
+    if (setX) fb.get(this.c).set(this.x);
+  }
+
+  // result = (dst - src) & mask with XNZVC (src, dst truncated)
+  sub(src: number, dst: number, result: number, size: Size, setX: boolean): void {
+    const fb = this.fb;
+    fb.get(dst).get(src).op(Op.I32Sub);
+    if (size !== 4) fb.const(mask(size)).op(Op.I32And);
+    fb.set(result);
+    this.flag(this.c, () => fb.get(src).get(dst).op(Op.I32GtU));
+    this.flag(this.v, () => {
+      fb.get(src).get(dst).op(Op.I32Xor);
+      fb.get(result).get(dst).op(Op.I32Xor);
+      fb.op(Op.I32And).const(bits(size) - 1).op(Op.I32ShrU).const(1).op(Op.I32And);
+    });
+    this.flag(this.z, () => fb.get(result).op(Op.I32Eqz));
+    this.flag(this.n, () => this.bit(result, bits(size) - 1));
+    if (setX) fb.get(this.c).set(this.x);
+  }
+
+  // Pushes the value of condition code cc (0 or 1)
+  condition(cc: number): void {
+    const fb = this.fb;
+    switch (cc) {
+      case 0x0: fb.const(1); break;                                               // T
+      case 0x1: fb.const(0); break;                                               // F
+      case 0x2: fb.get(this.c).get(this.z).op(Op.I32Or).op(Op.I32Eqz); break;    // HI
+      case 0x3: fb.get(this.c).get(this.z).op(Op.I32Or); break;                  // LS
+      case 0x4: fb.get(this.c).op(Op.I32Eqz); break;                             // CC
+      case 0x5: fb.get(this.c); break;                                           // CS
+      case 0x6: fb.get(this.z).op(Op.I32Eqz); break;                             // NE
+      case 0x7: fb.get(this.z); break;                                           // EQ
+      case 0x8: fb.get(this.v).op(Op.I32Eqz); break;                             // VC
+      case 0x9: fb.get(this.v); break;                                           // VS
+      case 0xA: fb.get(this.n).op(Op.I32Eqz); break;                             // PL
+      case 0xB: fb.get(this.n); break;                                           // MI
+      case 0xC: fb.get(this.n).get(this.v).op(Op.I32Eq); break;                  // GE
+      case 0xD: fb.get(this.n).get(this.v).op(Op.I32Ne); break;                  // LT
+      case 0xE:                                                                   // GT
+        fb.get(this.n).get(this.v).op(Op.I32Xor).get(this.z).op(Op.I32Or).op(Op.I32Eqz);
+        break;
+      case 0xF:                                                                   // LE
+        fb.get(this.n).get(this.v).op(Op.I32Xor).get(this.z).op(Op.I32Or);
+        break;
+    }
+  }
+
+  addCycles(cycles: number): void {
+    if (cycles) this.fb.get(this.cycles).const(cycles).op(Op.I32Add).set(this.cycles);
+  }
+
+  // Leaves the function with the given PC (inside the loop, at the current depth)
+  exit(pc: number): void {
+    this.fb.const(pc | 0).set(this.pc).br(this.depth + 1);
+  }
+}
+
+//
+// Instruction decoding
+//
+
+// Data or address register direct, or immediate (mode 7, register 4)
+function sourceOperand(mode: number, reg: number, size: Size, ext: (words: number) => number | null): { op: Operand; words: number } | null {
+  if (mode === 0) return { op: { kind: 'd', value: reg }, words: 0 };
+  if (mode === 1 && size !== 1) return { op: { kind: 'a', value: reg }, words: 0 };
+  if (mode === 7 && reg === 4) {
+    const value = size === 4 ? ext(2) : ext(1);
+    if (value === null) return null;
+    return { op: { kind: 'imm', value }, words: size === 4 ? 2 : 1 };
+  }
+  return null;
+}
+
+type Alu = 'add' | 'sub' | 'and' | 'or' | 'eor' | 'cmp';
+
+function aluInstruction(kind: Alu, src: Operand, dstReg: number, size: Size, length: number, cycles: number): Instruction {
+  return {
+    length,
+    cycles,
+    emit(gen) {
+      const fb = gen.fb;
+      gen.operand(src, size);
+      fb.set(gen.t0);
+      gen.operand({ kind: 'd', value: dstReg }, size);
+      fb.set(gen.t1);
+      switch (kind) {
+        case 'add': gen.add(gen.t0, gen.t1, gen.t2, size, true); break;
+        case 'sub': gen.sub(gen.t0, gen.t1, gen.t2, size, true); break;
+        case 'cmp': gen.sub(gen.t0, gen.t1, gen.t2, size, false); return;
+        default: {
+          const op = kind === 'and' ? Op.I32And : kind === 'or' ? Op.I32Or : Op.I32Xor;
+          fb.get(gen.t1).get(gen.t0).op(op).set(gen.t2);
+          gen.logicFlags(gen.t2, size);
+        }
+      }
+      gen.writeD(dstReg, size, gen.t2);
+    }
+  };
+}
+
+function unaryInstruction(kind: 'clr' | 'neg' | 'not' | 'tst', reg: number, size: Size): Instruction {
+  return {
+    length: 2,
+    cycles: kind === 'tst' || size !== 4 ? 4 : 6,
+    emit(gen) {
+      const fb = gen.fb;
+      switch (kind) {
+        case 'clr': fb.const(0).set(gen.t2); break;
+        case 'tst': gen.operand({ kind: 'd', value: reg }, size); fb.set(gen.t2); break;
+        case 'not':
+          gen.operand({ kind: 'd', value: reg }, size);
+          fb.const(mask(size)).op(Op.I32Xor).set(gen.t2);
+          break;
+        case 'neg':
+          fb.const(0).set(gen.t1);
+          gen.operand({ kind: 'd', value: reg }, size);
+          fb.set(gen.t0);
+          gen.sub(gen.t0, gen.t1, gen.t2, size, true);
+          gen.writeD(reg, size, gen.t2);
+          return;
+      }
+      gen.logicFlags(gen.t2, size);
+      if (kind !== 'tst') gen.writeD(reg, size, gen.t2);
+    }
+  };
+}
+
+// ASd, LSd, ROd with an immediate count (1 - 8)
+function shiftInstruction(type: number, left: boolean, count: number, reg: number, size: Size): Instruction {
+  const width = bits(size);
+  return {
+    length: 2,
+    cycles: (size === 4 ? 8 : 6) + 2 * count,
+    emit(gen) {
+      const fb = gen.fb;
+      const value = gen.t0, result = gen.t2;
+      gen.operand({ kind: 'd', value: reg }, size);
+      fb.set(value);
+
+      if (type === 3) {
+        // ROL, ROR: C is the last bit rotated, X is not affected
+        if (size === 4) {
+          fb.get(value).const(count).op(left ? Op.I32Rotl : Op.I32Rotr).set(result);
+        } else {
+          const [first, second] = left ? [Op.I32Shl, Op.I32ShrU] : [Op.I32ShrU, Op.I32Shl];
+          fb.get(value).const(count).op(first);
+          fb.get(value).const(width - count).op(second);
+          fb.op(Op.I32Or).const(mask(size)).op(Op.I32And).set(result);
+        }
+        gen.logicFlags(result, size);
+        gen.flag(gen.c, () => gen.bit(result, left ? 0 : width - 1));
+        gen.writeD(reg, size, result);
+        return;
+      }
+
+      if (left) {
+        // ASL, LSL: C and X are the last bit shifted out
+        fb.get(value).const(count).op(Op.I32Shl);
+        if (size !== 4) fb.const(mask(size)).op(Op.I32And);
+        fb.set(result);
+        gen.logicFlags(result, size);
+        gen.flag(gen.c, () => gen.bit(value, width - count));
+        if (type === 0) {
+          // ASL: V is set if the sign bit changed at any time
+          if (count >= width) {
+            gen.flag(gen.v, () => fb.get(value).op(Op.I32Eqz).op(Op.I32Eqz));
+          } else {
+            const top = (mask(size) & ~((1 << (width - count - 1)) - 1)) | 0;
+            fb.get(value).const(top).op(Op.I32And).set(gen.t1);
+            gen.flag(gen.v, () => {
+              fb.get(gen.t1).op(Op.I32Eqz);
+              fb.get(gen.t1).const(top).op(Op.I32Eq);
+              fb.op(Op.I32Or).op(Op.I32Eqz);
+            });
+          }
+        }
+      } else {
+        // ASR, LSR: C and X are the last bit shifted out
+        if (type === 0 && size !== 4) {
+          fb.get(value).op(size === 1 ? Op.I32Extend8S : Op.I32Extend16S).set(value);
+        }
+        fb.get(value).const(count).op(type === 0 ? Op.I32ShrS : Op.I32ShrU);
+        if (size !== 4) fb.const(mask(size)).op(Op.I32And);
+        fb.set(result);
+        gen.logicFlags(result, size);
+        gen.flag(gen.c, () => gen.bit(value, count - 1));
+      }
+      fb.get(gen.c).set(gen.x);
+      gen.writeD(reg, size, result);
+    }
+  };
+}
+
+function simpleInstruction(length: number, cycles: number, emit: (gen: Generator) => void): Instruction {
+  return { length, cycles, emit };
+}
+
+/**
+ * Decode the instruction at pc. Returns null for everything the JIT does
+ * not translate; branches are handled by the caller.
+ */
+function decode(read16: (address: number) => number, pc: number): Instruction | null {
+  const opcode = read16(pc);
+  const ext = (words: number): number | null =>
+    words === 2 ? ((read16(pc + 2) << 16) | read16(pc + 4)) : read16(pc + 2);
+
+  const reg = opcode & 7;
+  const mode = (opcode >> 3) & 7;
+  const reg9 = (opcode >> 9) & 7;
+  const sizeBits = (opcode >> 6) & 3;
+  const size = ([1, 2, 4, 0][sizeBits]) as Size;
+
+  switch (opcode >> 12) {
+    case 0x0: {
+      // ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm,Dn
+      if (mode !== 0 || sizeBits === 3 || (opcode & 0x0100)) return null;
+      const kinds: (Alu | null)[] = ['or', 'and', 'sub', 'add', null, 'eor', 'cmp', null];
+      const kind = kinds[reg9];
+      if (!kind) return null;
+      const src = sourceOperand(7, 4, size, ext)!;
+      const cycles = size !== 4 ? 8 : kind === 'cmp' ? 14 : 16;
+      return aluInstruction(kind, src.op, reg, size, 2 + 2 * src.words, cycles);
+    }
+
+    case 0x1: case 0x2: case 0x3: {
+      // MOVE, MOVEA
+      const moveSize = ([0, 1, 4, 2][opcode >> 12]) as Size;
+      const dstMode = (opcode >> 6) & 7;
+      const src = sourceOperand(mode, reg, moveSize, ext);
+      if (!src) return null;
+      const cycles = 4 + immCycles(src.op, moveSize);
+      const length = 2 + 2 * src.words;
+      if (dstMode === 0) {
+        return simpleInstruction(length, cycles, gen => {
+          gen.operand(src.op, moveSize);
+          gen.fb.set(gen.t2);
+          gen.logicFlags(gen.t2, moveSize);
+          gen.writeD(reg9, moveSize, gen.t2);
+        });
+      }
+      if (dstMode === 1 && moveSize !== 1) {
+        return simpleInstruction(length, cycles, gen => {
+          gen.operand(src.op, moveSize);
+          if (moveSize === 2) gen.fb.op(Op.I32Extend16S);
+          gen.fb.set(gen.a[reg9]);
+        });
+      }
+      return null;
+    }
+
+    case 0x4: {
+      if (opcode === 0x4E71) return simpleInstruction(2, 4, () => {}); // NOP
+      if ((opcode & 0xFFF8) === 0x4840) {
+        // SWAP
+        return simpleInstruction(2, 4, gen => {
+          gen.fb.get(gen.d[reg]).const(16).op(Op.I32Rotl).set(gen.d[reg]);
+          gen.logicFlags(gen.d[reg], 4);
+        });
+      }
+      if ((opcode & 0xFFB8) === 0x4880) {
+        // EXT.W, EXT.L
+        const long = (opcode & 0x40) !== 0;
+        return simpleInstruction(2, 4, gen => {
+          gen.fb.get(gen.d[reg]).op(long ? Op.I32Extend16S : Op.I32Extend8S).set(gen.t2);
+          gen.logicFlags(gen.t2, long ? 4 : 2);
+          gen.writeD(reg, long ? 4 : 2, gen.t2);
+        });
+      }
+      if ((opcode & 0xF1C0) === 0x41C0 && (mode === 2 || mode === 5)) {
+        // LEA (An),An / LEA d16(An),An
+        const disp = mode === 5 ? (read16(pc + 2) << 16) >> 16 : 0;
+        return simpleInstruction(mode === 5 ? 4 : 2, mode === 5 ? 8 : 4, gen => {
+          gen.fb.get(gen.a[reg]).const(disp).op(Op.I32Add).set(gen.a[reg9]);
+        });
+      }
+      if (mode !== 0 || sizeBits === 3) return null;
+      switch (opcode & 0xFF00) {
+        case 0x4200: return unaryInstruction('clr', reg, size);
+        case 0x4400: return unaryInstruction('neg', reg, size);
+        case 0x4600: return unaryInstruction('not', reg, size);
+        case 0x4A00: return unaryInstruction('tst', reg, size);
+      }
+      return null;
+    }
+
+    case 0x5: {
+      // ADDQ, SUBQ (DBcc and Scc have size bits 11)
+      if (sizeBits === 3) return null;
+      const quick = reg9 || 8;
+      const subtract = (opcode & 0x0100) !== 0;
+      if (mode === 0) {
+        return aluInstruction(subtract ? 'sub' : 'add', { kind: 'imm', value: quick }, reg, size, 2, size === 4 ? 8 : 4);
+      }
+      if (mode === 1 && size !== 1) {
+        // Address registers: always long, no flags
+        return simpleInstruction(2, 8, gen => {
+          gen.fb.get(gen.a[reg]).const(quick).op(subtract ? Op.I32Sub : Op.I32Add).set(gen.a[reg]);
+        });
+      }
+      return null;
+    }
+
+    case 0x7: {
+      // MOVEQ
+      if (opcode & 0x0100) return null;
+      const value = (opcode << 24) >> 24;
+      return simpleInstruction(2, 4, gen => {
+        gen.fb.const(value).set(gen.d[reg9]);
+        gen.logicFlags(gen.d[reg9], 4);
+      });
+    }
+
+    case 0x8: case 0x9: case 0xB: case 0xC: case 0xD: {
+      const group = opcode >> 12;
+      const opmode = (opcode >> 6) & 7;
+
+      if (opmode === 3 || opmode === 7) {
+        // ADDA, SUBA
+        if (group !== 0x9 && group !== 0xD) return null;
+        const aSize: Size = opmode === 3 ? 2 : 4;
+        const src = sourceOperand(mode, reg, aSize, ext);
+        if (!src) return null;
+        const cycles = 8 + immCycles(src.op, aSize);
+        return simpleInstruction(2 + 2 * src.words, cycles, gen => {
+          const fb = gen.fb;
+          fb.get(gen.a[reg9]);
+          gen.operand(src.op, aSize);
+          if (aSize === 2) fb.op(Op.I32Extend16S);
+          fb.op(group === 0xD ? Op.I32Add : Op.I32Sub).set(gen.a[reg9]);
+        });
+      }
+
+      if (opmode < 3) {
+        // <ea>,Dn forms: OR, SUB, CMP, AND, ADD
+        const kind: Alu = ({ 0x8: 'or', 0x9: 'sub', 0xB: 'cmp', 0xC: 'and', 0xD: 'add' } as Record<number, Alu>)[group];
+        const src = sourceOperand(mode, reg, size, ext);
+        if (!src || (src.op.kind === 'a' && (kind === 'or' || kind === 'and'))) return null;
+        const ea = immCycles(src.op, size);
+        const cycles = kind === 'cmp' ? (size === 4 ? 6 : 4) + ea : size === 4 ? 8 + ea : 4 + ea;
+        return aluInstruction(kind, src.op, reg9, size, 2 + 2 * src.words, cycles);
+      }
+
+      // EOR Dn,Dn (mode 1 is CMPM, the other groups are ADDX, SUBX, ...)
+      if (group === 0xB && mode === 0) {
+        return aluInstruction('eor', { kind: 'd', value: reg9 }, reg, size, 2, size === 4 ? 8 : 4);
+      }
+      return null;
+    }
+
+    case 0xE: {
+      // ASd, LSd, ROd #count,Dn (ROXd and register counts are not translated)
+      if (sizeBits === 3 || (opcode & 0x20)) return null;
+      const type = (opcode >> 3) & 3;
+      if (type === 2) return null;
+      return shiftInstruction(type, (opcode & 0x100) !== 0, reg9 || 8, reg, size);
+    }
+  }
+  return null;
+}
+
+// Branches into the body would need a second entry point
+function closeLoop(loop: Loop): Loop | null {
+  for (const item of loop.body) {
+    if ('exit' in item && item.target >= loop.start && item.target < loop.end) return null;
+  }
+  return loop;
+}
+
+/**
+ * Find the loop starting at start: translatable instructions and forward
+ * branches out of the loop, closed by a DBcc or Bcc back to start
+ */
+function findLoop(read16: WordReader, start: number): Loop | null {
+  const body: (Instruction | Exit)[] = [];
+  let pc = start;
+
+  for (let i = 0; i < MAX_INSTRUCTIONS; i++) {
+    const opcode = read16(pc);
+
+    // DBcc Dn,start
+    if ((opcode & 0xF0F8) === 0x50C8) {
+      const target = (pc + 2 + ((read16(pc + 2) << 16) >> 16)) >>> 0;
+      const cc = (opcode >> 8) & 15;
+      if (target !== start || cc === 0 || body.length === 0) return null;
+      return closeLoop({ start, end: pc + 4, body, close: { kind: 'dbcc', cc, reg: opcode & 7, notTaken: 0 } });
+    }
+
+    // Bcc (not BSR)
+    if ((opcode & 0xF000) === 0x6000 && (opcode & 0x0F00) !== 0x0100) {
+      const cc = (opcode >> 8) & 15;
+      const short = (opcode & 0xFF) !== 0;
+      const disp = short ? (opcode << 24) >> 24 : (read16(pc + 2) << 16) >> 16;
+      const target = (pc + 2 + disp) >>> 0;
+      const length = short ? 2 : 4;
+
+      if (target === start) {
+        if (body.length === 0) return null;
+        return closeLoop({ start, end: pc + length, body, close: { kind: 'bcc', cc, reg: 0, notTaken: short ? 8 : 12 } });
+      }
+      // Other branches must be conditional and leave the loop (checked
+      // once the end is known)
+      if (cc === 0 || (target & 1)) return null;
+      body.push({ exit: true, cc, target, taken: 10, notTaken: short ? 8 : 12, length });
+      pc += length;
+      continue;
+    }
+
+    const instruction = decode(read16, pc);
+    if (!instruction) return null;
+    body.push(instruction);
+    pc += instruction.length;
+  }
+  return null;
+}
+
+/**
+ * Emit the function for a loop: registers in, iterations until the loop
+ * ends or the budget (parameter 0) is used up, registers out. Returns the
+ * cycles executed; the exit PC is stored with the registers.
+ */
+function generate(loop: Loop): Uint8Array {
+  const gen = new Generator();
+  const fb = gen.fb;
+
+  for (let i = 0; i < 8; i++) fb.load(4 * (MEM_D + i)).set(gen.d[i]);
+  for (let i = 0; i < 8; i++) fb.load(4 * (MEM_A + i)).set(gen.a[i]);
+  const flags = [gen.c, gen.v, gen.z, gen.n, gen.x];
+  flags.forEach((flag, bit) => fb.load(4 * MEM_SR).const(bit).op(Op.I32ShrU).const(1).op(Op.I32And).set(flag));
+
+  fb.block();
+  fb.loop();
+
+  let pending = 0;
+  for (const item of loop.body) {
+    if ('exit' in item) {
+      gen.addCycles(pending);
+      pending = 0;
+      gen.condition(item.cc);
+      fb.if();
+      gen.depth++;
+      gen.addCycles(item.taken);
+      gen.exit(item.target);
+      fb.op(Op.End);
+      gen.depth--;
+      pending += item.notTaken;
+      continue;
+    }
+    item.emit(gen);
+    pending += item.cycles;
+  }
+  gen.addCycles(pending);
+
+  const next = loop.end;
+  const close = loop.close;
+  const budgetCheck = () => {
+    // Continue at the loop start in the next run if the budget is used up
+    fb.get(gen.cycles).get(0).op(Op.I32GeS);
+    fb.if();
+    gen.depth++;
+    gen.exit(loop.start);
+    fb.op(Op.End);
+    gen.depth--;
+  };
+
+  if (close.kind === 'dbcc') {
+    // Condition true: fall through (12 cycles)
+    if (close.cc !== 1) {
+      gen.condition(close.cc);
+      fb.if();
+      gen.depth++;
+      gen.addCycles(12);
+      gen.exit(next);
+      fb.op(Op.End);
+      gen.depth--;
+    }
+    // Decrement the low word of the counter; -1 ends the loop (14 cycles)
+    const dn = gen.d[close.reg];
+    fb.get(dn).const(1).op(Op.I32Sub).const(0xFFFF).op(Op.I32And).set(gen.t0);
+    fb.get(dn).const(~0xFFFF).op(Op.I32And).get(gen.t0).op(Op.I32Or).set(dn);
+    fb.get(gen.t0).const(0xFFFF).op(Op.I32Eq);
+    fb.if();
+    gen.depth++;
+    gen.addCycles(14);
+    gen.exit(next);
+    fb.op(Op.End);
+    gen.depth--;
+    gen.addCycles(10);
+    budgetCheck();
+    fb.br(0);
+  } else {
+    gen.condition(close.cc);
+    fb.if();
+    gen.depth++;
+    gen.addCycles(10);
+    budgetCheck();
+    fb.br(1);
+    fb.op(Op.End);
+    gen.depth--;
+    gen.addCycles(close.notTaken);
+    fb.const(next | 0).set(gen.pc);
+  }
+
+  fb.op(Op.End); // loop
+  fb.op(Op.End); // block
+
+  for (let i = 0; i < 8; i++) fb.store(4 * (MEM_D + i), () => fb.get(gen.d[i]));
+  for (let i = 0; i < 8; i++) fb.store(4 * (MEM_A + i), () => fb.get(gen.a[i]));
+  fb.store(4 * MEM_PC, () => fb.get(gen.pc));
+  fb.store(4 * MEM_SR, () => {
+    fb.load(4 * MEM_SR).const(~0x1F).op(Op.I32And);
+    flags.forEach((flag, bit) => fb.get(flag).const(bit).op(Op.I32Shl).op(Op.I32Or));
+  });
+  fb.get(gen.cycles);
+
+  return buildModule(fb);
+}
+
+interface CompiledLoop {
+  code: Uint16Array; // Loop code when it was translated
+  run: (budget: number) => number;
+}
+
+/**
+ * Translated loops of one emulator
+ */
+export class MoiraJit {
+  // Register exchange area shared by all translated functions
+  private static memory: { buffer: ArrayBuffer } | null = null;
+
+  private loops: Map<number, CompiledLoop> = new Map();
+
+  private static registers(): Uint32Array {
+    if (!MoiraJit.memory) MoiraJit.memory = new wasm.Memory({ initial: 1 });
+    return new Uint32Array(MoiraJit.memory.buffer, 0, JIT_REGISTER_WORDS);
+  }
+
+  /**
+   * Translate the loop at pc. Returns false if the code there cannot be
+   * translated.
+   */
+  compile(read16: WordReader, pc: number): boolean {
+    if (pc & 1) return false;
+
+    const loop = findLoop(read16, pc);
+    if (!loop) return false;
+
+    MoiraJit.registers();
+    const module = new wasm.Module(generate(loop));
+    const instance = new wasm.Instance(module, { env: { memory: MoiraJit.memory } });
+    const code = new Uint16Array((loop.end - loop.start) >> 1);
+    code.forEach((_, i) => { code[i] = read16(loop.start + i * 2); });
+    this.loops.set(pc, {
+      code,
+      run: instance.exports.run as (budget: number) => number
+    });
+    return true;
+  }
+
+  /**
+   * Run the loop at pc on the register file (words D0 - A7, PC, SR) until it
+   * ends or about budget cycles have passed. Returns the cycles executed, or
+   * -1 if the loop is unknown or its code has changed.
+   */
+  run(read16: WordReader, pc: number, registers: Uint32Array, budget: number): number {
+    const loop = this.loops.get(pc);
+    if (!loop) return -1;
+
+    // Self-modifying code: translate again
+    const code = loop.code;
+    for (let i = 0; i < code.length; i++) {
+      if (read16(pc + i * 2) !== code[i]) {
+        this.loops.delete(pc);
+        return this.compile(read16, pc) ? this.run(read16, pc, registers, budget) : -1;
+      }
+    }
+
+    const exchange = MoiraJit.registers();
+    exchange.set(registers.subarray(0, JIT_REGISTER_WORDS));
+    const cycles = loop.run(Math.max(1, Math.min(budget, 0x7FFFFFFF)));
+    registers.set(exchange);
+    return cycles;
+  }
+
+  clear(): void {
+    this.loops.clear();
+  }
+}
@@ -0,0 +1,212 @@
+/**
+ * WasmBuilder - Minimal WebAssembly binary encoder for the JIT
+ *
+ * Builds modules with a single function `run(i32) -> i32` that imports its
+ * linear memory as env.memory. Only the instructions the JIT emits are
+ * provided.
+ */
+
+export enum Op {
+  Block = 0x02,
+  Loop = 0x03,
+  If = 0x04,
+  Else = 0x05,
+  End = 0x0b,
+  Br = 0x0c,
+  BrIf = 0x0d,
+  Select = 0x1b,
+  LocalGet = 0x20,
+  LocalSet = 0x21,
+  LocalTee = 0x22,
+  I32Load = 0x28,
+  I32Store = 0x36,
+  I32Const = 0x41,
+  I32Eqz = 0x45,
+  I32Eq = 0x46,
+  I32Ne = 0x47,
+  I32LtS = 0x48,
+  I32LtU = 0x49,
+  I32GtU = 0x4b,
+  I32GeS = 0x4e,
+  I32GeU = 0x4f,
+  I32Add = 0x6a,
+  I32Sub = 0x6b,
+  I32And = 0x71,
+  I32Or = 0x72,
+  I32Xor = 0x73,
+  I32Shl = 0x74,
+  I32ShrS = 0x75,
+  I32ShrU = 0x76,
+  I32Rotl = 0x77,
+  I32Rotr = 0x78,
+  I32Extend8S = 0xc0,
+  I32Extend16S = 0xc1
+}
+
+const BLOCK_VOID = 0x40;
+const TYPE_I32 = 0x7f;
+
+function unsignedLeb(value: number, out: number[]): void {
+  do {
+    let byte = value & 0x7f;
+    value >>>= 7;
+    if (value !== 0) byte |= 0x80;
+    out.push(byte);
+  } while (value !== 0);
+}
+
+function signedLeb(value: number, out: number[]): void {
+  value |= 0;
+  for (;;) {
+    const byte = value & 0x7f;
+    value >>= 7;
+    if ((value === 0 && (byte & 0x40) === 0) || (value === -1 && (byte & 0x40) !== 0)) {
+      out.push(byte);
+      return;
+    }
+    out.push(byte | 0x80);
+  }
+}
+
+/**
+ * Body of the run function. Local 0 is the parameter; locals allocated with
+ * local() are i32 too.
+ */
+export class FunctionBuilder {
+  readonly code: number[] = [];
+  private locals = 1;
+
+  local(): number {
+    return this.locals++;
+  }
+
+  get localCount(): number {
+    return this.locals - 1;
+  }
+
+  op(opcode: Op): this {
+    this.code.push(opcode);
+    return this;
+  }
+
+  get(index: number): this {
+    this.code.push(Op.LocalGet);
+    unsignedLeb(index, this.code);
+    return this;
+  }
+
+  set(index: number): this {
+    this.code.push(Op.LocalSet);
+    unsignedLeb(index, this.code);
+    return this;
+  }
+
+  tee(index: number): this {
+    this.code.push(Op.LocalTee);
+    unsignedLeb(index, this.code);
+    return this;
+  }
+
+  const(value: number): this {
+    this.code.push(Op.I32Const);
+    signedLeb(value, this.code);
+    return this;
+  }
+
+  // Memory accesses of aligned words at a constant address
+  load(address: number): this {
+    this.const(0);
+    this.code.push(Op.I32Load, 2);
+    unsignedLeb(address, this.code);
+    return this;
+  }
+
+  store(address: number, emitValue: () => void): this {
+    this.const(0);
+    emitValue();
+    this.code.push(Op.I32Store, 2);
+    unsignedLeb(address, this.code);
+    return this;
+  }
+
+  block(): this {
+    this.code.push(Op.Block, BLOCK_VOID);
+    return this;
+  }
+
+  loop(): this {
+    this.code.push(Op.Loop, BLOCK_VOID);
+    return this;
+  }
+
+  if(): this {
+    this.code.push(Op.If, BLOCK_VOID);
+    return this;
+  }
+
+  br(depth: number): this {
+    this.code.push(Op.Br);
+    unsignedLeb(depth, this.code);
+    return this;
+  }
+
+  brIf(depth: number): this {
+    this.code.push(Op.BrIf);
+    unsignedLeb(depth, this.code);
+    return this;
+  }
+}
+
+function section(id: number, content: number[], out: number[]): void {
+  out.push(id);
+  unsignedLeb(content.length, out);
+  out.push(...content);
+}
+
+function name(text: string, out: number[]): void {
+  unsignedLeb(text.length, out);
+  for (let i = 0; i < text.length; i++) out.push(text.charCodeAt(i));
+}
+
+/**
+ * Encode a module exporting `run(i32) -> i32` with the given body. The body
+ * must leave the result on the stack.
+ */
+export function buildModule(fn: FunctionBuilder): Uint8Array {
+  const out: number[] = [0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00];
+
+  // Type 0: (i32) -> i32
+  section(1, [1, 0x60, 1, TYPE_I32, 1, TYPE_I32], out);
+
+  // Import env.memory (at least one page)
+  const imports: number[] = [1];
+  name('env', imports);
+  name('memory', imports);
+  imports.push(0x02, 0x00, 1);
+  section(2, imports, out);
+
+  // Function 0 has type 0
+  section(3, [1, 0], out);
+
+  const exports: number[] = [1];
+  name('run', exports);
+  exports.push(0x00, 0);
+  section(7, exports, out);
+
+  const body: number[] = [];
+  if (fn.localCount > 0) {
+    body.push(1);
+    unsignedLeb(fn.localCount, body);
+    body.push(TYPE_I32);
+  } else {
+    body.push(0);
+  }
+  body.push(...fn.code, Op.End);
+
+  const code: number[] = [1];
+  unsignedLeb(body.length, code);
+  code.push(...body);
+  section(10, code, out);
+
+  return Uint8Array.from(out);
+}
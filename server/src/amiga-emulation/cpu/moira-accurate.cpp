@@ -0,0 +1,24 @@
+// Accurate door profile (DoorProfile::ACCURATE): the core for debugging
+// sessions.
+//
+// Compiles Moira and MoiraCPU into their own namespace with the accuracy
+// features enabled: memory accesses are synchronized with the clock, odd
+// word accesses raise address errors, and timing follows the 68000 instead
+// of Musashi. The disassembler and the instruction info table are built.
+// Settings shared by both profiles come from the build script.
+
+#define MOIRA_NAMESPACE                 moira_accurate
+#define MOIRA_PRECISE_TIMING            true
+#define MOIRA_EMULATE_ADDRESS_ERROR     true
+#define MOIRA_EMULATE_FC                true
+#define MOIRA_MIMIC_MUSASHI             false
+#define MOIRA_ENABLE_DASM               true
+#define MOIRA_BUILD_INSTR_INFO_TABLE    true
+
+#include "Moira.cpp"
+#include "MoiraDebugger.cpp"
+#include "moira-cpu.cpp"
+
+template <> DoorCPU *DoorCPU::create<DoorProfile::ACCURATE>(size_t memSize) {
+    return new moira_accurate::MoiraCPU(memSize, DoorProfile::ACCURATE);
+}
@@ -0,0 +1,51 @@
+#include "moira-cpu.h"
+
+#if MOIRA_VIRTUAL_API == false
+
+// Client API for the statically dispatched build. Every Moira instance in
+// this module is a MoiraCPU, so the memory calls forward to it without a
+// virtual call. Build with -flto to let the fast paths inline into the core.
+
+namespace MOIRA_NAMESPACE {
+
+static inline const MoiraCPU *door(const Moira *cpu) {
+    return static_cast<const MoiraCPU *>(cpu);
+}
+
+static inline MoiraCPU *door(Moira *cpu) {
+    return static_cast<MoiraCPU *>(cpu);
+}
+
+void Moira::sync(int cycles) { clock += cycles; }
+
+u8 Moira::read8(u32 addr) const { return door(this)->memRead8(addr); }
+u16 Moira::read16(u32 addr) const { return door(this)->memRead16(addr); }
+u16 Moira::read16OnReset(u32 addr) const { return door(this)->memRead16(addr); }
+u16 Moira::read16Dasm(u32 addr) const { return door(this)->memRead16(addr); }
+void Moira::write8(u32 addr, u8 val) const { door(this)->memWrite8(addr, val); }
+void Moira::write16(u32 addr, u16 val) const { door(this)->memWrite16(addr, val); }
+u16 Moira::readIrqUserVector(u8 level) const { return 0; }
+bool Moira::willCacheBlock(u32 addr) { return door(this)->cacheCode(addr); }
+
+void Moira::cpuDidReset() { }
+void Moira::cpuDidHalt() { }
+
+void Moira::willExecute(const char *func, Instr I, Mode M, Size S, u16 opcode) { }
+void Moira::didExecute(const char *func, Instr I, Mode M, Size S, u16 opcode) { }
+void Moira::willExecute(M68kException exc, u16 vector) { door(this)->exceptionWillExecute(exc); }
+void Moira::didExecute(M68kException exc, u16 vector) { door(this)->exceptionDidExecute(exc); }
+void Moira::willInterrupt(u8 level) { }
+void Moira::didJumpToVector(int nr, u32 addr) { }
+
+void Moira::didChangeCACR(u32 value) { }
+void Moira::didChangeCAAR(u32 value) { }
+
+void Moira::didReachSoftstop(u32 addr) { }
+void Moira::didReachBreakpoint(u32 addr) { }
+void Moira::didReachWatchpoint(u32 addr) { }
+void Moira::didReachCatchpoint(u8 vector) { }
+void Moira::didReachSoftwareTrap(u32 addr) { }
+
+}
+
+#endif
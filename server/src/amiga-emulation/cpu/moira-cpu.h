@@ -0,0 +1,1143 @@
+#pragma once
+
+#include "moira-source/Moira/Moira.h"
+#include "door-cpu.h"
+#include "guest-memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace MOIRA_NAMESPACE {
+
+// Door CPU: a 68000 with paged guest memory and the library trap window.
+//
+// The memory interface is implemented by the non-virtual mem* functions.
+// With MOIRA_VIRTUAL_API enabled they are reached through the usual virtual
+// overrides; with it disabled, moira-cpu.cpp defines the Moira:: client API
+// and forwards to them directly, so the compiler can inline the fast path.
+// The fast path is a GuestMemory page lookup; everything else (library
+// traps, writes to ROM, bus errors on unmapped pages) is handled in the
+// cold mem*Slow functions.
+//
+// The class lives in the namespace of its core (MOIRA_NAMESPACE), so that
+// the fast and the accurate door profile can be linked into one program.
+class MoiraCPU final : public Moira, public DoorCPU {
+public:
+    // Library calls land in the top 64 KB of the 24-bit address space
+    static constexpr u32 TRAP_WINDOW_START = 0x00FF0000;
+
+    // Opcode returned when fetching from a library vector
+    static constexpr u16 RTS = 0x4E75;
+
+    // Return address pushed by the host before starting a door. Fetching it
+    // ends the run with ExecEvent::EXIT; it is never a library vector.
+    static constexpr u32 EXIT_ADDRESS = TRAP_WINDOW_START;
+
+    // Library base the host stores at address 4
+    static constexpr u32 EXEC_BASE = 0x00FF8000;
+
+    // exec.library memory functions serviced by the CPU (see callExec)
+    static constexpr i32 LVO_ALLOC_MEM = -198;
+    static constexpr i32 LVO_FREE_MEM = -210;
+    static constexpr i32 LVO_AVAIL_MEM = -216;
+    static constexpr i32 LVO_ALLOC_VEC = -684;
+    static constexpr i32 LVO_FREE_VEC = -690;
+
+    // AllocAbs passes its arguments in the same registers as FreeMem, but
+    // the heap cannot hand out blocks at given addresses, so it goes to the
+    // host
+    static constexpr i32 LVO_ALLOC_ABS = -204;
+
+    // Console functions serviced by the CPU (see callConsole). Doors reach
+    // dos.library with JSR $FFFFFFxx, AEDoor.library relative to ExecBase
+    // (DosLibrary.ts, AmiExpressLibrary.ts).
+    static constexpr u32 DOS_BASE = 0x01000000;
+    static constexpr i32 LVO_READ = -42;
+    static constexpr i32 LVO_WRITE = -48;
+    static constexpr i32 LVO_INPUT = -54;
+    static constexpr i32 LVO_OUTPUT = -60;
+    static constexpr i32 LVO_AE_PUTS = -552;
+    static constexpr i32 LVO_AE_GETS = -562;
+    static constexpr i32 LVO_AE_PUTCH = -572;
+    static constexpr i32 LVO_AE_GETCH = -582;
+
+    // Standard file handles of DosLibrary.ts
+    static constexpr u32 STDIN_HANDLE = 1;
+    static constexpr u32 STDOUT_HANDLE = 2;
+    static constexpr u32 STDERR_HANDLE = 3;
+
+    // Memory requirements (MEMF_*)
+    static constexpr u32 MEMF_CLEAR = 1u << 16;
+    static constexpr u32 MEMF_LARGEST = 1u << 17;
+    static constexpr u32 MEMF_TOTAL = 1u << 19;
+
+private:
+    DoorProfile profile;
+    GuestMemory memory;
+    GuestHeap heap;
+    std::shared_ptr<DoorConsole> console = std::make_shared<DoorConsole>();
+    std::function<void(i32)> trapHandler;
+
+    // Second fetch of the last library call serviced by the CPU (JSR also
+    // prefetches the word after the vector)
+    u32 servicedFetch = 0;
+
+    // Batched trap mode: library calls stop executeCycles instead of
+    // invoking the trap handler from inside the instruction fetch
+    bool batchedTraps = false;
+    EventRecord event {};
+
+    RegisterFile regs {};
+
+    // Set while the CPU processes a bus error (a second one halts the CPU)
+    bool inBusError = false;
+
+    // Address of the last bus error (0 if none, page 0 is always RAM)
+    u32 busFaultAddress = 0;
+
+    // JIT profiling: executions of the addresses execute() returned to.
+    // Addresses are hashed into a small table; a collision restarts the
+    // count. Compiled and rejected addresses are marked by the host.
+    struct JitSlot {
+        u32 pc;
+        u32 count;
+    };
+    static constexpr int JIT_SLOTS = 1024;
+    static constexpr u32 JIT_COMPILED = UINT32_MAX;
+    static constexpr u32 JIT_REJECTED = UINT32_MAX - 1;
+    u32 jitThreshold = 0;   // 0 disables profiling
+    JitSlot jitSlots[JIT_SLOTS] {};
+
+    // Block cache: number of times the door overwrote cached code, per page.
+    // Pages with self-modifying code (or data next to code) stop being cached.
+    static constexpr u8 MAX_CODE_REWRITES = 8;
+    u8 codeRewrites[GuestMemory::PAGE_COUNT] {};
+
+public:
+    MoiraCPU(size_t memSize, DoorProfile profile = DoorProfile::FAST) :
+        profile(profile), memory(memSize, TRAP_WINDOW_START) {
+        cpuModel = Model::M68000;
+    }
+
+    DoorProfile getProfile() override {
+        return profile;
+    }
+
+    //
+    // Memory interface
+    //
+
+    u8 memRead8(u32 addr) const {
+        u8 value;
+        if (memory.read8(addr, value)) [[likely]] return value;
+        return memRead8Slow(addr);
+    }
+
+    u16 memRead16(u32 addr) const {
+        u16 value;
+        if (memory.read16(addr, value)) [[likely]] return value;
+        return memRead16Slow(addr);
+    }
+
+    void memWrite8(u32 addr, u8 val) const {
+        if (memory.write8(addr, val)) [[likely]] return;
+        memWriteSlow(addr, val, false);
+    }
+
+    void memWrite16(u32 addr, u16 val) const {
+        if (memory.write16(addr, val)) [[likely]] return;
+        memWriteSlow(addr, val, true);
+    }
+
+    [[gnu::noinline, gnu::cold]] u8 memRead8Slow(u32 addr) const {
+        if (memory.typeOf(addr) != GuestMemory::PageType::TRAP) {
+            busError(addr, false);
+            return 0;
+        }
+
+        // The trap window reads as a sequence of RTS instructions
+        return (addr & 1) ? (u8)RTS : (u8)(RTS >> 8);
+    }
+
+    [[gnu::noinline, gnu::cold]] u16 memRead16Slow(u32 addr) const {
+        // A word crossing into the next page is read byte by byte, so that
+        // each byte comes from its own page
+        if ((addr & GuestMemory::PAGE_MASK) == GuestMemory::PAGE_MASK) {
+            return (u16)(memRead8(addr) << 8 | memRead8((addr + 1) & GuestMemory::ADDRESS_MASK));
+        }
+
+        if (memory.typeOf(addr) != GuestMemory::PageType::TRAP) {
+            busError(addr, false);
+            return 0;
+        }
+
+        // Only instruction fetches are library calls. Data reads relative to
+        // a library base (e.g. lib_Version) must not invoke the handler, and
+        // neither must the fetches a faulting instruction makes after the fault.
+        if ((readFC() & 3) == FC::USER_PROG && !(flags & State::FAULT)) {
+
+            // The RTS into the exit address also prefetches the next word
+            if ((addr & ~2u) == EXIT_ADDRESS) {
+                raise(ExecEvent::EXIT);
+                return RTS;
+            }
+
+            // Library calls serviced right here never reach the host
+            auto self = const_cast<MoiraCPU *>(this);
+            if (addr == servicedFetch) {
+                self->servicedFetch = 0;
+                return RTS;
+            }
+            if (self->callExec(addr) || self->callConsole(addr)) {
+                self->servicedFetch = addr + 2;
+                return RTS;
+            }
+
+            // Sign-extend to get the library offset
+            // E.g., 0x00FFFFC4 -> 0xFFFFFFC4 -> -60
+            i32 offset = addr >= 0x00FF8000 ? (i32)(addr | 0xFF000000) : (i32)addr;
+
+            if (batchedTraps) {
+                // Record the first fetch only (JSR also prefetches the next word)
+                if (event.reason == ExecEvent::BUDGET) {
+                    raise(ExecEvent::TRAP);
+                    const_cast<MoiraCPU *>(this)->event.offset = offset;
+                }
+            } else if (trapHandler) {
+                trapHandler(offset);
+            }
+        }
+
+        // Return RTS instruction so execution continues
+        return RTS;
+    }
+
+    // Writes to ROM and to the trap window are ignored. Writes to code pages
+    // drop the block cache if they hit cached code. The first write to a
+    // page commits it (see GuestMemory). A word crossing into the next page
+    // is written byte by byte, so that each page is committed on its own.
+    [[gnu::noinline, gnu::cold]] void memWriteSlow(u32 addr, u16 val, bool word) const {
+        if (word && (addr & GuestMemory::PAGE_MASK) == GuestMemory::PAGE_MASK) {
+            memWrite8(addr, (u8)(val >> 8));
+            memWrite8((addr + 1) & GuestMemory::ADDRESS_MASK, (u8)val);
+            return;
+        }
+
+        auto self = const_cast<MoiraCPU *>(this);
+        switch (memory.typeOf(addr)) {
+
+            case GuestMemory::PageType::UNMAPPED:
+                busError(addr, true);
+                break;
+
+            case GuestMemory::PageType::RAM:
+                if (self->memory.commit(addr)) {
+                    if (word) memWrite16(addr, val);
+                    else memWrite8(addr, (u8)val);
+                }
+                break;
+
+            case GuestMemory::PageType::CODE: {
+                self->memory.commit(addr);
+                if (isCachedCode(addr)) {
+                    u8 &rewrites = self->codeRewrites[(addr & GuestMemory::ADDRESS_MASK) >> GuestMemory::PAGE_BITS];
+                    if (rewrites < MAX_CODE_REWRITES) rewrites++;
+                    self->flushCode();
+                }
+                u8 *p = self->memory.data() + addr;
+                if (word) *p++ = (u8)(val >> 8);
+                *p = (u8)val;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    // Services the exec.library memory functions (registers as in the
+    // autodocs). Returns false for every other call, and while no heap is
+    // set up, leaving the call to the host.
+    bool callExec(u32 addr) {
+        if (!heap.total()) return false;
+
+        switch ((i32)(addr - EXEC_BASE)) {
+            case LVO_ALLOC_MEM: reg.d[0] = allocMem(reg.d[0], reg.d[1]); return true;
+            case LVO_FREE_MEM: freeMem(reg.a[1], reg.d[0]); return true;
+            case LVO_AVAIL_MEM: reg.d[0] = availMem(reg.d[1]); return true;
+            case LVO_ALLOC_VEC: reg.d[0] = allocVec(reg.d[0], reg.d[1]); return true;
+            case LVO_FREE_VEC: freeVec(reg.a[1]); return true;
+            case LVO_ALLOC_ABS: return false;
+            default: return false;
+        }
+    }
+
+    // Services the console functions on the standard handles. Returns false
+    // for every other call, and for output that does not fit into the ring;
+    // the host drains the ring before it services the call.
+    bool callConsole(u32 addr) {
+        switch ((i32)(addr - DOS_BASE)) {
+            case LVO_INPUT: reg.d[0] = STDIN_HANDLE; return true;
+            case LVO_OUTPUT: reg.d[0] = STDOUT_HANDLE; return true;
+
+            case LVO_READ:
+                if (reg.d[1] != STDIN_HANDLE) return false;
+                reg.d[0] = consoleRead(reg.d[2], reg.d[3], false);
+                return true;
+
+            case LVO_WRITE:
+                if (reg.d[1] != STDOUT_HANDLE && reg.d[1] != STDERR_HANDLE) return false;
+                if (!consoleWrite(reg.d[2], reg.d[3])) return false;
+                reg.d[0] = reg.d[3];
+                return true;
+        }
+
+        switch ((i32)(addr - EXEC_BASE)) {
+            case LVO_AE_PUTS: {
+                // The string pointer is in A1, A0 or A2, whichever is set
+                u32 str = reg.a[1] >= 0x1000 ? reg.a[1] : reg.a[0] >= 0x1000 ? reg.a[0] : reg.a[2];
+                if (str < 0x1000) return true;
+                return consoleWrite(str, stringLength(str));
+            }
+
+            case LVO_AE_GETS: {
+                // One line, NUL-terminated, D0 = its length
+                u32 length = reg.d[0] ? consoleRead(reg.a[0], reg.d[0] - 1, true) : 0;
+                if (length) memory.fill(reg.a[0] + length, 0, 1);
+                reg.d[0] = length;
+                return true;
+            }
+
+            case LVO_AE_PUTCH: {
+                u8 c = (u8)reg.d[0];
+                return console->output.push(&c, 1) == 1;
+            }
+
+            case LVO_AE_GETCH: {
+                u8 c;
+                reg.d[0] = console->input.pop(&c, 1) ? c : UINT32_MAX;
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    // Length of a NUL-terminated string (up to the end of RAM)
+    u32 stringLength(u32 addr) const {
+        u32 length = 0;
+        for (u32 left = memory.clipLength(addr, UINT32_MAX); left;) {
+            u32 chunk = std::min(left, GuestMemory::PAGE_SIZE - ((addr + length) & GuestMemory::PAGE_MASK));
+            const u8 *p = memory.hostData(addr + length);
+            if (auto end = (const u8 *)std::memchr(p, 0, chunk)) return length + (u32)(end - p);
+            length += chunk;
+            left -= chunk;
+        }
+        return length;
+    }
+
+    // Copies a buffer into the output ring, all or nothing
+    bool consoleWrite(u32 addr, u32 length) {
+        length = memory.clipLength(addr, length);
+        if (length > console->output.space()) return false;
+        for (u32 done = 0; done < length;) {
+            u32 chunk = std::min(length - done, GuestMemory::PAGE_SIZE - ((addr + done) & GuestMemory::PAGE_MASK));
+            console->output.push(memory.hostData(addr + done), chunk);
+            done += chunk;
+        }
+        return true;
+    }
+
+    // Copies up to length bytes of input into guest RAM, up to the end of
+    // the first line if line is set. Returns the number of bytes.
+    u32 consoleRead(u32 addr, u32 length, bool line) {
+        length = memory.clipLength(addr, length);
+        invalidateCode(addr, length);
+        memory.commit(addr, length);
+        u8 *p = memory.data() + addr;
+        if (!line) return (u32)console->input.pop(p, length);
+
+        u32 count = 0;
+        while (count < length && console->input.pop(p + count, 1)) {
+            if (p[count++] == '\r' || p[count - 1] == '\n') break;
+        }
+        return count;
+    }
+
+    // Raises a bus error for an access to an unmapped page. Without C++
+    // exceptions (MOIRA_THROW_FAULTS=false), the fault is recorded and the
+    // access returns.
+    void busError(u32 addr, bool write) const {
+        auto self = const_cast<MoiraCPU *>(this);
+
+        // Only the first fault of an instruction counts
+        if (flags & State::FAULT) return;
+
+        // A bus error while stacking a bus error frame halts the CPU
+        if (inBusError) return signalFault(DoubleFault());
+        self->busFaultAddress = addr;
+
+        StackFrame frame;
+        frame.fc = readFC();
+        frame.code = (u16)((getIRD() & 0xFFE0) | frame.fc | (write ? 0 : 0x10));
+        frame.addr = addr;
+        frame.ird = getIRD();
+        frame.sr = self->getSR();
+        frame.pc = getPC();
+        frame.ssw = frame.fc;
+        signalFault(BusError(frame));
+    }
+
+    // Throws a fault, or records it for the core (see MOIRA_THROW_FAULTS)
+    template <typename Fault> void signalFault(const Fault &exc) const {
+#if MOIRA_THROW_FAULTS == true
+        throw exc;
+#else
+        const_cast<MoiraCPU *>(this)->raiseFault(exc);
+#endif
+    }
+
+    // Ends the current slice after the running instruction
+    void raise(ExecEvent reason) const {
+        auto self = const_cast<MoiraCPU *>(this);
+        if (event.reason == ExecEvent::BUDGET) self->event.reason = reason;
+        self->horizon = 0;
+    }
+
+    // Counts the execution of the address the CPU has arrived at and raises
+    // HOT when it gets hot, or JIT when the host has compiled it
+    bool profileJit() {
+        JitSlot &slot = jitSlots[(reg.pc >> 1) & (JIT_SLOTS - 1)];
+        if (slot.pc != reg.pc) {
+            slot = { reg.pc, 1 };
+            return false;
+        }
+        switch (slot.count) {
+            case JIT_COMPILED: raise(ExecEvent::JIT); break;
+            case JIT_REJECTED: return false;
+            default:
+                if (++slot.count < jitThreshold) return false;
+                slot.count = JIT_REJECTED; // Until the host has decided
+                // Idle loops are fast-forwarded already
+                if (isBranchToSelf()) return false;
+                raise(ExecEvent::HOT);
+        }
+        event.pc = reg.pc;
+        return true;
+    }
+
+    // Block cache: code in RAM pages may be cached, unless the door kept
+    // overwriting it
+    bool cacheCode(u32 addr) {
+        if (codeRewrites[(addr & GuestMemory::ADDRESS_MASK) >> GuestMemory::PAGE_BITS] >= MAX_CODE_REWRITES) return false;
+        return memory.protectCode(addr);
+    }
+
+    // Drops all cached code and lets CPU writes take the fast path again
+    void flushCode() {
+        flushBlocks();
+        memory.unprotectCode();
+    }
+
+    void exceptionWillExecute(M68kException exc) {
+        switch (exc) {
+
+            case M68kException::BUS_ERROR:
+                inBusError = true;
+                [[fallthrough]];
+
+            case M68kException::ADDRESS_ERROR:
+                if (event.reason == ExecEvent::BUDGET) event.pc = reg.pc0;
+                raise(ExecEvent::FAULT);
+                break;
+
+            case M68kException::ILLEGAL:
+            case M68kException::LINEA:
+            case M68kException::LINEF:
+                if (event.reason == ExecEvent::BUDGET) event.pc = reg.pc0;
+                raise(ExecEvent::ILLEGAL);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void exceptionDidExecute(M68kException exc) {
+        if (exc == M68kException::BUS_ERROR) inBusError = false;
+    }
+
+#if MOIRA_VIRTUAL_API == true
+
+    bool willCacheBlock(u32 addr) override { return cacheCode(addr); }
+
+    u8 read8(u32 addr) const override { return memRead8(addr); }
+    u16 read16(u32 addr) const override { return memRead16(addr); }
+    void write8(u32 addr, u8 val) const override { memWrite8(addr, val); }
+    void write16(u32 addr, u16 val) const override { memWrite16(addr, val); }
+
+    void willExecute(M68kException exc, u16 vector) override { exceptionWillExecute(exc); }
+    void didExecute(M68kException exc, u16 vector) override { exceptionDidExecute(exc); }
+
+#endif
+
+    //
+    // Host access to guest RAM
+    //
+
+    void setMemoryByte(uint32_t addr, uint8_t value) override {
+        if (addr < memory.size()) {
+            invalidateCode(addr, 1);
+            memory.commit(addr);
+            memory.data()[addr] = value;
+        }
+    }
+
+    uint8_t getMemoryByte(uint32_t addr) override {
+        return (addr < memory.size()) ? *memory.hostData(addr) : 0;
+    }
+
+    // Guest RAM location inside the WASM heap (JS wraps it in a HEAPU8 view).
+    // Pages must be committed before the host accesses them through it.
+    uintptr_t getMemoryPointer() override {
+        return reinterpret_cast<uintptr_t>(memory.data());
+    }
+
+    // Guest RAM size (the requested size rounded up to whole pages)
+    uint32_t getMemorySize() override {
+        return memory.size();
+    }
+
+    // Clip a block transfer to the end of guest RAM
+    uint32_t clipLength(uint32_t addr, uint32_t length) const {
+        return memory.clipLength(addr, length);
+    }
+
+    // Fill a block of guest RAM (MEMF_CLEAR, BSS clearing)
+    void fillMemory(uint32_t addr, uint8_t value, uint32_t length) override {
+        invalidateCode(addr, length);
+        memory.fill(addr, value, length);
+    }
+
+    // Copy a block inside guest RAM (ranges may overlap)
+    void copyMemory(uint32_t dst, uint32_t src, uint32_t length) override {
+        invalidateCode(dst, length);
+        memory.copy(dst, src, length);
+    }
+
+    // Drops the block cache if the range holds cached code. The host calls
+    // this before writing to guest RAM through its own view.
+    void invalidateCode(uint32_t addr, uint32_t length) override {
+        uint32_t end = addr + memory.clipLength(addr, length);
+        for (uint32_t line = addr & ~63u; line < end; line += 64) {
+            if (isCachedCode(line)) {
+                flushCode();
+                return;
+            }
+        }
+    }
+
+    // Page types (GuestMemory::PageType, one byte per 4 KB page) inside the
+    // WASM heap. The host only needs invalidateCode for CODE pages.
+    uintptr_t getPageTypesPointer() override {
+        return reinterpret_cast<uintptr_t>(memory.pageTypes());
+    }
+
+    // Make a range of guest RAM read-only for the CPU (host writes still work)
+    void protectMemory(uint32_t addr, uint32_t length) override {
+        memory.map(addr, length, GuestMemory::PageType::ROM);
+    }
+
+    // Address of the last bus error since reset (0 if none)
+    uint32_t getBusFault() override {
+        return busFaultAddress;
+    }
+
+    // Gives pages their own copy in guest RAM, before the host accesses
+    // them through the memory pointer
+    void commitMemory(uint32_t addr, uint32_t length) override {
+        memory.commit(addr, length);
+    }
+
+    // Where the CPU reads a byte of guest RAM from, which for untouched and
+    // shared pages is not the memory pointer. Lets the host read them
+    // without committing them.
+    uintptr_t getReadPointer(uint32_t addr) override {
+        return reinterpret_cast<uintptr_t>(memory.hostData(std::min(addr, memory.size())));
+    }
+
+    // Page backings (one byte per 4 KB page) inside the WASM heap
+    uintptr_t getPageBackingPointer() override {
+        return reinterpret_cast<uintptr_t>(memory.pageBackings());
+    }
+
+    // Pages still shared with a door image
+    uint32_t getSharedPageCount() override {
+        return memory.sharedPageCount();
+    }
+
+    // Pages with their own copy in guest RAM
+    uint32_t getCommittedPageCount() override {
+        return memory.committedPageCount();
+    }
+
+    GuestMemory &getMemory() override {
+        return memory;
+    }
+
+    bool loadHunks(HunkCache *cache, int id) override {
+        const HunkImage *image = cache->get(id);
+        if (!image || image->end() > memory.size()) return false;
+
+        // Code pages are shared with every CPU loading the image, the rest
+        // is copied
+        u32 length = (u32)image->data.size();
+        invalidateCode(image->base, length);
+        memory.sharePages(image->code);
+        for (u32 offset = 0; offset < length;) {
+            u32 addr = image->base + offset;
+            u32 chunk = std::min(length - offset, GuestMemory::PAGE_SIZE - (addr & GuestMemory::PAGE_MASK));
+            u32 page = addr >> GuestMemory::PAGE_BITS;
+            if (page >= image->code->pages.size() || !image->code->pages[page]) {
+                memory.write(addr, image->data.data() + offset, chunk);
+            }
+            offset += chunk;
+        }
+        return true;
+    }
+
+    //
+    // exec.library memory functions
+    //
+
+    // Sets up the heap over [start, end) of guest RAM (the host keeps it
+    // clear of the door's hunks and stack)
+    void initHeap(uint32_t start, uint32_t end) override {
+        heap.init(start, std::min(end, memory.size()));
+    }
+
+    // Returns 0 if no block is large enough
+    uint32_t allocMem(uint32_t size, uint32_t requirements) override {
+        uint32_t addr = heap.alloc(size);
+        if (addr && (requirements & MEMF_CLEAR)) fillMemory(addr, 0, size);
+        return addr;
+    }
+
+    // The heap knows the size of every block, so size is not needed.
+    // Addresses that were never allocated are ignored.
+    void freeMem(uint32_t addr, uint32_t size) override {
+        heap.free(addr);
+    }
+
+    // Like Exec, stores the size of the block in the longword in front of it
+    uint32_t allocVec(uint32_t size, uint32_t requirements) override {
+        if (size == 0 || size > UINT32_MAX - 4) return 0;
+        uint32_t addr = allocMem(size + 4, requirements);
+        if (!addr) return 0;
+
+        invalidateCode(addr, 4);
+        memory.commit(addr, 4);
+        u8 *p = memory.data() + addr;
+        for (int i = 0; i < 4; i++) p[i] = (u8)((size + 4) >> (24 - 8 * i));
+        return addr + 4;
+    }
+
+    void freeVec(uint32_t addr) override {
+        if (addr) heap.free(addr - 4);
+    }
+
+    // Free memory, the largest free block (MEMF_LARGEST) or the heap size
+    // (MEMF_TOTAL)
+    uint32_t availMem(uint32_t requirements) override {
+        if (requirements & MEMF_TOTAL) return heap.total();
+        if (requirements & MEMF_LARGEST) return heap.largest();
+        return heap.available();
+    }
+
+    GuestHeap &getHeap() override {
+        return heap;
+    }
+
+    //
+    // Console
+    //
+
+    // Staging buffer inside the WASM heap (JS wraps it in a HEAPU8 view)
+    uintptr_t getConsoleBufferPointer() override {
+        return reinterpret_cast<uintptr_t>(console->buffer);
+    }
+
+    uint32_t readOutput() override {
+        return console->readOutput();
+    }
+
+    uint32_t writeInput(uint32_t length) override {
+        return console->writeInput(length);
+    }
+
+    uint32_t readInput(uint32_t length) override {
+        return console->readInput(length);
+    }
+
+    uint32_t pendingInput() override {
+        return (uint32_t)console->input.size();
+    }
+
+    std::shared_ptr<DoorConsole> getConsole() override {
+        return console;
+    }
+
+    //
+    // Running the CPU
+    //
+
+    // Set trap handler (called with the library offset of each library call)
+    void setTrapHandler(std::function<void(i32)> handler) {
+        trapHandler = std::move(handler);
+    }
+
+    // Enable or disable batched trap mode
+    void setBatchedTraps(bool enable) override {
+        batchedTraps = enable;
+    }
+
+    // Event record location inside the WASM heap (JS wraps it in a HEAPU32 view)
+    uintptr_t getEventRecordPointer() override {
+        return reinterpret_cast<uintptr_t>(&event);
+    }
+
+    const EventRecord &getEventRecord() const override {
+        return event;
+    }
+
+    // Register file location inside the WASM heap (JS wraps it in a HEAPU32 view)
+    uintptr_t getRegisterFilePointer() override {
+        return reinterpret_cast<uintptr_t>(&regs);
+    }
+
+    // Copy the CPU registers into the register file
+    void publishRegisters() {
+        for (int i = 0; i < 8; i++) regs.d[i] = reg.d[i];
+        for (int i = 0; i < 8; i++) regs.a[i] = reg.a[i];
+        regs.pc = reg.pc;
+        regs.sr = getSR();
+        regs.usp = getUSP();
+        regs.isp = getISP();
+        regs.dirty = 0;
+    }
+
+    // Load host changes from the register file into the CPU
+    void loadRegisters() {
+        if (!regs.dirty) return;
+        clock += regs.cycles;
+        regs.cycles = 0;
+        if (regs.pc != reg.pc) {
+            // Refill the prefetch queue at the new PC (code in RAM)
+            u16 ird, irc;
+            if (memory.read16(regs.pc & GuestMemory::ADDRESS_MASK, ird) &&
+                memory.read16((regs.pc + 2) & GuestMemory::ADDRESS_MASK, irc)) {
+                setIRD(ird);
+                setIRC(irc);
+            }
+        }
+        setSR((u16)regs.sr);
+        setUSP(regs.usp);
+        setISP(regs.isp);
+        for (int i = 0; i < 8; i++) reg.d[i] = regs.d[i];
+        for (int i = 0; i < 8; i++) reg.a[i] = regs.a[i];
+        reg.pc = reg.pc0 = regs.pc;
+        regs.dirty = 0;
+    }
+
+    // Load the registers set by the host for a pending library call and let
+    // the CPU continue with the RTS fetched from the library vector
+    void completeTrap() override {
+        loadRegisters();
+        if (event.reason == ExecEvent::TRAP) event.reason = ExecEvent::BUDGET;
+    }
+
+    // Reset CPU
+    void resetCPU() override {
+        event = {};
+        servicedFetch = 0;
+        inBusError = false;
+        busFaultAddress = 0;
+        reset();
+        publishRegisters();
+    }
+
+    // Run until something needs the host: a library call (batched trap
+    // mode), the exit address, STOP, a halt, an illegal instruction or a
+    // fault. Otherwise returns after maxCycles, or with IDLE if the door
+    // spins in a branch to itself. The register file and the event record
+    // are published when it returns.
+    ExecEvent executeUntilEvent(int maxCycles) override {
+        completeTrap();
+        i64 startClock = getClock();
+        i64 startIdle = getIdleCycles();
+        event = {};
+
+        i64 target = startClock + maxCycles;
+        horizon = target;
+        while (clock < target) {
+            execute();
+            if (event.reason != ExecEvent::BUDGET) [[unlikely]] break;
+            if (jitThreshold && clock < target && profileJit()) break;
+            if (flags & (State::STOPPED | State::HALTED)) [[unlikely]] {
+                event.reason = (flags & State::HALTED) ? ExecEvent::HALTED : ExecEvent::STOP;
+                break;
+            }
+        }
+        horizon = 0;
+
+        event.cycles = (u32)(getClock() - startClock);
+        event.idle = (u32)(getIdleCycles() - startIdle);
+        if (event.reason == ExecEvent::BUDGET && event.idle && isBranchToSelf()) {
+            event.reason = ExecEvent::IDLE;
+        }
+        publishRegisters();
+        return event.reason;
+    }
+
+    // Checks if the next instruction is a Bcc.b or Bcc.w to itself (not BSR)
+    bool isBranchToSelf() const {
+        if ((queue.ird & 0xF000) != 0x6000 || (queue.ird & 0x0F00) == 0x0100) return false;
+        return (queue.ird & 0xFF) == 0xFE || ((queue.ird & 0xFF) == 0 && queue.irc == 0xFFFE);
+    }
+
+    // Enable JIT profiling: an address reached threshold times raises HOT
+    // (0 disables it)
+    void setJitThreshold(uint32_t threshold) override {
+        jitThreshold = threshold;
+    }
+
+    // Host decision for an address reported by HOT: compiled addresses raise
+    // JIT from now on, rejected ones are not reported again
+    void setJitEntry(uint32_t pc, bool compiled) override {
+        jitSlots[(pc >> 1) & (JIT_SLOTS - 1)] = { pc, compiled ? JIT_COMPILED : JIT_REJECTED };
+    }
+
+    // Execute cycles (returns cycles executed via getClock). In batched
+    // trap mode, execution stops at events like executeUntilEvent.
+    int executeCycles(int cycles) override {
+        if (!batchedTraps) {
+            i64 startClock = getClock();
+            completeTrap();
+            execute(cycles);
+            publishRegisters();
+            return (int)(getClock() - startClock);
+        }
+
+        executeUntilEvent(cycles);
+        return (int)event.cycles;
+    }
+
+    // Get registers (0 - 7: D0 - D7, 8 - 15: A0 - A7, 16: PC, 17: SR)
+    uint32_t getRegister(int reg) override {
+        loadRegisters();
+        if (reg < 8) return this->reg.d[reg];
+        if (reg < 16) return this->reg.a[reg - 8];
+        if (reg == 16) return this->reg.pc;
+        if (reg == 17) return getSR();
+        return 0;
+    }
+
+    // Set registers
+    void setRegister(int reg, uint32_t value) override {
+        loadRegisters();
+        if (reg < 8) this->reg.d[reg] = value;
+        else if (reg < 16) this->reg.a[reg - 8] = value;
+        else if (reg == 16) this->reg.pc = value;
+        else if (reg == 17) setSR(value);
+        publishRegisters();
+    }
+
+    // Cycles executed since the CPU was created
+    int64_t getClock() const override {
+        return clock;
+    }
+
+    //
+    // Switching profiles
+    //
+
+    // Captures the state a CPU of another profile needs to continue. Host
+    // changes to the register file are loaded first.
+    void saveState(DoorState &state) override {
+        loadRegisters();
+        publishRegisters();
+        state.regs = regs;
+        state.event = event;
+        state.clock = clock;
+        state.ird = getIRD();
+        state.irc = getIRC();
+        state.stopped = flags & State::STOPPED;
+        state.halted = flags & State::HALTED;
+        state.batchedTraps = batchedTraps;
+        state.busFault = busFaultAddress;
+        state.jitThreshold = jitThreshold;
+    }
+
+    // The trap handler is not taken over (the bindings use batched traps)
+    void takeOver(DoorCPU *other) override {
+        DoorState state;
+        other->saveState(state);
+
+        // Code pages turn back into RAM pages, the block cache starts empty
+        flushCode();
+        memory.copyFrom(other->getMemory());
+        heap = other->getHeap();
+        console = other->getConsole();
+        loadState(state);
+    }
+
+    // Brings the core out of its power-up state, then loads the registers,
+    // the prefetch queue and the run state of a saved CPU
+    void loadState(const DoorState &state) {
+        reset();
+        regs = state.regs;
+        regs.dirty = 1;
+        regs.cycles = 0;
+        loadRegisters();
+        setIRD(state.ird);
+        setIRC(state.irc);
+        clock = state.clock;
+        flags &= ~(State::STOPPED | State::HALTED);
+        if (state.stopped) flags |= State::STOPPED;
+        if (state.halted) flags |= State::HALTED;
+
+        event = state.event;
+        batchedTraps = state.batchedTraps;
+        busFaultAddress = state.busFault;
+        inBusError = false;
+        servicedFetch = 0;
+        jitThreshold = state.jitThreshold;
+        for (JitSlot &slot : jitSlots) slot = {};
+        for (u8 &rewrites : codeRewrites) rewrites = 0;
+    }
+
+    //
+    // Snapshots
+    //
+
+    // Execution flags kept in an image besides STOPPED and HALTED (the
+    // others follow from SR and the debugger)
+    static constexpr int SNAPSHOT_FLAGS = State::LOGGING | State::TRACE_EXC;
+
+    void saveSnapshot(DoorSnapshot *snapshot) override {
+        writeSnapshot(*snapshot, true);
+    }
+
+    // The console and the trap handler stay as they are
+    bool restoreSnapshot(DoorSnapshot *snapshot) override {
+        return readSnapshot(*snapshot, nullptr);
+    }
+
+    void freeze(DoorImage *image) override {
+        writeSnapshot(image->state, false);
+        image->ram = memory.freeze();
+    }
+
+    bool fork(DoorImage *image) override {
+        return image->ram && readSnapshot(image->state, image->ram);
+    }
+
+    // Writes the image, with or without the guest RAM pages
+    void writeSnapshot(DoorSnapshot &out, bool withRam) {
+        DoorState state;
+        saveState(state);
+
+        out.clear();
+        out.put32(DoorSnapshot::MAGIC);
+        out.put32(DoorSnapshot::VERSION);
+        out.put32(memory.size());
+
+        for (u32 value : state.regs.d) out.put32(value);
+        for (u32 value : state.regs.a) out.put32(value);
+        out.put32(state.regs.pc);
+        out.put16((u16)state.regs.sr);
+        out.put32(state.regs.usp);
+        out.put32(state.regs.isp);
+        out.put16(state.ird);
+        out.put16(state.irc);
+        out.put8(ipl);
+        out.put8(reg.ipl);
+        out.put8((u8)(state.stopped | state.halted << 1));
+        out.put32((u32)(flags & SNAPSHOT_FLAGS));
+        out.put64((u64)state.clock);
+        out.put64((u64)idleCycles);
+
+        out.put32((u32)state.event.reason);
+        out.put32((u32)state.event.offset);
+        out.put32(state.event.pc);
+        out.put32(state.event.cycles);
+        out.put32(state.event.idle);
+        out.put8(state.batchedTraps);
+        out.put32(state.busFault);
+        out.put32(state.jitThreshold);
+
+        for (const Guards *guards : { (const Guards *)&debugger.breakpoints,
+                                      (const Guards *)&debugger.watchpoints,
+                                      (const Guards *)&debugger.catchpoints }) {
+            out.put32((u32)guards->elements());
+            for (long nr = 0; nr < guards->elements(); nr++) {
+                const Guard *guard = guards->guardNr(nr);
+                out.put32(guard->addr);
+                out.put8(guard->enabled);
+                out.put32((u32)guard->ignore);
+            }
+        }
+
+        // Page types as (type, count) runs. Code pages are RAM pages to
+        // everyone but the block cache.
+        const GuestMemory::PageType *types = memory.pageTypes();
+        auto typeOf = [&](u32 page) {
+            return types[page] == GuestMemory::PageType::CODE ? GuestMemory::PageType::RAM : types[page];
+        };
+        for (u32 page = 0; page < GuestMemory::PAGE_COUNT;) {
+            u32 count = 1;
+            while (page + count < GuestMemory::PAGE_COUNT && typeOf(page + count) == typeOf(page)) count++;
+            out.put8((u8)typeOf(page));
+            out.put32(count);
+            page += count;
+        }
+
+        std::vector<GuestHeap::Allocation> used = heap.allocations();
+        out.put32(heap.start());
+        out.put32(heap.end());
+        out.put32((u32)used.size());
+        for (const GuestHeap::Allocation &block : used) {
+            out.put32(block.addr);
+            out.put32(block.size);
+        }
+
+        // Pages that are all zero are left out
+        u32 pages = withRam ? memory.size() >> GuestMemory::PAGE_BITS : 0;
+        size_t countPos = out.data.size();
+        u32 stored = 0;
+        out.put32(0);
+        for (u32 page = 0; page < pages; page++) {
+            const u8 *p = memory.hostData(page << GuestMemory::PAGE_BITS);
+            if (GuestMemory::isZeroPage(p)) continue;
+            out.put32(page);
+            out.putBytes(p, GuestMemory::PAGE_SIZE);
+            stored++;
+        }
+        for (int i = 0; i < 4; i++) out.data[countPos + i] = (u8)(stored >> (8 * i));
+    }
+
+    // Loads an image. With frozen RAM, the guest RAM pages are shared with
+    // it instead of being read from the image.
+    bool readSnapshot(const DoorSnapshot &snapshot, std::shared_ptr<const GuestMemory::Frozen> frozen) {
+        SnapshotReader in(snapshot);
+        if (in.get32() != DoorSnapshot::MAGIC || in.get32() != DoorSnapshot::VERSION ||
+            in.get32() != memory.size()) return false;
+
+        DoorState state {};
+        for (u32 &value : state.regs.d) value = in.get32();
+        for (u32 &value : state.regs.a) value = in.get32();
+        state.regs.pc = in.get32();
+        state.regs.sr = in.get16();
+        state.regs.usp = in.get32();
+        state.regs.isp = in.get32();
+        state.ird = in.get16();
+        state.irc = in.get16();
+        u8 iplPins = in.get8() & 7;
+        u8 polledIpl = in.get8() & 7;
+        u8 runState = in.get8();
+        state.stopped = runState & 1;
+        state.halted = runState & 2;
+        int extraFlags = (int)in.get32() & SNAPSHOT_FLAGS;
+        state.clock = (i64)in.get64();
+        i64 idle = (i64)in.get64();
+
+        state.event.reason = (ExecEvent)in.get32();
+        state.event.offset = (i32)in.get32();
+        state.event.pc = in.get32();
+        state.event.cycles = in.get32();
+        state.event.idle = in.get32();
+        state.batchedTraps = in.get8();
+        state.busFault = in.get32();
+        state.jitThreshold = in.get32();
+        if (state.event.reason > ExecEvent::JIT) return false;
+
+        std::vector<Guard> guards[3];
+        for (auto &list : guards) {
+            u32 count = in.get32();
+            for (u32 i = 0; i < count && in.ok(); i++) {
+                Guard guard;
+                guard.addr = in.get32();
+                guard.enabled = in.get8();
+                guard.ignore = (long)in.get32();
+                list.push_back(guard);
+            }
+        }
+
+        GuestMemory::PageType types[GuestMemory::PAGE_COUNT];
+        for (u32 page = 0; page < GuestMemory::PAGE_COUNT && in.ok();) {
+            u8 type = in.get8();
+            u32 count = in.get32();
+            if (type > (u8)GuestMemory::PageType::TRAP || count == 0 ||
+                count > GuestMemory::PAGE_COUNT - page) return false;
+            std::fill_n(types + page, count, (GuestMemory::PageType)type);
+            page += count;
+        }
+
+        u32 heapStart = in.get32();
+        u32 heapEnd = in.get32();
+        u32 blocks = in.get32();
+        std::vector<GuestHeap::Allocation> used;
+        for (u32 i = 0; i < blocks && in.ok(); i++) {
+            u32 addr = in.get32();
+            used.push_back({ addr, in.get32() });
+        }
+        GuestHeap restored;
+        if (!restored.restore(heapStart, heapEnd, used)) return false;
+
+        u32 pages = in.get32();
+        std::vector<const u8 *> contents(memory.size() >> GuestMemory::PAGE_BITS);
+        if (frozen && (pages || frozen->size() != memory.size())) return false;
+        for (u32 i = 0; i < pages && in.ok(); i++) {
+            u32 page = in.get32();
+            const u8 *bytes = in.getBytes(GuestMemory::PAGE_SIZE);
+            if (page >= contents.size()) return false;
+            contents[page] = bytes;
+        }
+        if (!in.ok() || !in.atEnd()) return false;
+
+        // The image is complete, so nothing can fail from here on
+        flushCode();
+        memory.share(frozen);
+        for (u32 page = 0; page < GuestMemory::PAGE_COUNT; page++) {
+            memory.map(page << GuestMemory::PAGE_BITS, GuestMemory::PAGE_SIZE, types[page]);
+        }
+        for (u32 page = 0; page < contents.size(); page++) {
+            if (contents[page]) memory.write(page << GuestMemory::PAGE_BITS, contents[page], GuestMemory::PAGE_SIZE);
+        }
+        heap = std::move(restored);
+
+        loadState(state);
+        setIPL(iplPins);
+        reg.ipl = polledIpl;
+        flags |= extraFlags | State::CHECK_IRQ;
+        idleCycles = idle;
+
+        Guards *targets[3] = { &debugger.breakpoints, &debugger.watchpoints, &debugger.catchpoints };
+        for (int i = 0; i < 3; i++) {
+            targets[i]->removeAll();
+            for (const Guard &guard : guards[i]) {
+                targets[i]->setAt(guard.addr, guard.ignore);
+                if (!guard.enabled) targets[i]->disableAt(guard.addr);
+            }
+        }
+        publishRegisters();
+        return true;
+    }
+};
+
+}
+
+using namespace MOIRA_NAMESPACE;
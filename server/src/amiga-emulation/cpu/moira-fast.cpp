@@ -0,0 +1,23 @@
+// Fast door profile (DoorProfile::FAST): the core production doors run on.
+//
+// Compiles Moira and MoiraCPU into their own namespace with every accuracy
+// feature a door does not rely on switched off. Settings shared by both
+// profiles (MOIRA_VIRTUAL_API, MOIRA_BLOCK_CACHE, ...) come from the build
+// script. Function codes stay enabled, because library calls are told apart
+// from data reads of the trap window by them.
+
+#define MOIRA_NAMESPACE                 moira_fast
+#define MOIRA_PRECISE_TIMING            false
+#define MOIRA_EMULATE_ADDRESS_ERROR     false
+#define MOIRA_EMULATE_FC                true
+#define MOIRA_MIMIC_MUSASHI             true
+#define MOIRA_ENABLE_DASM               false
+#define MOIRA_BUILD_INSTR_INFO_TABLE    false
+
+#include "Moira.cpp"
+#include "MoiraDebugger.cpp"
+#include "moira-cpu.cpp"
+
+template <> DoorCPU *DoorCPU::create<DoorProfile::FAST>(size_t memSize) {
+    return new moira_fast::MoiraCPU(memSize, DoorProfile::FAST);
+}
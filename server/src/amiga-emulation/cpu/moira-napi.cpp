@@ -0,0 +1,371 @@
+// Node-API bindings of the door CPU (native counterpart of moira-wrapper.cpp)
+//
+// Exposes the same MoiraCPU (DoorCPU), DoorSnapshot, DoorImage, HunkCache and
+// DoorHost classes as the Emscripten module.
+// Pointers returned by the CPU (guest RAM, register file, event records) are
+// native addresses; JS wraps them with memoryView() instead of HEAPU8/HEAPU32.
+
+#include "door-host.h"
+#include <node_api.h>
+#include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+// State of a JS object: the wrapped C++ object and whether JS owns it
+// (contexts returned by DoorHost::getContext are owned by the host)
+template <typename T>
+struct Handle {
+    T *ptr;
+    bool owned;
+};
+
+napi_ref cpuConstructor;
+
+bool exceptionPending(napi_env env) {
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    return pending;
+}
+
+void throwError(napi_env env, const char *message) {
+    if (!exceptionPending(env)) napi_throw_error(env, nullptr, message);
+}
+
+void throwTypeError(napi_env env, const char *message) {
+    if (!exceptionPending(env)) napi_throw_type_error(env, nullptr, message);
+}
+
+// Type tag of the objects wrapping a C, so that an object of another class
+// (or a plain JS object) is never taken for one
+template <typename C>
+const napi_type_tag *typeTag() {
+    static const char id = 0;
+    static const napi_type_tag tag = { 0x446f6f7243505500, (uint64_t)(uintptr_t)&id };
+    return &tag;
+}
+
+template <typename C>
+C *unwrap(napi_env env, napi_value self) {
+    bool tagged = false;
+    napi_check_object_type_tag(env, self, typeTag<C>(), &tagged);
+    if (!tagged) {
+        throwTypeError(env, "Argument is not of the expected class");
+        return nullptr;
+    }
+    Handle<C> *handle = nullptr;
+    napi_unwrap(env, self, reinterpret_cast<void **>(&handle));
+    if (!handle || !handle->ptr) {
+        throwError(env, "Object has been deleted");
+        return nullptr;
+    }
+    return handle->ptr;
+}
+
+//
+// Value conversion
+//
+
+template <typename T>
+T fromJS(napi_env env, napi_value value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        bool result = false;
+        napi_get_value_bool(env, value, &result);
+        return result;
+    } else if constexpr (std::is_pointer_v<T>) {
+        return unwrap<std::remove_pointer_t<T>>(env, value);
+    } else {
+        int64_t result = 0;
+        napi_get_value_int64(env, value, &result);
+        return (T)result;
+    }
+}
+
+napi_value undefined(napi_env env) {
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+template <typename T>
+napi_value toJS(napi_env env, T value) {
+    napi_value result;
+    if constexpr (std::is_same_v<T, bool>) {
+        napi_get_boolean(env, value, &result);
+    } else if constexpr (std::is_same_v<T, DoorCPU *>) {
+        // Non-owning MoiraCPU object (see newCPU)
+        if (!value) return undefined(env);
+        napi_value constructor, external;
+        napi_get_reference_value(env, cpuConstructor, &constructor);
+        napi_create_external(env, value, nullptr, nullptr, &external);
+        napi_new_instance(env, constructor, 1, &external, &result);
+    } else if constexpr (std::is_enum_v<T>) {
+        napi_create_uint32(env, (uint32_t)value, &result);
+    } else {
+        // Integers and native addresses (below 2^53 on every supported platform)
+        napi_create_double(env, (double)value, &result);
+    }
+    return result;
+}
+
+//
+// Method adapters
+//
+
+template <typename C, typename R, typename... A, size_t... I>
+napi_value invoke(napi_env env, napi_callback_info info, R (C::*method)(A...), std::index_sequence<I...>) {
+    size_t argc = sizeof...(A);
+    napi_value argv[sizeof...(A) + 1];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, argv, &self, nullptr);
+    for (size_t i = argc; i < sizeof...(A); i++) argv[i] = undefined(env);
+
+    C *object = unwrap<C>(env, self);
+    if (!object) return nullptr;
+
+    // Object arguments that fail to unwrap leave an exception pending; the
+    // method is not called with a null pointer then
+    std::tuple<std::decay_t<A>...> args { fromJS<std::decay_t<A>>(env, argv[I])... };
+    if (exceptionPending(env)) return nullptr;
+
+    auto call = [&]() -> napi_value {
+        if constexpr (std::is_void_v<R>) {
+            (object->*method)(std::get<I>(args)...);
+            return undefined(env);
+        } else {
+            return toJS(env, (object->*method)(std::get<I>(args)...));
+        }
+    };
+
+#ifdef __cpp_exceptions
+    try {
+        return call();
+    } catch (const std::exception &e) {
+        throwError(env, e.what());
+        return nullptr;
+    }
+#else
+    return call();
+#endif
+}
+
+template <auto Method>
+napi_value method(napi_env env, napi_callback_info info) {
+    return [&]<typename C, typename R, typename... A>(R (C::*m)(A...)) {
+        return invoke(env, info, m, std::index_sequence_for<A...>());
+    }(Method);
+}
+
+template <typename C>
+void finalize(napi_env, void *data, void *) {
+    auto *handle = static_cast<Handle<C> *>(data);
+    if (handle->owned) delete handle->ptr;
+    delete handle;
+}
+
+// delete(): frees the object early, like on embind objects
+template <typename C>
+napi_value destroy(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+    Handle<C> *handle = nullptr;
+    napi_unwrap(env, self, reinterpret_cast<void **>(&handle));
+    if (handle) {
+        if (handle->owned) delete handle->ptr;
+        handle->ptr = nullptr;
+    }
+    return undefined(env);
+}
+
+napi_value wrap(napi_env env, napi_value self, auto *object, bool owned) {
+    using C = std::remove_pointer_t<decltype(object)>;
+    napi_wrap(env, self, new Handle<C> { object, owned }, finalize<C>, nullptr, nullptr);
+    napi_type_tag_object(env, self, typeTag<C>());
+    return self;
+}
+
+//
+// Constructors
+//
+
+// new MoiraCPU(memSize, profile), or (internally) a non-owning wrapper
+// around an external pointer
+napi_value newCPU(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2], self;
+    napi_get_cb_info(env, info, &argc, argv, &self, nullptr);
+
+    napi_valuetype type = napi_undefined;
+    if (argc) napi_typeof(env, argv[0], &type);
+    if (type == napi_external) {
+        void *cpu = nullptr;
+        napi_get_value_external(env, argv[0], &cpu);
+        return wrap(env, self, static_cast<DoorCPU *>(cpu), false);
+    }
+    auto profile = argc > 1 ? fromJS<DoorProfile>(env, argv[1]) : DoorProfile::FAST;
+    return wrap(env, self, DoorCPU::create(fromJS<size_t>(env, argv[0]), profile), true);
+}
+
+napi_value newSnapshot(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+    return wrap(env, self, new DoorSnapshot(), true);
+}
+
+napi_value newImage(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+    return wrap(env, self, new DoorImage(), true);
+}
+
+napi_value newHunkCache(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+    return wrap(env, self, new HunkCache(), true);
+}
+
+napi_value newDoorHost(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+    return wrap(env, self, new DoorHost(), true);
+}
+
+// memoryView(pointer, length): ArrayBuffer over native memory returned by
+// the CPU. The memory is owned by the CPU or host and must outlive the view.
+napi_value memoryView(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    double pointer = 0, length = 0;
+    napi_get_value_double(env, argv[0], &pointer);
+    napi_get_value_double(env, argv[1], &length);
+
+    napi_value buffer;
+    if (napi_create_external_arraybuffer(env, reinterpret_cast<void *>((uintptr_t)pointer), (size_t)length,
+                                         nullptr, nullptr, &buffer) != napi_ok) {
+        throwError(env, "Cannot create a view on native memory");
+        return nullptr;
+    }
+    return buffer;
+}
+
+napi_property_descriptor function(const char *name, napi_callback callback) {
+    return { name, nullptr, callback, nullptr, nullptr, nullptr, napi_default, nullptr };
+}
+
+} // namespace
+
+NAPI_MODULE_INIT() {
+    napi_property_descriptor cpuMethods[] = {
+        function("getProfile", method<&DoorCPU::getProfile>),
+        function("takeOver", method<&DoorCPU::takeOver>),
+        function("saveSnapshot", method<&DoorCPU::saveSnapshot>),
+        function("restoreSnapshot", method<&DoorCPU::restoreSnapshot>),
+        function("freeze", method<&DoorCPU::freeze>),
+        function("fork", method<&DoorCPU::fork>),
+        function("setMemoryByte", method<&DoorCPU::setMemoryByte>),
+        function("getMemoryByte", method<&DoorCPU::getMemoryByte>),
+        function("getMemoryPointer", method<&DoorCPU::getMemoryPointer>),
+        function("getMemorySize", method<&DoorCPU::getMemorySize>),
+        function("fillMemory", method<&DoorCPU::fillMemory>),
+        function("copyMemory", method<&DoorCPU::copyMemory>),
+        function("invalidateCode", method<&DoorCPU::invalidateCode>),
+        function("getPageTypesPointer", method<&DoorCPU::getPageTypesPointer>),
+        function("protectMemory", method<&DoorCPU::protectMemory>),
+        function("getBusFault", method<&DoorCPU::getBusFault>),
+        function("commitMemory", method<&DoorCPU::commitMemory>),
+        function("getPageBackingPointer", method<&DoorCPU::getPageBackingPointer>),
+        function("getReadPointer", method<&DoorCPU::getReadPointer>),
+        function("getSharedPageCount", method<&DoorCPU::getSharedPageCount>),
+        function("getCommittedPageCount", method<&DoorCPU::getCommittedPageCount>),
+        function("loadHunks", method<&DoorCPU::loadHunks>),
+        function("initHeap", method<&DoorCPU::initHeap>),
+        function("allocMem", method<&DoorCPU::allocMem>),
+        function("freeMem", method<&DoorCPU::freeMem>),
+        function("allocVec", method<&DoorCPU::allocVec>),
+        function("freeVec", method<&DoorCPU::freeVec>),
+        function("availMem", method<&DoorCPU::availMem>),
+        function("getConsoleBufferPointer", method<&DoorCPU::getConsoleBufferPointer>),
+        function("readOutput", method<&DoorCPU::readOutput>),
+        function("writeInput", method<&DoorCPU::writeInput>),
+        function("readInput", method<&DoorCPU::readInput>),
+        function("pendingInput", method<&DoorCPU::pendingInput>),
+        function("resetCPU", method<&DoorCPU::resetCPU>),
+        function("executeCycles", method<&DoorCPU::executeCycles>),
+        function("getRegisterFilePointer", method<&DoorCPU::getRegisterFilePointer>),
+        function("setBatchedTraps", method<&DoorCPU::setBatchedTraps>),
+        function("getEventRecordPointer", method<&DoorCPU::getEventRecordPointer>),
+        function("executeUntilEvent", method<&DoorCPU::executeUntilEvent>),
+        function("completeTrap", method<&DoorCPU::completeTrap>),
+        function("setJitThreshold", method<&DoorCPU::setJitThreshold>),
+        function("setJitEntry", method<&DoorCPU::setJitEntry>),
+        function("delete", destroy<DoorCPU>),
+    };
+
+    napi_property_descriptor snapshotMethods[] = {
+        function("getPointer", method<&DoorSnapshot::getPointer>),
+        function("getSize", method<&DoorSnapshot::getSize>),
+        function("resize", method<&DoorSnapshot::resize>),
+        function("delete", destroy<DoorSnapshot>),
+    };
+
+    napi_property_descriptor imageMethods[] = {
+        function("delete", destroy<DoorImage>),
+    };
+
+    napi_property_descriptor hunkMethods[] = {
+        function("getFileBuffer", method<&HunkCache::getFileBuffer>),
+        function("load", method<&HunkCache::load>),
+        function("getParseCount", method<&HunkCache::getParseCount>),
+        function("getCapacity", method<&HunkCache::getCapacity>),
+        function("setCapacity", method<&HunkCache::setCapacity>),
+        function("getImageCount", method<&HunkCache::getImageCount>),
+        function("getCodeShareCount", method<&HunkCache::getCodeShareCount>),
+        function("getEntryPoint", method<&HunkCache::getEntryPoint>),
+        function("getEnd", method<&HunkCache::getEnd>),
+        function("getSegmentCount", method<&HunkCache::getSegmentCount>),
+        function("getSegmentAddress", method<&HunkCache::getSegmentAddress>),
+        function("getSegmentSize", method<&HunkCache::getSegmentSize>),
+        function("getSegmentType", method<&HunkCache::getSegmentType>),
+        function("delete", destroy<HunkCache>),
+    };
+
+    napi_property_descriptor hostMethods[] = {
+        function("createContext", method<&DoorHost::createContext>),
+        function("destroyContext", method<&DoorHost::destroyContext>),
+        function("getContext", method<&DoorHost::getContext>),
+        function("setProfile", method<&DoorHost::setProfile>),
+        function("resume", method<&DoorHost::resume>),
+        function("suspend", method<&DoorHost::suspend>),
+        function("tick", method<&DoorHost::tick>),
+        function("getEventsPointer", method<&DoorHost::getEventsPointer>),
+        function("delete", destroy<DoorHost>),
+    };
+
+    napi_value cpuClass, snapshotClass, imageClass, hunkClass, hostClass;
+    napi_define_class(env, "MoiraCPU", NAPI_AUTO_LENGTH, newCPU, nullptr,
+                      sizeof(cpuMethods) / sizeof(cpuMethods[0]), cpuMethods, &cpuClass);
+    napi_define_class(env, "DoorSnapshot", NAPI_AUTO_LENGTH, newSnapshot, nullptr,
+                      sizeof(snapshotMethods) / sizeof(snapshotMethods[0]), snapshotMethods, &snapshotClass);
+    napi_define_class(env, "DoorImage", NAPI_AUTO_LENGTH, newImage, nullptr,
+                      sizeof(imageMethods) / sizeof(imageMethods[0]), imageMethods, &imageClass);
+    napi_define_class(env, "HunkCache", NAPI_AUTO_LENGTH, newHunkCache, nullptr,
+                      sizeof(hunkMethods) / sizeof(hunkMethods[0]), hunkMethods, &hunkClass);
+    napi_define_class(env, "DoorHost", NAPI_AUTO_LENGTH, newDoorHost, nullptr,
+                      sizeof(hostMethods) / sizeof(hostMethods[0]), hostMethods, &hostClass);
+    napi_create_reference(env, cpuClass, 1, &cpuConstructor);
+
+    napi_value viewFunction;
+    napi_create_function(env, "memoryView", NAPI_AUTO_LENGTH, memoryView, nullptr, &viewFunction);
+
+    napi_set_named_property(env, exports, "MoiraCPU", cpuClass);
+    napi_set_named_property(env, exports, "DoorSnapshot", snapshotClass);
+    napi_set_named_property(env, exports, "DoorImage", imageClass);
+    napi_set_named_property(env, exports, "HunkCache", hunkClass);
+    napi_set_named_property(env, exports, "DoorHost", hostClass);
+    napi_set_named_property(env, exports, "memoryView", viewFunction);
+    return exports;
+}
@@ -10,13 +10,19 @@
 #include "MoiraMacros.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <algorithm>
 #include <cmath>
 #include <bit>
 #include <vector>
 #include <stdexcept>
+#include <map>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
 
-namespace moira {
+namespace MOIRA_NAMESPACE {
 
 using namespace Flag;
 
@@ -28,13 +34,47 @@ using namespace Flag;
 #include "StrWriter_cpp.h"
 #include "MoiraDasm_cpp.h"
 
+// Storage of the block cache (see MOIRA_BLOCK_CACHE)
+struct Moira::BlockCache {
+
+    // Number of blocks (direct-mapped by start address)
+    static constexpr int SLOTS = 512;
+
+    // Maximum number of instructions and code bytes per block
+    static constexpr int INSTRS = 16;
+    static constexpr int BYTES = 128;
+
+    struct Instr {
+
+        ExecPtr handler;
+        u16 opcode;
+        u16 offset;         // Relative to the block start
+    };
+
+    struct Block {
+
+        u32 start;
+        u32 generation;     // Valid if it matches the cache generation
+        u16 count;
+        u16 bytes;          // Size of the copied code
+        Instr instr[INSTRS];
+        u16 words[BYTES / 2];
+    };
+
+    // Incremented by flushBlocks to invalidate all blocks at once
+    u32 generation = 1;
+
+    // One bit for each 64 byte line holding cached code (24 bit addresses)
+    u64 lines[4096] {};
+
+    Block blocks[SLOTS] {};
+
+    void mark(u32 addr) { addr &= 0xFFFFFF; lines[addr >> 12] |= u64(1) << (addr >> 6 & 63); }
+    bool marked(u32 addr) const { addr &= 0xFFFFFF; return lines[addr >> 12] >> (addr >> 6 & 63) & 1; }
+};
+
 Moira::Moira()
 {
-    exec = new ExecPtr[65536];
-    loop = new ExecPtr[65536];
-    if (MOIRA_BUILD_INSTR_INFO_TABLE) info = new InstrInfo[65536];
-    if (MOIRA_ENABLE_DASM) dasm = new DasmPtr[65536];
-
     createJumpTable(cpuModel, dasmModel);
 
     instrStyle = DasmStyle {
@@ -56,10 +96,7 @@ Moira::Moira()
 
 Moira::~Moira()
 {
-    if (exec) delete [] exec;
-    if (loop) delete [] loop;
-    if (info) delete [] info;
-    if (dasm) delete [] dasm;
+    delete blockCache;
 }
 
 void
@@ -71,6 +108,7 @@ Moira::setModel(Model cpuModel, Model dasmModel)
         this->dasmModel = dasmModel;
 
         createJumpTable(cpuModel, dasmModel);
+        flushBlocks();
         
         reg.cacr &= cacrMask();
         flags &= ~State::LOOPING;
@@ -96,10 +134,10 @@ Moira::setNumberFormat(DasmStyle &style, const DasmNumberFormat &value)
     auto validRadix = [&](DasmNumberFormat fmt) { return fmt.radix == 10 || fmt.radix == 16; };
 
     if (!validPrefix(value)) {
-        throw std::runtime_error("prefix must not be NULL");
+        THROW_ERROR("prefix must not be NULL");
     }
     if (!validRadix(value)) {
-        throw std::runtime_error("radix must be 10 or 16");
+        THROW_ERROR("radix must be 10 or 16");
     }
 
     style.numberFormat = value;
@@ -202,6 +240,7 @@ Moira::reset()
     flags = State::CHECK_IRQ;
 
     reg = { };
+    lazy = { };
     reg.sr.s = 1;
     reg.sr.ipl = 7;
 
@@ -255,13 +294,19 @@ Moira::execute()
         // Fast path: Call the instruction handler and return
         //
 
-        reg.pc += 2;
-        try {
-            (this->*exec[queue.ird])(queue.ird);
-        } catch (const std::exception &exc) {
-            processException(exc);
+        if constexpr (MOIRA_BLOCK_CACHE) {
+
+            // Run ahead only inside executeUntil (see MOIRA_BLOCK_CACHE)
+            if (horizon && cpuModel == Model::M68000) {
+
+                PROCESS_FAULTS(executeBlock());
+                return;
+            }
         }
 
+        reg.pc += 2;
+        PROCESS_FAULTS((this->*execHandler(queue.ird))(queue.ird));
+
     } else {
 
         //
@@ -291,11 +336,9 @@ Moira::execute()
         // Process pending interrupt (if any)
         if (flags & CHECK_IRQ) {
 
-            try {
-                if (checkForIrq()) goto done;
-            } catch (const std::exception &exc) {
-                processException(exc);
-            }
+            bool irq = false;
+            PROCESS_FAULTS(irq = checkForIrq());
+            if (irq) goto done;
         }
 
         // If the CPU is stopped, poll the IPL lines and return
@@ -326,15 +369,11 @@ Moira::execute()
         if (flags & LOOPING) {
 
             assert(loop[queue.ird]);
-            (this->*loop[queue.ird])(queue.ird);
+            (this->*loopHandler(queue.ird))(queue.ird);
 
         } else {
 
-            try {
-                (this->*exec[queue.ird])(queue.ird);
-            } catch (const std::exception &exc) {
-                processException(exc);
-            }
+            PROCESS_FAULTS((this->*execHandler(queue.ird))(queue.ird));
         }
 
     done:
@@ -366,9 +405,143 @@ Moira::execute(i64 cycles)
 void
 Moira::executeUntil(i64 cycle)
 {
+    horizon = cycle;
     while (clock < cycle) { execute(); }
+    horizon = 0;
+}
+
+void
+Moira::executeBlock()
+{
+    using Cache = BlockCache;
+
+    if (!blockCache) blockCache = new Cache();
+
+    auto &cache = *blockCache;
+    u32 start = reg.pc;
+    auto &block = cache.blocks[start >> 1 & (Cache::SLOTS - 1)];
+
+    if (block.start == start && block.generation == cache.generation) {
+
+        //
+        // Cache hit: Run the block until it ends or execution leaves it
+        //
+
+        blockWords = block.words;
+        blockStart = start;
+        blockBytes = block.bytes;
+
+        for (int i = 0;;) {
+
+            auto &instr = block.instr[i];
+            reg.pc += 2;
+            (this->*instr.handler)(instr.opcode);
+
+            // Stop on a state change, at the horizon, after a flush, or
+            // if a branch has been taken
+            if (++i == block.count || flags || clock >= horizon || !blockBytes) break;
+            if (reg.pc != start + block.instr[i].offset) break;
+        }
+
+        blockBytes = 0;
+        return;
+    }
+
+    //
+    // Cache miss: Execute normally and record the instructions
+    //
+
+    // Blocks lie within one page and start with two words in it
+    if ((start & 0xFFE) == 0xFFE || !willCacheBlock(start)) {
+
+        reg.pc += 2;
+        (this->*execHandler(queue.ird))(queue.ird);
+        return;
+    }
+
+    u32 generation = cache.generation;
+    block.generation = 0;
+
+    u32 pc = start;
+    int count = 0;
+
+    for (;;) {
+
+        // Mark the code first, so that overwriting it aborts the recording
+        cache.mark(pc);
+        cache.mark(pc + 2);
+
+        u16 opcode = queue.ird;
+        auto handler = execHandler(opcode);
+        block.instr[count++] = { handler, opcode, (u16)(pc - start) };
+        reg.pc += 2;
+        (this->*handler)(opcode);
+
+        if (count == Cache::INSTRS || flags || clock >= horizon) break;
+
+        // Continue with the next instruction unless a branch left the block
+        u32 next = reg.pc;
+        if (next <= pc || next - pc > 10) break;
+        if (next + 4 - start > Cache::BYTES || ((next + 2) ^ start) & 0xFFF000) break;
+        pc = next;
+    }
+
+    // Drop the recording if the code was overwritten or an instruction faulted
+    if (cache.generation != generation || (flags & State::FAULT)) return;
+
+    // Copy the code up to the first extension word of the last instruction
+    block.bytes = (u16)(pc + 4 - start);
+    for (int i = 0; i < block.bytes / 2; i++) {
+        block.words[i] = read16Dasm((start + 2 * i) & 0xFFFFFF);
+    }
+    block.start = start;
+    block.count = (u16)count;
+    block.generation = generation;
+}
+
+void
+Moira::flushBlocks()
+{
+    if (!blockCache) return;
+
+    auto &cache = *blockCache;
+    if (++cache.generation == 0) {
+
+        // Never reuse the generation of old blocks after a wrap-around
+        for (auto &block : cache.blocks) block.generation = 0;
+        cache.generation = 1;
+    }
+    std::fill(std::begin(cache.lines), std::end(cache.lines), 0);
+
+    // Let the executing block fetch from memory and stop after this instruction
+    blockBytes = 0;
+}
+
+bool
+Moira::isCachedCode(u32 addr) const
+{
+    return blockCache && blockCache->marked(addr);
+}
+
+i64
+Moira::skipIdleIterations(i64 max, int cycles)
+{
+    using namespace State;
+
+    // Only skip if nothing can interrupt or observe the loop
+    if (flags & (CHECK_IRQ | TRACING | LOGGING | CHECK_BP | CHECK_WP | CHECK_CP)) return 0;
+
+    // Stop where the regular loop would have crossed the horizon
+    i64 count = std::min(max, (horizon - clock - 1) / cycles);
+    if (count <= 0) return 0;
+
+    clock += count * cycles;
+    idleCycles += count * cycles;
+    return count;
 }
 
+#if MOIRA_THROW_FAULTS == true
+
 void
 Moira::processException(const std::exception &exc)
 {
@@ -385,6 +558,9 @@ Moira::processException(const std::exception &exc)
 template <Core C> void
 Moira::processException(const std::exception &exc)
 {
+    // Leave the executing block (see MOIRA_BLOCK_CACHE)
+    blockBytes = 0;
+
     try {
 
         if (auto ae = dynamic_cast<const AddressError *>(&exc); ae) {
@@ -413,6 +589,64 @@ Moira::processException(const std::exception &exc)
     throw exc;
 }
 
+#endif
+
+void
+Moira::raiseFault(FaultKind kind, const StackFrame &frame)
+{
+    if (flags & State::FAULT) return;
+
+    fault = { kind, frame, reg.pc, reg.pc0 };
+    flags |= State::FAULT;
+}
+
+void
+Moira::processFault()
+{
+    switch (cpuModel) {
+
+        case Model::M68000: processFault<Core::C68000>(); break;
+        case Model::M68010: processFault<Core::C68010>(); break;
+
+        default:
+            processFault<Core::C68020>();
+    }
+}
+
+template <Core C> void
+Moira::processFault()
+{
+    auto pending = fault;
+
+    fault = { };
+    flags &= ~State::FAULT;
+
+    // Leave the executing block (see MOIRA_BLOCK_CACHE)
+    blockBytes = 0;
+
+    // Rewind to where the instruction handler would have been aborted
+    reg.pc = pending.pc;
+    reg.pc0 = pending.pc0;
+
+    switch (pending.kind) {
+
+        case FaultKind::ADDRESS_ERROR: execAddressError<C>(pending.stackFrame); break;
+        case FaultKind::BUS_ERROR: execBusError<C>(pending.stackFrame); break;
+        case FaultKind::DOUBLE_FAULT: halt(); return;
+
+        default:
+            return;
+    }
+
+    // A fault while writing the exception stack frame halts the CPU
+    if (flags & State::FAULT) {
+
+        fault = { };
+        flags &= ~State::FAULT;
+        halt();
+    }
+}
+
 bool
 Moira::checkForIrq()
 {
@@ -454,10 +688,10 @@ u8
 Moira::getCCR() const
 {
     auto result =
-    reg.sr.c << 0 |
-    reg.sr.v << 1 |
-    reg.sr.z << 2 |
-    reg.sr.n << 3 |
+    flagC()  << 0 |
+    flagV()  << 1 |
+    flagZ()  << 2 |
+    flagN()  << 3 |
     reg.sr.x << 4 ;
 
     return u8(result);
@@ -466,6 +700,7 @@ Moira::getCCR() const
 void
 Moira::setCCR(u8 val)
 {
+    lazy.op = FlagOp::NONE;
     reg.sr.c = (val >> 0) & 1;
     reg.sr.v = (val >> 1) & 1;
     reg.sr.z = (val >> 2) & 1;
@@ -861,7 +1096,7 @@ Moira::getInstrInfo(u16 op) const
 
     } else {
 
-        throw std::runtime_error("This feature requires MOIRA_BUILD_INSTR_INFO_TABLE = true\n");
+        THROW_ERROR("This feature requires MOIRA_BUILD_INSTR_INFO_TABLE = true\n");
     }
 }
 
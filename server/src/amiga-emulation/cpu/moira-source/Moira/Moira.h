@@ -10,8 +10,9 @@
 #include "MoiraConfig.h"
 #include "MoiraTypes.h"
 #include "MoiraDebugger.h"
+#include <cstdio>
 
-namespace moira {
+namespace MOIRA_NAMESPACE {
 
 class Moira {
     
@@ -61,9 +62,15 @@ protected:
     
     // The CPU's register set
     Registers reg {};
+
+    // Pending condition codes (MOIRA_LAZY_FLAGS)
+    LazyFlags lazy {};
     
     // Prefetch queue for fetching instructions
     PrefetchQueue queue {};
+
+    // Fault waiting to be processed (MOIRA_THROW_FAULTS == false)
+    PendingFault fault {};
     
     // Interrupt mode
     IrqMode irqMode {IrqMode::AUTO};
@@ -95,26 +102,55 @@ protected:
     // State flags used internally
     int flags {};
     
+    // Cycle up to which executeUntil may run ahead of its clock check, by
+    // skipping idle loops or executing cached blocks. Clients set it to 0 to
+    // stop a block after the current instruction.
+    i64 horizon {};
+    
+    // Number of cycles skipped in idle loops since power-up
+    i64 idleCycles {};
     
+    
+    // Block cache (see MOIRA_BLOCK_CACHE), allocated on first use
+    struct BlockCache;
+    BlockCache *blockCache = nullptr;
+
+    // Code words of the executing block (see readInstrWord)
+    const u16 *blockWords = nullptr;
+    u32 blockStart = 0;
+    u32 blockBytes = 0;
+
+
     //
     // Lookup tables
     //
     
 private:
     
-    // Jump table holding the instruction handlers
+    // Storage for a complete set of lookup tables (see createJumpTable)
+    struct JumpTable;
+    JumpTable *jumpTable = nullptr;
+    
+    // The jump tables map each opcode to an index into a handler table, which
+    // holds every distinct handler once. Index 0 stands for no handler. This
+    // keeps the jump tables at 128 KB each, so the ones in use stay in cache.
     typedef void (Moira::*ExecPtr)(u16);
-    ExecPtr *exec = nullptr;
+    const ExecPtr *execHandlers = nullptr;
+    
+    typedef void (Moira::*DasmPtr)(StrWriter&, u32&, u16) const;
+    const DasmPtr *dasmHandlers = nullptr;
+    
+    // Jump table holding the instruction handlers
+    const u16 *exec = nullptr;
     
     // Jump table holding the loop mode instruction handlers (68010 only)
-    ExecPtr *loop = nullptr;
+    const u16 *loop = nullptr;
     
     // Jump table holding the disassembler handlers
-    typedef void (Moira::*DasmPtr)(StrWriter&, u32&, u16) const;
-    DasmPtr *dasm = nullptr;
+    const u16 *dasm = nullptr;
     
     // Table holding instruction information
-    InstrInfo *info = nullptr;
+    const InstrInfo *info = nullptr;
     
     
     //
@@ -131,15 +167,32 @@ public:
     
 protected:
     
-    // Creates or updates the jump tables for execution and disassembly
+    // Binds the jump tables for execution and disassembly. The tables are
+    // immutable and shared by all instances emulating the same models. They
+    // are built when a model combination is requested for the first time.
     void createJumpTable(Model cpuModel, Model dasmModel);
     void createJumpTable(Model model) { createJumpTable(model, model); }
     
 private:
     
+    // Fills the currently bound tables from scratch
+    void buildJumpTable(Model cpuModel, Model dasmModel);
+    
     // Core routine for creating jump tables
     template <Core C> void createJumpTable(Model model, bool registerDasm);
     
+    // Returns the handler of an opcode
+    ExecPtr execHandler(u16 op) const { return execHandlers[exec[op]]; }
+    ExecPtr loopHandler(u16 op) const { return execHandlers[loop[op]]; }
+    DasmPtr dasmHandler(u16 op) const { return dasmHandlers[dasm[op]]; }
+
+#ifdef MOIRA_TABLE_GENERATOR
+public:
+
+    // Writes the bound tables as C++ source (see MOIRA_STATIC_TABLES)
+    void writeJumpTable(std::FILE *file) const;
+#endif
+    
     
     //
     // Configuring
@@ -226,14 +279,32 @@ public:
     
     // Checks if the CPU is in a HALT state
     bool isHalted() const { return flags & State::HALTED; }
+
+    // Records a fault to be processed after the running instruction handler
+    // (MOIRA_THROW_FAULTS == false). Only the first fault is kept.
+    void raiseFault(const AddressError &exc) { raiseFault(FaultKind::ADDRESS_ERROR, exc.stackFrame); }
+    void raiseFault(const BusError &exc) { raiseFault(FaultKind::BUS_ERROR, exc.stackFrame); }
+    void raiseFault(const DoubleFault &) { raiseFault(FaultKind::DOUBLE_FAULT, { }); }
+    void raiseFault(FaultKind kind, const StackFrame &frame);
     
 private:
     
+    // Executes a cached block, or records a new one (see MOIRA_BLOCK_CACHE)
+    void executeBlock();
+
+    // Fast-forwards up to max iterations of a branch-to-self loop and returns
+    // the number of skipped iterations (see MOIRA_SKIP_IDLE_LOOPS)
+    i64 skipIdleIterations(i64 max, int cycles);
+    
     // Processes an exception that was caught during execution
     void processException(const std::exception &exception);
     
     // Processes an exception for a specific CPU core type
     template <Core C> void processException(const std::exception &exception);
+
+    // Processes the pending fault (MOIRA_THROW_FAULTS == false)
+    void processFault();
+    template <Core C> void processFault();
     
     // Performs a core-specific reset routine
     template <Core C> void reset();
@@ -255,7 +326,7 @@ public:
     int disassemble(char *str, u32 addr) const;
     
     // Creates a textual representation of the status register
-    void disassembleSR(char *str) const { disassembleSR(str, reg.sr); }
+    void disassembleSR(char *str) const;
     
     // Creates a textual representation of a given status register
     void disassembleSR(char *str, const StatusRegister &sr) const;
@@ -302,6 +373,11 @@ protected:
     // Provides the interrupt vector for a given interrupt level in USER mode
     virtual u16 readIrqUserVector(u8 level) const { return 0; }
 
+    // Asks if the code at the given address may be cached (MOIRA_BLOCK_CACHE).
+    // Return true only if the client calls flushBlocks() before cached code
+    // in this 4 KB page is overwritten.
+    virtual bool willCacheBlock(u32 addr) { return false; }
+
     
     //
     // State delegates
@@ -394,6 +470,9 @@ protected:
     // Provides the interrupt vector for a given interrupt level in USER mode
     u16 readIrqUserVector(u8 level) const;
 
+    // Asks if the code at the given address may be cached (MOIRA_BLOCK_CACHE)
+    bool willCacheBlock(u32 addr);
+
     
     //
     // State delegates
@@ -478,6 +557,22 @@ public:
     // Sets the CPU clock cycle count
     void setClock(i64 val) { clock = val; }
     
+    // Returns the number of cycles skipped in idle loops (MOIRA_SKIP_IDLE_LOOPS)
+    i64 getIdleCycles() const { return idleCycles; }
+
+    
+    //
+    // Managing the block cache (MOIRA_BLOCK_CACHE)
+    //
+    
+public:
+    
+    // Discards all cached blocks
+    void flushBlocks();
+    
+    // Checks if the address lies in a 64 byte line holding cached code
+    bool isCachedCode(u32 addr) const;
+    
     
     //
     // Accessing registers
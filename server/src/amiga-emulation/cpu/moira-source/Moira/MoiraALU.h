@@ -13,6 +13,16 @@
 template <Cond C> bool evalCond();
 template <Instr I> bool cond();
 
+// Lazily evaluated condition codes (MOIRA_LAZY_FLAGS)
+template <Core C> static constexpr bool lazyFlags();
+template <Core C, Instr I> static constexpr bool keepsLazyFlags();
+template <Size S> void setLazyFlags(FlagOp op, u32 op1, u32 op2, u64 result);
+void materializeFlags();
+bool flagN() const;
+bool flagZ() const;
+bool flagV() const;
+bool flagC() const;
+
 // Shift instructions (ASx, LSx, ROx, ROXx)
 template <Core C, Instr I, Size S> u32 shift(int cnt, u64 data);
 
@@ -62,6 +62,120 @@ template <Size S> u32 WRITE(u32 d1, u32 d2) {
     if constexpr (S == Long) return d2;
 }
 
+template <Core C> constexpr bool
+Moira::lazyFlags()
+{
+    return MOIRA_LAZY_FLAGS && C == Core::C68000;
+}
+
+template <Core C, Instr I> constexpr bool
+Moira::keepsLazyFlags()
+{
+    if constexpr (!lazyFlags<C>()) return false;
+
+    // Instructions that do not access the condition codes, or only through
+    // the functions that handle pending flags (addsub, cmp, logic, cond)
+    switch (I) {
+
+        case Instr::ADD:  case Instr::ADDI: case Instr::ADDQ: case Instr::ADDA:
+        case Instr::SUB:  case Instr::SUBI: case Instr::SUBQ: case Instr::SUBA:
+        case Instr::CMP:  case Instr::CMPA: case Instr::CMPI: case Instr::CMPM:
+        case Instr::AND:  case Instr::ANDI: case Instr::OR:   case Instr::ORI:
+        case Instr::EOR:  case Instr::EORI:
+        case Instr::BRA:  case Instr::BSR:  case Instr::BHI:  case Instr::BLS:
+        case Instr::BCC:  case Instr::BCS:  case Instr::BNE:  case Instr::BEQ:
+        case Instr::BVC:  case Instr::BVS:  case Instr::BPL:  case Instr::BMI:
+        case Instr::BGE:  case Instr::BLT:  case Instr::BGT:  case Instr::BLE:
+        case Instr::DBT:  case Instr::DBF:  case Instr::DBHI: case Instr::DBLS:
+        case Instr::DBCC: case Instr::DBCS: case Instr::DBNE: case Instr::DBEQ:
+        case Instr::DBVC: case Instr::DBVS: case Instr::DBPL: case Instr::DBMI:
+        case Instr::DBGE: case Instr::DBLT: case Instr::DBGT: case Instr::DBLE:
+        case Instr::ST:   case Instr::SF:   case Instr::SHI:  case Instr::SLS:
+        case Instr::SCC:  case Instr::SCS:  case Instr::SNE:  case Instr::SEQ:
+        case Instr::SVC:  case Instr::SVS:  case Instr::SPL:  case Instr::SMI:
+        case Instr::SGE:  case Instr::SLT:  case Instr::SGT:  case Instr::SLE:
+        case Instr::JMP:  case Instr::JSR:  case Instr::RTS:  case Instr::LEA:
+        case Instr::PEA:  case Instr::MOVEA: case Instr::EXG: case Instr::NOP:
+
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+template <Size S> void
+Moira::setLazyFlags(FlagOp op, u32 op1, u32 op2, u64 result)
+{
+    lazy.op = op;
+    lazy.msb = MSBIT<S>();
+    lazy.op1 = op1;
+    lazy.op2 = op2;
+    lazy.result = result;
+}
+
+void
+Moira::materializeFlags()
+{
+    if (lazy.op == FlagOp::NONE) return;
+
+    reg.sr.n = flagN();
+    reg.sr.z = flagZ();
+    reg.sr.v = flagV();
+    reg.sr.c = flagC();
+    lazy.op = FlagOp::NONE;
+}
+
+bool
+Moira::flagN() const
+{
+    if (MOIRA_LAZY_FLAGS && lazy.op != FlagOp::NONE) return lazy.result & lazy.msb;
+    return reg.sr.n;
+}
+
+bool
+Moira::flagZ() const
+{
+    if (MOIRA_LAZY_FLAGS && lazy.op != FlagOp::NONE) return !(lazy.result & (((u64)lazy.msb << 1) - 1));
+    return reg.sr.z;
+}
+
+bool
+Moira::flagV() const
+{
+    if (MOIRA_LAZY_FLAGS) {
+
+        switch (lazy.op) {
+
+            case FlagOp::ADD:   return (lazy.op1 ^ lazy.result) & (lazy.op2 ^ lazy.result) & lazy.msb;
+            case FlagOp::SUB:   return (lazy.op1 ^ lazy.op2) & (lazy.op2 ^ lazy.result) & lazy.msb;
+            case FlagOp::LOGIC: return false;
+
+            default:
+                break;
+        }
+    }
+    return reg.sr.v;
+}
+
+bool
+Moira::flagC() const
+{
+    if (MOIRA_LAZY_FLAGS) {
+
+        switch (lazy.op) {
+
+            case FlagOp::ADD:
+            case FlagOp::SUB:   return lazy.result & ((u64)lazy.msb << 1);
+            case FlagOp::LOGIC: return false;
+
+            default:
+                break;
+        }
+    }
+    return reg.sr.c;
+}
+
 template <Cond C> bool
 Moira::evalCond() {
 
@@ -69,20 +183,20 @@ Moira::evalCond() {
 
         case Cond::BT: return true;
         case Cond::BF: return false;
-        case Cond::HI: return !reg.sr.c && !reg.sr.z;
-        case Cond::LS: return reg.sr.c || reg.sr.z;
-        case Cond::CC: return !reg.sr.c;
-        case Cond::CS: return reg.sr.c;
-        case Cond::NE: return !reg.sr.z;
-        case Cond::EQ: return reg.sr.z;
-        case Cond::VC: return !reg.sr.v;
-        case Cond::VS: return reg.sr.v;
-        case Cond::PL: return !reg.sr.n;
-        case Cond::MI: return reg.sr.n;
-        case Cond::GE: return reg.sr.n == reg.sr.v;
-        case Cond::LT: return reg.sr.n != reg.sr.v;
-        case Cond::GT: return reg.sr.n == reg.sr.v && !reg.sr.z;
-        case Cond::LE: return reg.sr.n != reg.sr.v || reg.sr.z;
+        case Cond::HI: return !flagC() && !flagZ();
+        case Cond::LS: return flagC() || flagZ();
+        case Cond::CC: return !flagC();
+        case Cond::CS: return flagC();
+        case Cond::NE: return !flagZ();
+        case Cond::EQ: return flagZ();
+        case Cond::VC: return !flagV();
+        case Cond::VS: return flagV();
+        case Cond::PL: return !flagN();
+        case Cond::MI: return flagN();
+        case Cond::GE: return flagN() == flagV();
+        case Cond::LT: return flagN() != flagV();
+        case Cond::GT: return flagN() == flagV() && !flagZ();
+        case Cond::LE: return flagN() != flagV() || flagZ();
 
         default:
             fatalError;
@@ -357,6 +471,12 @@ Moira::cmp(u32 op1, u32 op2)
 {
     u64 result = U64_SUB(op2, op1);
 
+    if constexpr (lazyFlags<C>()) {
+
+        setLazyFlags<S>(FlagOp::SUB, op1, op2, result);
+        return;
+    }
+
     reg.sr.c = NBIT<S>(result >> 1);
     reg.sr.v = NBIT<S>((op2 ^ op1) & (op2 ^ result));
     reg.sr.z = ZERO<S>(result);
@@ -424,6 +544,12 @@ Moira::logic(u32 op1, u32 op2)
             fatalError;
     }
 
+    if constexpr (lazyFlags<C>()) {
+
+        setLazyFlags<S>(FlagOp::LOGIC, 0, 0, result);
+        return result;
+    }
+
     reg.sr.n = NBIT<S>(result);
     reg.sr.z = ZERO<S>(result);
     reg.sr.v = 0;
@@ -567,6 +693,13 @@ Moira::addsub(u32 op1, u32 op2)
         {
             result = U64_ADD(op1, op2);
 
+            if constexpr (lazyFlags<C>()) {
+
+                reg.sr.x = CARRY<S>(result);
+                setLazyFlags<S>(FlagOp::ADD, op1, op2, result);
+                return (u32)result;
+            }
+
             reg.sr.x = reg.sr.c = CARRY<S>(result);
             reg.sr.v = NBIT<S>((op1 ^ result) & (op2 ^ result));
             reg.sr.z = ZERO<S>(result);
@@ -589,6 +722,13 @@ Moira::addsub(u32 op1, u32 op2)
         {
             result = U64_SUB(op2, op1);
 
+            if constexpr (lazyFlags<C>()) {
+
+                reg.sr.x = CARRY<S>(result);
+                setLazyFlags<S>(FlagOp::SUB, op1, op2, result);
+                return (u32)result;
+            }
+
             reg.sr.x = reg.sr.c = CARRY<S>(result);
             reg.sr.v = NBIT<S>((op1 ^ op2) & (op2 ^ result));
             reg.sr.z = ZERO<S>(result);
@@ -7,6 +7,12 @@
 
 #pragma once
 
+/* Each of the following switches can be overridden by the build, e.g., by
+ * passing -DMOIRA_VIRTUAL_API=false to the compiler. All translation units
+ * linked together must see the same settings, unless they compile the core
+ * into different namespaces (see MOIRA_NAMESPACE).
+ */
+
 /* Set to true to enable precise timing mode (68000 and 68010 only).
  *
  * When disabled, Moira calls the 'sync' function at the end of each instruction,
@@ -19,7 +25,9 @@
  *
  * Enable to improve accuracy, disable it to enhance performance.
  */
+#ifndef MOIRA_PRECISE_TIMING
 #define MOIRA_PRECISE_TIMING false
+#endif
 
 /* Set to true to implement the CPU interface as virtual functions.
  *
@@ -32,7 +40,9 @@
  *
  * Enable to adhere to the standard OOP paradigm, disable to gain speed.
  */
+#ifndef MOIRA_VIRTUAL_API
 #define MOIRA_VIRTUAL_API true
+#endif
 
 /* Set to true to enable address error checking.
  *
@@ -41,7 +51,9 @@
  *
  * Enable to improve accuracy, disable to gain speed.
  */
+#ifndef MOIRA_EMULATE_ADDRESS_ERROR
 #define MOIRA_EMULATE_ADDRESS_ERROR false
+#endif
 
 /* Set to true to emulate function code pins FC0 - FC2.
  *
@@ -51,15 +63,19 @@
  *
  * Enable to improve accuracy, disable to gain speed.
  */
+#ifndef MOIRA_EMULATE_FC
 #define MOIRA_EMULATE_FC true
+#endif
 
 /* Set to true to enable the disassembler.
  *
- * The disassembler requires a jump table which consumes about 1MB of memory.
+ * The disassembler requires a jump table which consumes about 128 KB of memory.
  *
  * Disable to save space.
  */
+#ifndef MOIRA_ENABLE_DASM
 #define MOIRA_ENABLE_DASM true
+#endif
 
 /* Set to true to build the InstrInfo lookup table.
  *
@@ -71,7 +87,9 @@
  *
  * Disable to save space.
  */
+#ifndef MOIRA_BUILD_INSTR_INFO_TABLE
 #define MOIRA_BUILD_INSTR_INFO_TABLE true
+#endif
 
 /* Enables Musashi compatibility mode.
  *
@@ -81,7 +99,99 @@
  *
  * Set to false for improved accuracy.
  */
+#ifndef MOIRA_MIMIC_MUSASHI
 #define MOIRA_MIMIC_MUSASHI true
+#endif
+
+/* Set to true to fast-forward idle loops (68000 only).
+ *
+ * A DBcc or Bcc instruction branching to itself performs no memory accesses
+ * besides refetching its own opcode. When enabled, Moira skips the remaining
+ * iterations of such a loop in a single step, but never beyond the cycle
+ * passed to executeUntil. Registers, flags and the elapsed cycle count end up
+ * as if all iterations had been executed; only the number of executed
+ * instructions differs. The skipped cycles are reported by getIdleCycles().
+ *
+ * Enable to save host time in delay loops and busy waits, disable for
+ * instruction-level tracing.
+ */
+#ifndef MOIRA_SKIP_IDLE_LOOPS
+#define MOIRA_SKIP_IDLE_LOOPS false
+#endif
+
+/* Set to true to execute straight-line code from a block cache (68000 only).
+ *
+ * The first time an instruction sequence is executed, Moira records it as a
+ * block: the instruction handlers, their opcodes, and a copy of the code
+ * words. When the sequence is reached again, the handlers are called back to
+ * back and the opcode and extension words are taken from the copy instead of
+ * the memory interface. Timing is not affected, because every fetch still
+ * advances the clock as usual. Blocks are only used inside executeUntil and
+ * never run beyond the cycle passed to it.
+ *
+ * The client decides which memory may be cached (see willCacheBlock) and must
+ * call flushBlocks() when cached code is overwritten (see isCachedCode).
+ */
+#ifndef MOIRA_BLOCK_CACHE
+#define MOIRA_BLOCK_CACHE false
+#endif
+
+/* Set to true to evaluate condition codes lazily (68000 only).
+ *
+ * ADD, SUB, CMP, AND, OR and EOR (and their immediate and quick variants)
+ * only record the operation, its operands and the result. N, Z, V and C are
+ * computed when they are needed: by a conditional instruction (for the
+ * flags it tests), by getCCR() or getSR(), or at the beginning of any other
+ * instruction. The X flag is always computed right away. Both modes produce
+ * the same results.
+ */
+#ifndef MOIRA_LAZY_FLAGS
+#define MOIRA_LAZY_FLAGS false
+#endif
+
+/* Set to true to signal address errors, bus errors and double faults by
+ * throwing C++ exceptions.
+ *
+ * When set to false, a fault is recorded as pending instead (see raiseFault)
+ * and the faulting memory access returns early. The instruction handler runs
+ * to its end with all further memory writes dropped, and the exception is
+ * processed as soon as the handler returns, starting from the program counter
+ * at the time of the fault. A fault raised while the exception is processed
+ * halts the CPU. Data and address registers written by the handler after the
+ * fault keep their values, so only the stacked frame and the program counter,
+ * not the complete register file, are exact in this mode.
+ *
+ * Disable to build without exception handling support (-fno-exceptions).
+ * Usage errors, such as executing an unsupported FPU or MMU instruction,
+ * then abort the program.
+ */
+#ifndef MOIRA_THROW_FAULTS
+#define MOIRA_THROW_FAULTS true
+#endif
+
+/* Set to true to compile in the jump tables of the 68000 instead of building
+ * them when the first instance is created.
+ *
+ * The tables are read from MoiraTables.h, which has to be generated first by
+ * a program that includes Moira with MOIRA_TABLE_GENERATOR defined, binds the
+ * 68000 tables (any instance does) and calls writeJumpTable. The file holds
+ * no settings of the core other than the tables, so it serves every copy of
+ * Moira and every target. Other models are still built at runtime.
+ */
+#ifndef MOIRA_STATIC_TABLES
+#define MOIRA_STATIC_TABLES false
+#endif
+
+/* Namespace of the core.
+ *
+ * A program can link several copies of Moira that differ in the settings
+ * above, e.g., a fast core for production use next to an accurate one for
+ * debugging. Each copy is compiled with a namespace of its own, so that the
+ * copies do not clash.
+ */
+#ifndef MOIRA_NAMESPACE
+#define MOIRA_NAMESPACE moira
+#endif
 
 /* The following macro appears at the beginning of each instruction handler.
  * Moira will call 'willExecute(...)' for all listed instructions.
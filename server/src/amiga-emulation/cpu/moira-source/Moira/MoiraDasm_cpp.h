@@ -9,7 +9,7 @@ int
 Moira::disassemble(char *str, u32 addr) const
 {
     if constexpr (MOIRA_ENABLE_DASM == false) {
-        throw std::runtime_error("This feature requires MOIRA_ENABLE_DASM = true\n");
+        THROW_ERROR("This feature requires MOIRA_ENABLE_DASM = true\n");
     }
 
     u32 pc = addr;
@@ -17,7 +17,7 @@ Moira::disassemble(char *str, u32 addr) const
 
     StrWriter writer(str, instrStyle);
 
-    (this->*dasm[opcode])(writer, pc, opcode);
+    (this->*dasmHandler(opcode))(writer, pc, opcode);
     writer << Finish{};
 
     // Post process disassembler output
@@ -45,6 +45,19 @@ Moira::disassemble(char *str, u32 addr) const
     return pc - addr + 2;
 }
 
+void
+Moira::disassembleSR(char *str) const
+{
+    // The condition codes may be pending (MOIRA_LAZY_FLAGS)
+    StatusRegister sr = reg.sr;
+    sr.n = flagN();
+    sr.z = flagZ();
+    sr.v = flagV();
+    sr.c = flagC();
+
+    disassembleSR(str, sr);
+}
+
 void
 Moira::disassembleSR(char *str, const StatusRegister &sr) const
 {
@@ -120,6 +120,9 @@ template <Flags F = 0> StackFrame makeFrame(u32 addr);
 // Prefetches the next instruction
 template <Core C, Flags F = 0> void prefetch();
 
+// Reads an opcode or extension word (from the executing block if possible)
+template <Core C, Flags F = 0> u16 readInstrWord(u32 addr);
+
 // Performs a full prefetch cycle
 template <Core C, Flags F = 0, int delay = 0> void fullPrefetch();
 
@@ -370,7 +370,7 @@ Moira::read(u32 addr)
 
     // Check for address errors
     if (misaligned<C, S>(addr)) {
-        throw AddressError(makeFrame<F>(addr));
+        THROW_FAULT(AddressError(makeFrame<F>(addr)), 0);
     }
 
     // Check if a watchpoint has been reached
@@ -417,13 +417,16 @@ Moira::writeM(u32 addr, u32 val)
 template <Core C, AddrSpace AS, Size S, Flags F> void
 Moira::write(u32 addr, u32 val)
 {
+    // Drop the remaining writes of a faulting instruction
+    if constexpr (MOIRA_THROW_FAULTS == false) { if (flags & State::FAULT) return; }
+
     // Update function code pins
     setFC(AS == AddrSpace::DATA ? FC::USER_DATA : FC::USER_PROG);
     SYNC(2);
 
     // Check for address errors
     if (misaligned<C, S>(addr)) {
-        throw AddressError(makeFrame<F|AE_WRITE>(addr));
+        THROW_FAULT(AddressError(makeFrame<F|AE_WRITE>(addr)));
     }
 
     // Check if a watchpoint has been reached
@@ -582,16 +585,35 @@ Moira::prefetch()
     reg.pc0 = reg.pc;
 
     queue.ird = queue.irc;
-    queue.irc = (u16)read<C, AddrSpace::PROG, Word, F>(reg.pc + 2);
+    queue.irc = readInstrWord<C, F>(reg.pc + 2);
     readBuffer = queue.irc;
 }
 
+template <Core C, Flags F> u16
+Moira::readInstrWord(u32 addr)
+{
+    if constexpr (MOIRA_BLOCK_CACHE) {
+
+        // Take the word from the executing block (same bus timing as read)
+        if (u32 offset = addr - blockStart; offset < blockBytes && !(offset & 1)) {
+
+            setFC(FC::USER_PROG);
+            SYNC(2);
+            if (F & POLL) POLL_IPL;
+            SYNC(2);
+            return blockWords[offset >> 1];
+        }
+    }
+
+    return (u16)read<C, AddrSpace::PROG, Word, F>(addr);
+}
+
 template <Core C, Flags F, int delay> void
 Moira::fullPrefetch()
 {
     assert(!misaligned<C>(reg.pc));
 
-    queue.irc = (u16)read<C, AddrSpace::PROG, Word>(reg.pc);
+    queue.irc = readInstrWord<C>(reg.pc);
     if (delay) SYNC(delay);
     prefetch<C, F>();
 }
@@ -612,7 +634,7 @@ Moira::readExt()
     assert(!misaligned<C>(reg.pc));
 
     reg.pc += 2;
-    queue.irc = (u16)read<C, AddrSpace::PROG, Word>(reg.pc);
+    queue.irc = readInstrWord<C>(reg.pc);
 }
 
 template <Core C, Size S> u32
@@ -645,11 +667,11 @@ Moira::jumpToVector(int nr)
 
         if (nr == 3) {
             
-            throw DoubleFault();
+            THROW_FAULT(DoubleFault());
             
         } else if (C == Core::C68000) {
 
-            throw AddressError(makeFrame<F|AE_PROG>(reg.pc, vectorAddr));
+            THROW_FAULT(AddressError(makeFrame<F|AE_PROG>(reg.pc, vectorAddr)));
 
         } else {
 
@@ -663,11 +685,11 @@ Moira::jumpToVector(int nr)
                 case M68kException::LINEF:
                 case M68kException::PRIVILEGE:
                     
-                    throw AddressError(makeFrame<F|AE_DEC_PC|AE_PROG|AE_SET_RW|AE_SET_IF>(reg.pc, oldpc));
+                    THROW_FAULT(AddressError(makeFrame<F|AE_DEC_PC|AE_PROG|AE_SET_RW|AE_SET_IF>(reg.pc, oldpc)));
                     
                 default:
                     
-                    throw AddressError(makeFrame<F|AE_PROG|AE_SET_RW|AE_SET_IF>(reg.pc, oldpc));
+                    THROW_FAULT(AddressError(makeFrame<F|AE_PROG|AE_SET_RW|AE_SET_IF>(reg.pc, oldpc)));
             }
             /*
             if (nr == ILLEGAL || nr == LINEA || nr == LINEF || nr == EXC_PRIVILEGE) {
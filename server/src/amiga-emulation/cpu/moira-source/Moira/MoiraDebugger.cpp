@@ -12,7 +12,7 @@
 #include <cstring>
 #include <cstdio>
 
-namespace moira {
+namespace MOIRA_NAMESPACE {
 
 
 //
@@ -279,7 +279,7 @@ Moira::execAddressError(StackFrame frame, int delay)
     SYNC(8);
 
     // A misaligned stack pointer will cause a double fault
-    if (misaligned<C>(reg.sp)) throw DoubleFault();
+    if (misaligned<C>(reg.sp)) THROW_FAULT(DoubleFault());
 
     // Write stack frame
     if (C == Core::C68000) {
@@ -289,6 +289,9 @@ Moira::execAddressError(StackFrame frame, int delay)
     }
     SYNC(2);
 
+    // A fault while writing the frame halts the CPU (see processFault)
+    if constexpr (MOIRA_THROW_FAULTS == false) { if (flags & State::FAULT) return; }
+
     // Jump to exception vector
     jumpToVector<C>(3);
 
@@ -316,7 +319,7 @@ Moira::execBusError(StackFrame frame, int delay)
     SYNC(8);
 
     // A misaligned stack pointer will cause a double fault
-    if (misaligned<C>(reg.sp)) throw DoubleFault();
+    if (misaligned<C>(reg.sp)) THROW_FAULT(DoubleFault());
 
     // Write stack frame
     if (C == Core::C68000) {
@@ -326,6 +329,9 @@ Moira::execBusError(StackFrame frame, int delay)
     }
     SYNC(2);
 
+    // A fault while writing the frame halts the CPU (see processFault)
+    if constexpr (MOIRA_THROW_FAULTS == false) { if (flags & State::FAULT) return; }
+
     // Jump to exception vector
     jumpToVector<C>(2);
 
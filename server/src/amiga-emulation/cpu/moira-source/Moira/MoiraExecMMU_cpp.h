@@ -159,47 +159,47 @@ template <Core C, Instr I, Mode M, Size S> void
 Moira::execPFlush(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68030 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68030 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPFlusha(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68030 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68030 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPFlush40(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68040 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68040 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPLoad(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68030 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68030 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPMove(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68030 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68030 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPTest(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68030 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68030 instruction.");
 }
 
 template <Core C, Instr I, Mode M, Size S> void
 Moira::execPTest40(u16 opcode)
 {
     AVAILABILITY(Core::C68020)
-    throw std::runtime_error("Attempt to execute an unsupported 68040 instruction.");
+    THROW_ERROR("Attempt to execute an unsupported 68040 instruction.");
 }
@@ -9,6 +9,7 @@
 if constexpr ((core) == Core::C68010) { static_assert(C != Core::C68000); } \
 if constexpr ((core) == Core::C68020) { static_assert(C != Core::C68000 && C != Core::C68010); } \
 if constexpr (C == Core::C68020) cp = 0; \
+if constexpr (MOIRA_LAZY_FLAGS && !keepsLazyFlags<C, I>()) materializeFlags(); \
 if constexpr (MOIRA_WILL_EXECUTE) willExecute(__func__, I, M, S, opcode);
 
 #define FINALIZE \
@@ -600,25 +601,25 @@ Moira::execAddxEa(u16 opcode)
 
     u32 ea1, ea2, data1, data2;
 
-    try {
+    TRY_FAULT {
         readOp<C, M, S, flags>(src, &ea1, &data1);
 
-    } catch (const AddressError &exc) {
+    } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify stack frame
         if constexpr (S == Long) undoAnPD<M,S>(src);
-        throw exc;
+        RETHROW_FAULT(exc);
     }
     if constexpr (S != Long) POLL_IPL;
 
-    try {
+    TRY_FAULT {
         readOp<C, M, S, flags|IMPL_DEC> (dst, &ea2, &data2);
 
-    } catch (const AddressError &exc) {
+    } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify stack frame
         if constexpr (S == Long) undoAnPD<M,S>(dst);
-        throw exc;
+        RETHROW_FAULT(exc);
     }
 
     u32 result = addsub<C, I, S>(data1, data2);
@@ -857,7 +858,12 @@ Moira::execBra(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(newpc)) {
-        throw AddressError(makeFrame(newpc));
+        THROW_FAULT(AddressError(makeFrame(newpc)));
+    }
+
+    // Fast-forward a branch to itself
+    if constexpr (MOIRA_SKIP_IDLE_LOOPS && C == Core::C68000) {
+        if (newpc == reg.pc0) skipIdleIterations(INT64_MAX, 10);
     }
 
     reg.pc = newpc;
@@ -893,7 +899,12 @@ Moira::execBcc(u16 opcode)
 
         // Check for address error
         if (misaligned<C>(newpc)) {
-            throw AddressError(makeFrame(newpc));
+            THROW_FAULT(AddressError(makeFrame(newpc)));
+        }
+
+        // Fast-forward a branch to itself (the condition cannot change)
+        if constexpr (MOIRA_SKIP_IDLE_LOOPS && C == Core::C68000) {
+            if (newpc == reg.pc0) skipIdleIterations(INT64_MAX, 10);
         }
 
         // Take branch
@@ -1362,10 +1373,10 @@ Moira::execBsr(u16 opcode)
         // Check for address errors
         if (misaligned<C>(reg.sp)) {
             reg.sp -= 4;
-            throw AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp));
+            THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp)));
         }
         if (misaligned<C>(newpc)) {
-            throw AddressError(makeFrame(newpc));
+            THROW_FAULT(AddressError(makeFrame(newpc)));
         }
 
         // Save return address on stack
@@ -1380,11 +1391,11 @@ Moira::execBsr(u16 opcode)
         // Check for address errors
         if (misaligned<C>(reg.sp)) {
             writeBuffer = 0;
-            throw AddressError(makeFrame<AE_WRITE|AE_DATA>(newpc));
+            THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(newpc)));
 
         }
         if (misaligned<C>(newpc)) {
-            throw AddressError(makeFrame(newpc));
+            THROW_FAULT(AddressError(makeFrame(newpc)));
         }
 
         // Save return address on stack
@@ -1561,17 +1572,18 @@ Moira::execChk(u16 opcode)
     u32 ea = 0, data, dy;
     [[maybe_unused]] auto c = clock;
 
-    try {
+    TRY_FAULT {
 
         readOp<C, M, S>(src, &ea, &data);
 
-    } catch (const AddressError &) {
+    } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify the stack frame
         if (C == Core::C68000) {
 
             SYNC(2);
-            throw AddressError(makeFrame<STD_AE_FRAME>(ea));
+            exc.stackFrame = makeFrame<STD_AE_FRAME>(ea);
+            RETHROW_FAULT(exc);
 
         } else {
 
@@ -1580,12 +1592,14 @@ Moira::execChk(u16 opcode)
             if (isAbsMode(M) || M == Mode::AI || M == Mode::PI || M == Mode::PD) {
 
                 SYNC(2);
-                throw AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(ea));
+                exc.stackFrame = makeFrame<AE_SET_RW|AE_SET_DF>(ea);
+                RETHROW_FAULT(exc);
 
             } else {
 
                 SYNC(2);
-                throw AddressError(makeFrame<AE_DEC_PC|AE_SET_RW|AE_SET_DF>(ea));
+                exc.stackFrame = makeFrame<AE_DEC_PC|AE_SET_RW|AE_SET_DF>(ea);
+                RETHROW_FAULT(exc);
             }
         }
     }
@@ -2149,11 +2163,19 @@ Moira::execDbcc(u16 opcode)
             int dn = _____________xxx(opcode);
             u32 newpc = U32_ADD(reg.pc, (i16)queue.irc);
 
+            // Fast-forward a DBcc to itself, leaving the last iteration
+            if constexpr (MOIRA_SKIP_IDLE_LOOPS && C == Core::C68000) {
+                if (newpc == reg.pc0 && readD<Word>(dn) > 1) {
+                    auto skipped = skipIdleIterations(readD<Word>(dn) - 1, 10);
+                    writeD<Word>(dn, U32_SUB(readD<Word>(dn), skipped));
+                }
+            }
+
             bool takeBranch = readD<Word>(dn) != 0;
 
             // Check for address error
             if (misaligned<C, S>(newpc)) {
-                throw AddressError(makeFrame<AE_INC_PC>(newpc, newpc));
+                THROW_FAULT(AddressError(makeFrame<AE_INC_PC>(newpc, newpc)));
             }
 
             // Decrement loop counter
@@ -2203,7 +2225,7 @@ Moira::execDbcc(u16 opcode)
 
             // Check for address error
             if (misaligned<C, S>(newpc)) {
-                throw AddressError(makeFrame<AE_INC_PC>(newpc, newpc));
+                THROW_FAULT(AddressError(makeFrame<AE_INC_PC>(newpc, newpc)));
             }
 
             // Decrement loop counter
@@ -2259,7 +2281,7 @@ Moira::execDbcc(u16 opcode)
 
             // Check for address error
             if (misaligned<C, S>(newpc)) {
-                throw AddressError(makeFrame<AE_INC_PC>(newpc, newpc));
+                THROW_FAULT(AddressError(makeFrame<AE_INC_PC>(newpc, newpc)));
             }
 
             // Decrement loop counter
@@ -2432,7 +2454,7 @@ Moira::execJmp(u16 opcode)
 
     // Check for address error
     if (misaligned<C, Word>(ea)) {
-        throw AddressError(makeFrame(ea, oldpc));
+        THROW_FAULT(AddressError(makeFrame(ea, oldpc)));
     }
 
     // Jump to new address
@@ -2471,10 +2493,10 @@ Moira::execJsr(u16 opcode)
 
             // Check for address errors
             if (isDspMode(M) && misaligned<C>(ea)) {
-                throw AddressError(makeFrame<AE_DEC_PC>(ea));
+                THROW_FAULT(AddressError(makeFrame<AE_DEC_PC>(ea)));
             }
             if (misaligned<C>(ea)) {
-                throw AddressError(makeFrame(ea));
+                THROW_FAULT(AddressError(makeFrame(ea)));
             }
 
             // Save return address on stack
@@ -2495,31 +2517,31 @@ Moira::execJsr(u16 opcode)
                 if (M == Mode::AI) {
 
                     queue.irc = (u16)read<C, AddrSpace::PROG, Word>(ea & ~1);
-                    throw AddressError(makeFrame<AE_SET_IF|AE_SET_RW>(ea));
+                    THROW_FAULT(AddressError(makeFrame<AE_SET_IF|AE_SET_RW>(ea)));
                 }
 
                 if (isAbsMode(M)) {
 
                     auto frame = makeFrame<AE_SET_IF|AE_SET_RW>(ea);
                     frame.pc -= 4;
-                    throw AddressError(frame);
+                    THROW_FAULT(AddressError(frame));
                 }
                 if (isDspMode(M)) {
 
-                    throw AddressError(makeFrame<AE_DEC_PC|AE_SET_IF|AE_SET_RW>(ea));
+                    THROW_FAULT(AddressError(makeFrame<AE_DEC_PC|AE_SET_IF|AE_SET_RW>(ea)));
 
                 } else {
 
-                    throw AddressError(makeFrame(ea));
+                    THROW_FAULT(AddressError(makeFrame(ea)));
                 }
             }
 
             if (misaligned<C>(ea)) {
 
                 if (isDspMode(M)) {
-                    throw AddressError(makeFrame<AE_SET_IF|AE_SET_RW>(ea));
+                    THROW_FAULT(AddressError(makeFrame<AE_SET_IF|AE_SET_RW>(ea)));
                 } else {
-                    throw AddressError(makeFrame(ea));
+                    THROW_FAULT(AddressError(makeFrame(ea)));
                 }
             }
 
@@ -2528,7 +2550,7 @@ Moira::execJsr(u16 opcode)
                 prefetch<C>();
                 reg.sp -= 4;
                 writeBuffer = u16(reg.pc >> 16);
-                throw AddressError(makeFrame<AE_DATA>(reg.sp));
+                THROW_FAULT(AddressError(makeFrame<AE_DATA>(reg.sp)));
             }
 
             // Save return address on stack
@@ -2601,7 +2623,7 @@ Moira::execLink(u16 opcode)
 
         writeBuffer = u16(readA(ax) >> 16);
         writeA(ax, sp);
-        throw AddressError(makeFrame<AE_DATA|AE_WRITE>(sp, getPC() + 2, getSR(), ird));
+        THROW_FAULT(AddressError(makeFrame<AE_DATA|AE_WRITE>(sp, getPC() + 2, getSR(), ird)));
     }
 
     POLL_IPL;
@@ -2881,9 +2903,9 @@ Moira::execMove4(u16 opcode)
     if (misaligned<C, S>(ea)) {
 
         if constexpr (S != Long) updateAn<Mode::PD, S>(dst);
-        if (format == 0) { throw AddressError(makeFrame<flags0>(ea + 2, reg.pc + 2, getSR(), ird)); }
-        if (format == 1) { SYNC(2); throw AddressError(makeFrame<flags1>(ea, reg.pc + 2)); }
-        if (format == 2) { SYNC(2); throw AddressError(makeFrame<flags2>(ea, reg.pc + 2)); }
+        if (format == 0) { THROW_FAULT(AddressError(makeFrame<flags0>(ea + 2, reg.pc + 2, getSR(), ird))); }
+        if (format == 1) { SYNC(2); THROW_FAULT(AddressError(makeFrame<flags1>(ea, reg.pc + 2))); }
+        if (format == 2) { SYNC(2); THROW_FAULT(AddressError(makeFrame<flags2>(ea, reg.pc + 2))); }
     }
 
     writeM<C, Mode::PD, S, REVERSE>(ea, data);
@@ -3092,7 +3114,7 @@ Moira::execMove8(u16 opcode)
 
         // Check for address error
         if (misaligned<C, S>(ea2)) {
-            throw AddressError(makeFrame<AE_WRITE|AE_DATA>(ea2));
+            THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(ea2)));
         }
 
         reg.sr.n = NBIT<S>(data);
@@ -3145,11 +3167,11 @@ Moira::execMovea(u16 opcode)
 
     u32 ea = 0, data;
 
-    try { readOp<C, M, S>(src, &ea, &data); } catch (AddressError &exc) {
+    TRY_FAULT { readOp<C, M, S>(src, &ea, &data); } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify the stack frame
         exc.stackFrame = makeFrame<STD_AE_FRAME|AE_SET_RW|AE_SET_DF>(ea);
-        throw exc;
+        RETHROW_FAULT(exc);
     }
 
     prefetch<C, POLL>();
@@ -3298,9 +3320,9 @@ Moira::execMovemEaRg(u16 opcode)
 
         setFC<M>();
         if constexpr (M == Mode::IX || M == Mode::IXPC) {
-            throw AddressError(makeFrame<AE_DEC_PC|AE_SET_DF|AE_SET_RW>(ea));
+            THROW_FAULT(AddressError(makeFrame<AE_DEC_PC|AE_SET_DF|AE_SET_RW>(ea)));
         } else {
-            throw AddressError(makeFrame<AE_INC_PC|AE_SET_DF|AE_SET_RW>(ea));
+            THROW_FAULT(AddressError(makeFrame<AE_INC_PC|AE_SET_DF|AE_SET_RW>(ea)));
         }
     }
 
@@ -3377,7 +3399,7 @@ Moira::execMovemRgEa(u16 opcode)
                 setFC<M>();
                 readBuffer = mask;
                 writeBuffer = u16(reg.r[i] & 0xFFFF);
-                throw AddressError(makeFrame<AE_INC_PC|AE_WRITE>(U32_SUB(ea, 2)));
+                THROW_FAULT(AddressError(makeFrame<AE_INC_PC|AE_WRITE>(U32_SUB(ea, 2))));
             }
 
             // Write register contents into memory
@@ -3403,7 +3425,7 @@ Moira::execMovemRgEa(u16 opcode)
                 setFC<M>();
                 readBuffer = mask;
                 writeBuffer = S == Long ? u16(reg.r[i] >> 16) : u16(reg.r[i] & 0xFFFF);
-                throw AddressError(makeFrame<AE_INC_PC|AE_WRITE>(ea));
+                THROW_FAULT(AddressError(makeFrame<AE_INC_PC|AE_WRITE>(ea)));
             }
 
             // Write register contents into memory
@@ -3566,16 +3588,16 @@ Moira::execMoves(u16 opcode)
         fcSource = 2;
 
         // writeOp<C, M, S>(dst, value);
-        try {
+        TRY_FAULT {
             writeM<C, M, S, AE_INC_PC>(ea, value);
-        } catch (AddressError &exc) {
+        } CATCH_ADDRESS_ERROR(exc) {
 
             writeBuffer = (S == Long ? u16(value >> 16) : u16(value & 0xFFFF));
 
             // EXPERIMENTAL: CLEAN THIS UP (RENAME stackFrame.ird to irc?!)
             fcSource = 0;
             queue.irc = old;
-            throw exc;
+            RETHROW_FAULT(exc);
         }
 
         // Switch back to the old FC pin values
@@ -3592,15 +3614,15 @@ Moira::execMoves(u16 opcode)
         // u32 ea, data;
         // readOp<C, M, S, STD_AE_FRAME | SKIP_READ>(src, &ea, &data);
         u32 ea;
-        try {
+        TRY_FAULT {
 
             ea = computeEA<C, M, S>(src);
             updateAn<M, S>(src);
 
-        } catch (AddressError &exc) {
+        } CATCH_ADDRESS_ERROR(exc) {
 
             exc.stackFrame.ird = old;
-            throw exc;
+            RETHROW_FAULT(exc);
         }
 
         // Make the SFC register visible on the FC pins
@@ -3689,7 +3711,7 @@ Moira::execMoveCcrEa(u16 opcode)
         writeBuffer = val & 0xFFFF;
         updateAnPI<M, S>(dst);
         setFC<M>();
-        throw AddressError(makeFrame<AE_WRITE|AE_INC_PC>(ea));
+        THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_INC_PC>(ea)));
     }
 
     // Write to effective address
@@ -3801,7 +3823,7 @@ Moira::execMoveSrEa(u16 opcode)
             writeBuffer = val & 0xFFFF;
             updateAnPI<M, S>(dst);
             setFC<M>();
-            throw AddressError(makeFrame<AE_WRITE|AE_INC_PC>(ea));
+            THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_INC_PC>(ea)));
         }
 
         // Write to effective address
@@ -4225,7 +4247,7 @@ Moira::execDivsMoira(u16 opcode, bool *divByZero)
 
     u32 ea = 0, divisor, result;
 
-    try { readOp<C, M, Word>(src, &ea, &divisor); } catch (AddressError &exc) {
+    TRY_FAULT { readOp<C, M, Word>(src, &ea, &divisor); } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify the stack frame
         if (C == Core::C68000) {
@@ -4245,7 +4267,7 @@ Moira::execDivsMoira(u16 opcode, bool *divByZero)
                 exc.stackFrame = makeFrame<AE_DEC_PC|AE_SET_RW|AE_SET_DF>(ea);
             }
         }
-        throw exc;
+        RETHROW_FAULT(exc);
     }
 
     u32 dividend = readD(dst);
@@ -4352,14 +4374,14 @@ Moira::execDivuMoira(u16 opcode, bool *divByZero)
 
     u32 ea = 0, divisor, result;
 
-    try { readOp<C, M, Word>(src, &ea, &divisor); } catch (AddressError &exc) {
+    TRY_FAULT { readOp<C, M, Word>(src, &ea, &divisor); } CATCH_ADDRESS_ERROR(exc) {
 
         // Rectify the stack frame
         if (C == Core::C68000) {
 
             SYNC(2);
             exc.stackFrame = makeFrame<STD_AE_FRAME>(ea);
-            throw exc;
+            RETHROW_FAULT(exc);
 
         } else {
 
@@ -4371,7 +4393,7 @@ Moira::execDivuMoira(u16 opcode, bool *divByZero)
             } else {
                 exc.stackFrame = makeFrame<AE_DEC_PC|AE_SET_RW|AE_SET_DF>(ea);
             }
-            throw exc;
+            RETHROW_FAULT(exc);
         }
     }
 
@@ -4483,7 +4505,7 @@ Moira::execDivlMoira(u16 opcode, bool *divByZero)
     int dh  = _____________xxx(ext);
     int dl  = _xxx____________(ext);
 
-    try { readOp<C, M, S>(src, &ea, &divisor); } catch(...) { return false; }
+    TRY_FAULT { readOp<C, M, S>(src, &ea, &divisor); } CATCH_FAULT { return false; }
 
     if (ext & 0x400) {
         dividend = (u64)readD(dh) << 32 | readD(dl);
@@ -4576,9 +4598,9 @@ Moira::execDivlMusashi(u16 opcode, bool *divByZero)
     int dh  = _____________xxx(ext);
     int dl  = _xxx____________(ext);
 
-    try {
+    TRY_FAULT {
         readOp<C, M, S>(src, &ea, &divisor);
-    } catch(...) {
+    } CATCH_FAULT {
         // TODO: Change return type from bool to void
         return false;
     }
@@ -4847,9 +4869,9 @@ Moira::execPea(u16 opcode)
         if (C == Core::C68000) {
 
             if (isAbsMode(M)) {
-                throw AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp));
+                THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp)));
             } else {
-                throw AddressError(makeFrame<AE_WRITE|AE_DATA|AE_INC_PC>(reg.sp));
+                THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA|AE_INC_PC>(reg.sp)));
             }
 
         } else {
@@ -4857,13 +4879,13 @@ Moira::execPea(u16 opcode)
             writeBuffer = u16(ea >> 16);
             if (isAbsMode(M)) {
                 readBuffer = queue.irc;
-                throw AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp, U32_SUB(reg.pc, 4)));
+                THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp, U32_SUB(reg.pc, 4))));
             } else if (isDspMode(M)) {
                 prefetch<C>();
-                throw AddressError(makeFrame<AE_WRITE|AE_DATA|AE_DEC_PC>(reg.sp));
+                THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA|AE_DEC_PC>(reg.sp)));
             } else {
                 prefetch<C>();
-                throw AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp));
+                THROW_FAULT(AddressError(makeFrame<AE_WRITE|AE_DATA>(reg.sp)));
             }
         }
     }
@@ -4944,7 +4966,7 @@ Moira::execRtd(u16 opcode)
 
         setFC<M>();
         readBuffer = u16(readM<C, M, Word>(reg.sp & ~1));
-        throw AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp));
+        THROW_FAULT(AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp)));
     }
 
     u32 newpc = readM<C, M, Long>(reg.sp);
@@ -4952,7 +4974,7 @@ Moira::execRtd(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(newpc)) {
-        throw AddressError(makeFrame<AE_PROG>(newpc));
+        THROW_FAULT(AddressError(makeFrame<AE_PROG>(newpc)));
     }
 
     setPC(newpc);
@@ -5189,7 +5211,7 @@ Moira::execRte(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(newpc)) {
-        throw AddressError(makeFrame<AE_PROG>(newpc));
+        THROW_FAULT(AddressError(makeFrame<AE_PROG>(newpc)));
     }
 
     setPC(newpc);
@@ -5224,7 +5246,7 @@ Moira::execRtr(u16 opcode)
 
         setFC<M>();
         readBuffer = u16(readM<C, M, Word>(reg.sp & ~1));
-        throw AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp));
+        THROW_FAULT(AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp)));
     }
 
     u16 newccr = (u16)readM<C, M, Word>(reg.sp);
@@ -5238,7 +5260,7 @@ Moira::execRtr(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(newpc)) {
-        throw AddressError(makeFrame<AE_PROG>(newpc));
+        THROW_FAULT(AddressError(makeFrame<AE_PROG>(newpc)));
     }
 
     setPC(newpc);
@@ -5261,7 +5283,7 @@ Moira::execRts(u16 opcode)
 
         setFC<M>();
         readBuffer = u16(readM<C, M, Word>(reg.sp & ~1));
-        throw AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp));
+        THROW_FAULT(AddressError(makeFrame<AE_SET_RW|AE_SET_DF>(reg.sp)));
     }
 
     u32 newpc = readM<C, M, Long>(reg.sp);
@@ -5269,7 +5291,7 @@ Moira::execRts(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(newpc)) {
-        throw AddressError(makeFrame<AE_PROG>(newpc));
+        THROW_FAULT(AddressError(makeFrame<AE_PROG>(newpc)));
     }
 
     setPC(newpc);
@@ -5590,7 +5612,7 @@ Moira::execUnlk(u16 opcode)
 
     // Check for address error
     if (misaligned<C>(readA(an))) {
-        throw AddressError(makeFrame<AE_DATA|AE_INC_PC|AE_SET_DF|AE_SET_RW>(readA(an)));
+        THROW_FAULT(AddressError(makeFrame<AE_DATA|AE_INC_PC|AE_SET_DF|AE_SET_RW>(readA(an))));
     }
 
     // Move address register to stack pointer
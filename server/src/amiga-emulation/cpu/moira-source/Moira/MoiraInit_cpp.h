@@ -9,28 +9,40 @@
 #define EXEC_HANDLER(func,C,I,M,S) &Moira::exec##func<C,I,M,S>
 #define DASM_HANDLER(func,I,M,S) &Moira::dasm##func<I,M,S>
 
+// Returns the index of an instruction handler (the table generator also
+// records how the handler is spelled)
+#ifdef MOIRA_TABLE_GENERATOR
+#define EXEC_INDEX(func,C,I,M,S) \
+jumpTable->index(EXEC_HANDLER(func,C,I,M,S), JumpTable::spell("exec" #func, C, I, M, S))
+#define DASM_INDEX(func,I,M,S) \
+jumpTable->index(DASM_HANDLER(func,I,M,S), JumpTable::spell("dasm" #func, I, M, S))
+#else
+#define EXEC_INDEX(func,C,I,M,S) jumpTable->index(EXEC_HANDLER(func,C,I,M,S))
+#define DASM_INDEX(func,I,M,S) jumpTable->index(DASM_HANDLER(func,I,M,S))
+#endif
+
 // Registers an instruction handler
 #if MOIRA_ENABLE_DASM == true
-#define REGISTER_DASM(id,name,I,M,S) if (regDasm) dasm[id] = DASM_HANDLER(name,I,M,S);
+#define REGISTER_DASM(id,name,I,M,S) if (regDasm) jumpTable->dasm[id] = DASM_INDEX(name,I,M,S);
 #else
 #define REGISTER_DASM(id,name,I,M,S) { }
 #endif
 
 #if MOIRA_BUILD_INSTR_INFO_TABLE == true
-#define REGISTER_INFO(id,name,I,M,S) info[id] = InstrInfo {I,M,S};
+#define REGISTER_INFO(id,name,I,M,S) jumpTable->info[id] = InstrInfo {I,M,S};
 #else
 #define REGISTER_INFO(id,name,I,M,S) { }
 #endif
 
 #define CIMS(id,name,I,M,S) { \
-exec[id] = EXEC_HANDLER(name,C,I,M,S); \
+jumpTable->exec[id] = EXEC_INDEX(name,C,I,M,S); \
 REGISTER_DASM(id,name,I,M,S) \
 REGISTER_INFO(id,name,I,M,S) \
 }
 
 #define CIMSloop(id,name,I,M,S) { \
-assert(loop[id] == nullptr); \
-loop[id] = EXEC_HANDLER(name,Core::C68010,I##_LOOP,M,S); \
+assert(jumpTable->loop[id] == 0); \
+jumpTable->loop[id] = EXEC_INDEX(name,Core::C68010,I##_LOOP,M,S); \
 }
 
 // Registers an instruction in one of the standard instruction formats:
@@ -153,8 +165,159 @@ parse(const char *s, int sum = 0)
     *s == '1' ? parse(s + 1, (sum << 1) + 1) : (u16)sum;
 }
 
+struct Moira::JumpTable {
+
+    std::unique_ptr<u16[]> exec;
+    std::unique_ptr<u16[]> loop;
+    std::unique_ptr<u16[]> dasm;
+    std::unique_ptr<InstrInfo[]> info;
+
+    // Distinct handlers, in the order they were registered
+    std::vector<ExecPtr> execHandlers { nullptr };
+    std::vector<DasmPtr> dasmHandlers { nullptr };
+
+    // Handler indices by the bytes of the member function pointer (only used
+    // while the tables are built)
+    template <typename Ptr> using Indices = std::map<std::array<u8, sizeof(Ptr)>, u16>;
+    Indices<ExecPtr> execIndices;
+    Indices<DasmPtr> dasmIndices;
+
+    // Most opcodes are registered in runs sharing the same handler
+    u16 lastExec = 0;
+    u16 lastDasm = 0;
+
+    u16 index(ExecPtr handler) { return index(execHandlers, execIndices, lastExec, handler); }
+    u16 index(DasmPtr handler) { return index(dasmHandlers, dasmIndices, lastDasm, handler); }
+
+    // Returns the index of a handler, adding it to the handler table if needed
+    template <typename Ptr> static u16
+    index(std::vector<Ptr> &handlers, Indices<Ptr> &indices, u16 &last, Ptr handler) {
+
+        if (handlers[last] == handler) return last;
+
+        std::array<u8, sizeof(Ptr)> key;
+        std::memcpy(key.data(), &handler, sizeof(Ptr));
+
+        auto [it, added] = indices.try_emplace(key, u16(handlers.size()));
+        if (added) {
+
+            assert(handlers.size() < 0x10000);
+            handlers.push_back(handler);
+        }
+        return last = it->second;
+    }
+
+#ifdef MOIRA_TABLE_GENERATOR
+
+    // C++ spelling of the handlers, in the order of the handler tables
+    std::vector<std::string> execNames { "nullptr" };
+    std::vector<std::string> dasmNames { "nullptr" };
+
+    u16 index(ExecPtr handler, const std::string &name) { return named(execNames, index(handler), name); }
+    u16 index(DasmPtr handler, const std::string &name) { return named(dasmNames, index(handler), name); }
+
+    static u16 named(std::vector<std::string> &names, u16 i, const std::string &name) {
+
+        if (i == names.size()) names.push_back(name);
+        return i;
+    }
+
+    static std::string spell(const char *func, Core C, Instr I, Mode M, Size S) {
+
+        return "&Moira::" + std::string(func) + "<Core(" + std::to_string(int(C)) + ")," +
+        "Instr(" + std::to_string(int(I)) + "),Mode(" + std::to_string(int(M)) + ")," +
+        std::to_string(S) + ">";
+    }
+
+    static std::string spell(const char *func, Instr I, Mode M, Size S) {
+
+        return "&Moira::" + std::string(func) + "<" +
+        "Instr(" + std::to_string(int(I)) + "),Mode(" + std::to_string(int(M)) + ")," +
+        std::to_string(S) + ">";
+    }
+#endif
+
+#if MOIRA_STATIC_TABLES == true
+
+    // The tables of the 68000, defined in MoiraTables.h
+    static const ExecPtr execHandlers68000[];
+    static const u16 exec68000[65536];
+    static const u16 loop68000[65536];
+#if MOIRA_ENABLE_DASM == true
+    static const DasmPtr dasmHandlers68000[];
+    static const u16 dasm68000[65536];
+#endif
+#if MOIRA_BUILD_INSTR_INFO_TABLE == true
+    static const InstrInfo info68000[65536];
+#endif
+#endif
+};
+
+#if MOIRA_STATIC_TABLES == true
+#include "MoiraTables.h"
+#endif
+
 void
 Moira::createJumpTable(Model cpuModel, Model dasmModel)
+{
+#if MOIRA_STATIC_TABLES == true
+
+    if (cpuModel == Model::M68000 && dasmModel == Model::M68000) {
+
+        jumpTable = nullptr;
+        execHandlers = JumpTable::execHandlers68000;
+        exec = JumpTable::exec68000;
+        loop = JumpTable::loop68000;
+#if MOIRA_ENABLE_DASM == true
+        dasmHandlers = JumpTable::dasmHandlers68000;
+        dasm = JumpTable::dasm68000;
+#else
+        dasmHandlers = nullptr;
+        dasm = nullptr;
+#endif
+#if MOIRA_BUILD_INSTR_INFO_TABLE == true
+        info = JumpTable::info68000;
+#else
+        info = nullptr;
+#endif
+        return;
+    }
+#endif
+
+    static std::mutex mutex;
+    static std::map<std::pair<Model, Model>, std::unique_ptr<JumpTable>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &table = tables[{cpuModel, dasmModel}];
+
+    if (!table) {
+
+        auto fresh = std::make_unique<JumpTable>();
+
+        fresh->exec = std::make_unique<u16[]>(65536);
+        fresh->loop = std::make_unique<u16[]>(65536);
+        if (MOIRA_ENABLE_DASM) fresh->dasm = std::make_unique<u16[]>(65536);
+        if (MOIRA_BUILD_INSTR_INFO_TABLE) fresh->info = std::make_unique<InstrInfo[]>(65536);
+
+        jumpTable = fresh.get();
+        buildJumpTable(cpuModel, dasmModel);
+
+        fresh->execIndices.clear();
+        fresh->dasmIndices.clear();
+        table = std::move(fresh);
+    }
+
+    jumpTable = table.get();
+    execHandlers = table->execHandlers.data();
+    dasmHandlers = table->dasmHandlers.data();
+    exec = table->exec.get();
+    loop = table->loop.get();
+    dasm = table->dasm.get();
+    info = table->info.get();
+}
+
+void
+Moira::buildJumpTable(Model cpuModel, Model dasmModel)
 {
     auto core = [&](Model model) {
         
@@ -185,6 +348,52 @@ Moira::createJumpTable(Model cpuModel, Model dasmModel)
     }
 }
 
+#ifdef MOIRA_TABLE_GENERATOR
+
+void
+Moira::writeJumpTable(std::FILE *file) const
+{
+    assert(cpuModel == Model::M68000 && dasmModel == Model::M68000);
+    assert(jumpTable && dasm && info);
+
+    auto handlers = [&](const char *type, const char *name, const std::vector<std::string> &names) {
+
+        std::fprintf(file, "\nconst Moira::%s Moira::JumpTable::%s[] = {\n", type, name);
+        for (auto &handler : names) std::fprintf(file, "%s,\n", handler.c_str());
+        std::fprintf(file, "};\n");
+    };
+
+    auto indices = [&](const char *name, const u16 *table) {
+
+        std::fprintf(file, "\nconst u16 Moira::JumpTable::%s[65536] = {\n", name);
+        for (int i = 0; i < 0x10000; i++) std::fprintf(file, "%d,%s", table[i], i % 16 == 15 ? "\n" : "");
+        std::fprintf(file, "};\n");
+    };
+
+    std::fprintf(file, "// Jump tables of the 68000 (see MOIRA_STATIC_TABLES).\n");
+    std::fprintf(file, "// Written by Moira::writeJumpTable, do not edit.\n");
+
+    handlers("ExecPtr", "execHandlers68000", jumpTable->execNames);
+    indices("exec68000", exec);
+    indices("loop68000", loop);
+
+    std::fprintf(file, "\n#if MOIRA_ENABLE_DASM == true\n");
+    handlers("DasmPtr", "dasmHandlers68000", jumpTable->dasmNames);
+    indices("dasm68000", dasm);
+    std::fprintf(file, "#endif\n");
+
+    std::fprintf(file, "\n#if MOIRA_BUILD_INSTR_INFO_TABLE == true\n");
+    std::fprintf(file, "\nconst InstrInfo Moira::JumpTable::info68000[65536] = {\n");
+    for (int i = 0; i < 0x10000; i++) {
+
+        std::fprintf(file, "{Instr(%d),Mode(%d),%d},%s",
+                     int(info[i].I), int(info[i].M), info[i].S, i % 8 == 7 ? "\n" : "");
+    }
+    std::fprintf(file, "};\n#endif\n");
+}
+
+#endif
+
 template <Core C> void
 Moira::createJumpTable(Model model, bool regDasm)
 {
@@ -197,7 +406,7 @@ Moira::createJumpTable(Model model, bool regDasm)
     XXXXXXXXXXXXXXXX(Instr::ILLEGAL, Mode::IP, (Size)0, Illegal, CIMS)
 
     for (int i = 0; i < 0x10000; i++) {
-        loop[i] = nullptr;
+        jumpTable->loop[i] = 0;
     }
 
 
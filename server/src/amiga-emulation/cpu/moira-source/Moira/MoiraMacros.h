@@ -14,6 +14,38 @@
 #endif
 #define fatalError      assert(false); unreachable
 
+/* Fault signalling (see MOIRA_THROW_FAULTS)
+ *
+ * THROW_FAULT throws an AddressError, BusError, or DoubleFault, or records it
+ * and returns from the calling function. The optional second argument is the
+ * return value of non-void functions. TRY_FAULT and CATCH_ADDRESS_ERROR let
+ * handlers rectify the stack frame of an address error raised by an operand
+ * access before passing it on with RETHROW_FAULT. CATCH_FAULT matches any
+ * fault; without exceptions, the fault stays pending. PROCESS_FAULTS runs a
+ * statement and processes the fault it raised (if any).
+ */
+#if MOIRA_THROW_FAULTS == true
+
+#define THROW_FAULT(exc, ...)   throw exc
+#define TRY_FAULT               try
+#define CATCH_ADDRESS_ERROR(e)  catch (AddressError &e)
+#define CATCH_FAULT             catch (...)
+#define RETHROW_FAULT(e)        throw e
+#define THROW_ERROR(msg)        throw std::runtime_error(msg)
+#define PROCESS_FAULTS(stmt)    try { stmt; } catch (const std::exception &exc) { processException(exc); }
+
+#else
+
+#define THROW_FAULT(exc, ...)   { raiseFault(exc); return __VA_ARGS__; }
+#define TRY_FAULT
+#define CATCH_ADDRESS_ERROR(e)  if ([[maybe_unused]] auto &e = fault; e.kind == FaultKind::ADDRESS_ERROR)
+#define CATCH_FAULT             if (flags & State::FAULT)
+#define RETHROW_FAULT(e)        return
+#define THROW_ERROR(msg)        { fprintf(stderr, "%s\n", msg); abort(); }
+#define PROCESS_FAULTS(stmt)    { stmt; if (flags & State::FAULT) processFault(); }
+
+#endif
+
 #if MOIRA_PRECISE_TIMING == true
 
 #define SYNC(x)         { if constexpr (C != Core::C68020) sync(x); }
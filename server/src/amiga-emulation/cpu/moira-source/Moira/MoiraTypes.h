@@ -7,11 +7,12 @@
 
 #pragma once
 
+#include "MoiraConfig.h"
 #include <cstdint>
 #include <string>
 #include <optional>
 
-namespace moira {
+namespace MOIRA_NAMESPACE {
 
 //
 // Basic data types
@@ -243,6 +244,24 @@ enum class AddrSpace
     PROG = 2                    // Program space
 };
 
+// Last operation that set the condition codes (MOIRA_LAZY_FLAGS)
+enum class FlagOp : u8
+{
+    NONE,                       // Flags are up to date in the status register
+    ADD,                        // ADD, ADDI, ADDQ
+    SUB,                        // SUB, SUBI, SUBQ, CMP, CMPA, CMPI, CMPM
+    LOGIC                       // AND, OR, EOR and their immediate variants
+};
+
+// Fault recorded instead of a thrown exception (MOIRA_THROW_FAULTS)
+enum class FaultKind : u8
+{
+    NONE,
+    ADDRESS_ERROR,
+    BUS_ERROR,
+    DOUBLE_FAULT
+};
+
 
 //
 // Structures
@@ -260,6 +279,15 @@ struct StackFrame
     u16 ssw;                    // Special status word (68010)
 };
 
+// Pending address error, bus error, or double fault (MOIRA_THROW_FAULTS)
+struct PendingFault {
+
+    FaultKind kind;
+    StackFrame stackFrame;      // Unused for double faults
+    u32 pc;                     // Program counter at the time of the fault
+    u32 pc0;                    // Beginning of the faulting instruction
+};
+
 struct StatusRegister {
     
     bool t1;                    // Trace flag
@@ -275,6 +303,16 @@ struct StatusRegister {
     u8 ipl;                     // Required Interrupt Priority Level
 };
 
+// Operands of FlagOp (MOIRA_LAZY_FLAGS)
+struct LazyFlags {
+
+    FlagOp op;
+    u32 msb;                    // Sign bit of the operand size
+    u32 op1;
+    u32 op2;
+    u64 result;                 // Including the carry bit
+};
+
 struct Registers {
     
     u32 pc;                     // Program counter
@@ -416,6 +454,9 @@ static constexpr int CHECK_WP       = (1 << 8);
 // Enables checking for catchpoints.
 static constexpr int CHECK_CP       = (1 << 9);
 
+// A fault is pending and is processed when the instruction handler returns (MOIRA_THROW_FAULTS == false).
+static constexpr int FAULT          = (1 << 10);
+
 }
 
 /* Instruction Flags
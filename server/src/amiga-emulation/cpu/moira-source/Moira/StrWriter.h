@@ -7,7 +7,9 @@
 
 #pragma once
 
-namespace moira {
+#include "MoiraConfig.h"
+
+namespace MOIRA_NAMESPACE {
 
 //
 // Wrapper structures controlling the output format
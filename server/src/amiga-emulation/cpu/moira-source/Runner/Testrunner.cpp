@@ -256,6 +256,7 @@ void run(unsigned seed)
             if constexpr (CHECK_CPU) runCPU(i);
             if constexpr (CHECK_MMU) runMMU(i);
             if constexpr (CHECK_FPU) runFPU(i);
+            if constexpr (PROFILE_DISPATCH) runDispatch(i);
 
             // Switch the CPU core
             if (cpuModel == Model::M68040) break;
@@ -334,6 +335,59 @@ void runFPU(long round)
     passed();
 }
 
+// Returns a random instruction that only accesses data registers
+static u16 randomRegisterInstr()
+{
+    u16 x = u16(rand() & 7), y = u16(rand() & 7);
+
+    switch (rand() % 8) {
+
+        case 0:  return u16(0x7000 | y << 9 | (rand() & 0xFF));     // MOVEQ   #i,Dy
+        case 1:  return u16(0x2000 | y << 9 | x);                   // MOVE.L  Dx,Dy
+        case 2:  return u16(0xD080 | y << 9 | x);                   // ADD.L   Dx,Dy
+        case 3:  return u16(0x9080 | y << 9 | x);                   // SUB.L   Dx,Dy
+        case 4:  return u16(0xB080 | y << 9 | x);                   // CMP.L   Dx,Dy
+        case 5:  return u16(0x5080 | y << 9 | x);                   // ADDQ.L  #y,Dx
+        case 6:  return u16(0xE000 | y << 9 | (rand() & 0x100) |    // Shifts and rotations
+                            (rand() % 3) << 6 | (rand() & 3) << 3 | x);
+        default: return u16(0xC140 | y << 9 | x);                   // EXG     Dy,Dx
+    }
+}
+
+void runDispatch(long round)
+{
+    Setup setup;
+
+    printf("%s Dispatch ", selectedModel()); fflush(stdout);
+    setupTestEnvironment(setup, round);
+
+    // Fill the memory with random instructions and branch back at the end.
+    // They use several thousand opcodes, so the jump table lookups dominate.
+    const u32 end = 0xF000;
+    for (u32 addr = pc; addr < end; addr += 2) {
+        set16(setup.mem, addr, randomRegisterInstr());
+    }
+    set16(setup.mem, end, 0x6000);                                  // BRA.W   start
+    set16(setup.mem, end + 2, u16(pc - (end + 2)));
+    memcpy(moiraMem, setup.mem, sizeof(moiraMem));
+    resetMoira(setup);
+
+    clock_t elapsed = 0;
+
+    for (int i = 0; i < 32; i++) {
+
+        printf("."); fflush(stdout);
+
+        clock_t start = clock();
+        for (int j = 0; j < 0x40000; j++) moiracpu->execute();
+        elapsed += clock() - start;
+    }
+
+    double seconds = elapsed / double(CLOCKS_PER_SEC);
+    printf(" DONE   (Moira: %.2fs, %.1f ns per instruction)\n",
+           seconds, seconds * 1e9 / (32 * 0x40000));
+}
+
 void passed()
 {
     printf(" PASSED ");
@@ -143,6 +143,7 @@ void run(unsigned seed);
 void runCPU(long round);
 void runMMU(long round);
 void runFPU(long round);
+void runDispatch(long round);
 void passed();
 
 void runSingleTest(Setup &s, u16 op);
@@ -36,6 +36,9 @@ static const bool PROFILE_CPU = true;
 // Set to true to measure the disassembler speed
 static const bool PROFILE_DASM = false;
 
+// Set to true to measure the instruction dispatch speed
+static const bool PROFILE_DISPATCH = true;
+
 // Change to limit the range of executed instructions
 #define doExec(opcode) (opcode >= 0x0000 && opcode <= 0xEFFF)
 
@@ -0,0 +1,25 @@
+// Jump table generator: writes the jump tables of the 68000 as C++ source to
+// standard output. The build scripts compile it for the host and run it
+// before the door cores, which compile the output (MoiraTables.h) in with
+// MOIRA_STATIC_TABLES, so no door builds its tables at runtime.
+//
+// The tables are built the way a core without static tables builds them, with
+// the disassembler and the info table enabled, so that the output serves both
+// door profiles. It holds handler indices and the names of the handlers, not
+// their addresses, and is the same for native and WASM builds.
+
+#define MOIRA_NAMESPACE                 moira_tables
+#define MOIRA_TABLE_GENERATOR
+#define MOIRA_ENABLE_DASM               true
+#define MOIRA_BUILD_INSTR_INFO_TABLE    true
+
+#include "Moira.cpp"
+#include "MoiraDebugger.cpp"
+#include "moira-cpu.cpp"
+
+int main() {
+    // Constructing a CPU binds the tables of the 68000
+    moira_tables::MoiraCPU cpu(GuestMemory::PAGE_SIZE);
+    cpu.writeJumpTable(stdout);
+    return 0;
+}
@@ -1,145 +1,130 @@
-#include "moira-source/Moira/Moira.h"
+#include "door-host.h"
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include "door-thread.h"
+#endif
 #include <emscripten/bind.h>
-#include <cstdint>
-#include <vector>
 
 using namespace emscripten;
-using namespace moira;
 
-// Custom CPU implementation with memory callbacks
-class MoiraCPU : public Moira {
-private:
-    std::vector<uint8_t> memory;
-    val jsTrapHandler;
-    bool trapHandlerSet = false;
-
-public:
-    MoiraCPU(size_t memSize) : memory(memSize, 0), jsTrapHandler(val::undefined()) {
-        cpuModel = Model::M68000;
-    }
-
-    // Implement pure virtual memory access methods
-    u8 read8(u32 addr) const override {
-        return (addr < memory.size()) ? memory[addr] : 0;
-    }
-
-    u16 read16(u32 addr) const override {
-        // 68000 has 24-bit address bus, library addresses are in upper 24-bit space
-        // Library addresses: 0x00FF0000 - 0x00FFFFFF (top 1MB of 24-bit address space)
-        if (addr >= 0x00FF0000 && addr <= 0x00FFFFFF) {
-            // Sign-extend to get the library offset
-            // E.g., 0x00FFFFC4 -> 0xFFFFFFC4 -> -60
-            i32 offset;
-            if (addr >= 0x00FF8000) {
-                // Upper half: sign-extend from 24-bit to 32-bit
-                offset = (i32)(addr | 0xFF000000);
-            } else {
-                offset = (i32)addr;
-            }
-
-            // Call the trap handler
-            if (trapHandlerSet && !jsTrapHandler.isUndefined()) {
-                jsTrapHandler(offset);
-            }
-
-            // Return RTS instruction so execution continues
-            return 0x4E75;
-        }
-
-        // Normal memory read
-        if (addr + 1 < memory.size()) {
-            return (memory[addr] << 8) | memory[addr + 1];
-        }
-
-        // Out of bounds - return 0
-        return 0;
-    }
-
-    void write8(u32 addr, u8 val) const override {
-        if (addr < memory.size()) {
-            const_cast<MoiraCPU*>(this)->memory[addr] = val;
-        }
-    }
-
-    void write16(u32 addr, u16 val) const override {
-        if (addr + 1 < memory.size()) {
-            const_cast<MoiraCPU*>(this)->memory[addr] = (val >> 8) & 0xFF;
-            const_cast<MoiraCPU*>(this)->memory[addr + 1] = val & 0xFF;
-        }
-    }
-
-    // Set memory
-    void setMemoryByte(uint32_t addr, uint8_t value) {
-        if (addr < memory.size()) {
-            memory[addr] = value;
-        }
-    }
+// Returns the event as a plain number (same values as the event record)
+static uint32_t executeUntilEvent(DoorCPU &cpu, int maxCycles) {
+    return (uint32_t)cpu.executeUntilEvent(maxCycles);
+}
 
-    uint8_t getMemoryByte(uint32_t addr) {
-        return (addr < memory.size()) ? memory[addr] : 0;
-    }
+// Profiles are passed as plain numbers (DoorProfile)
+static DoorCPU *createCPU(size_t memSize, uint32_t profile) {
+    return DoorCPU::create(memSize, (DoorProfile)profile);
+}
 
-    // Load program
-    void loadProgram(const std::vector<uint8_t>& program, uint32_t address) {
-        for (size_t i = 0; i < program.size() && (address + i) < memory.size(); i++) {
-            memory[address + i] = program[i];
-        }
-    }
+static uint32_t getProfile(DoorCPU &cpu) {
+    return (uint32_t)cpu.getProfile();
+}
 
-    // Override willExecute - currently only called for STOP, TAS, BKPT
-    void willExecute(const char *func, Instr I, Mode M, Size S, u16 opcode) override {
-        // No-op for now - can be used for debugging if needed
-    }
+static int createContext(DoorHost &host, size_t memSize, uint32_t profile) {
+    return host.createContext(memSize, (DoorProfile)profile);
+}
 
-    // Set trap handler
-    void setTrapHandler(val handler) {
-        jsTrapHandler = handler;
-        trapHandlerSet = true;
-    }
+static void setProfile(DoorHost &host, int id, uint32_t profile) {
+    host.setProfile(id, (DoorProfile)profile);
+}
 
-    // Reset CPU
-    void resetCPU() {
-        reset();
-    }
+// Emscripten bindings
+EMSCRIPTEN_BINDINGS(moira_module) {
+    class_<DoorCPU>("MoiraCPU")
+        .constructor(&createCPU, allow_raw_pointers())
+        .function("getProfile", &getProfile)
+        .function("takeOver", &DoorCPU::takeOver, allow_raw_pointers())
+        .function("saveSnapshot", &DoorCPU::saveSnapshot, allow_raw_pointers())
+        .function("restoreSnapshot", &DoorCPU::restoreSnapshot, allow_raw_pointers())
+        .function("freeze", &DoorCPU::freeze, allow_raw_pointers())
+        .function("fork", &DoorCPU::fork, allow_raw_pointers())
+        .function("setMemoryByte", &DoorCPU::setMemoryByte)
+        .function("getMemoryByte", &DoorCPU::getMemoryByte)
+        .function("getMemoryPointer", &DoorCPU::getMemoryPointer)
+        .function("getMemorySize", &DoorCPU::getMemorySize)
+        .function("fillMemory", &DoorCPU::fillMemory)
+        .function("copyMemory", &DoorCPU::copyMemory)
+        .function("invalidateCode", &DoorCPU::invalidateCode)
+        .function("getPageTypesPointer", &DoorCPU::getPageTypesPointer)
+        .function("protectMemory", &DoorCPU::protectMemory)
+        .function("getBusFault", &DoorCPU::getBusFault)
+        .function("commitMemory", &DoorCPU::commitMemory)
+        .function("getPageBackingPointer", &DoorCPU::getPageBackingPointer)
+        .function("getReadPointer", &DoorCPU::getReadPointer)
+        .function("getSharedPageCount", &DoorCPU::getSharedPageCount)
+        .function("getCommittedPageCount", &DoorCPU::getCommittedPageCount)
+        .function("loadHunks", &DoorCPU::loadHunks, allow_raw_pointers())
+        .function("initHeap", &DoorCPU::initHeap)
+        .function("allocMem", &DoorCPU::allocMem)
+        .function("freeMem", &DoorCPU::freeMem)
+        .function("allocVec", &DoorCPU::allocVec)
+        .function("freeVec", &DoorCPU::freeVec)
+        .function("availMem", &DoorCPU::availMem)
+        .function("getConsoleBufferPointer", &DoorCPU::getConsoleBufferPointer)
+        .function("readOutput", &DoorCPU::readOutput)
+        .function("writeInput", &DoorCPU::writeInput)
+        .function("readInput", &DoorCPU::readInput)
+        .function("pendingInput", &DoorCPU::pendingInput)
+        .function("resetCPU", &DoorCPU::resetCPU)
+        .function("executeCycles", &DoorCPU::executeCycles)
+        .function("getRegisterFilePointer", &DoorCPU::getRegisterFilePointer)
+        .function("setBatchedTraps", &DoorCPU::setBatchedTraps)
+        .function("getEventRecordPointer", &DoorCPU::getEventRecordPointer)
+        .function("executeUntilEvent", &executeUntilEvent)
+        .function("completeTrap", &DoorCPU::completeTrap)
+        .function("setJitThreshold", &DoorCPU::setJitThreshold)
+        .function("setJitEntry", &DoorCPU::setJitEntry)
+        ;
 
-    // Execute cycles (returns cycles executed via getClock)
-    int executeCycles(int cycles) {
-        i64 startClock = getClock();
-        execute(cycles);
-        return (int)(getClock() - startClock);
-    }
+    class_<DoorSnapshot>("DoorSnapshot")
+        .constructor<>()
+        .function("getPointer", &DoorSnapshot::getPointer)
+        .function("getSize", &DoorSnapshot::getSize)
+        .function("resize", &DoorSnapshot::resize)
+        ;
 
-    // Get registers
-    uint32_t getRegister(int reg) {
-        if (reg < 8) return this->reg.d[reg];
-        if (reg < 16) return this->reg.a[reg - 8];
-        if (reg == 16) return this->reg.pc;
-        if (reg == 17) return getSR();
-        return 0;
-    }
+    class_<DoorImage>("DoorImage")
+        .constructor<>()
+        ;
 
-    // Set registers
-    void setRegister(int reg, uint32_t value) {
-        if (reg < 8) this->reg.d[reg] = value;
-        else if (reg < 16) this->reg.a[reg - 8] = value;
-        else if (reg == 16) this->reg.pc = value;
-        else if (reg == 17) setSR(value);
-    }
-};
+    class_<HunkCache>("HunkCache")
+        .constructor<>()
+        .function("getFileBuffer", &HunkCache::getFileBuffer)
+        .function("load", &HunkCache::load)
+        .function("getParseCount", &HunkCache::getParseCount)
+        .function("getCapacity", &HunkCache::getCapacity)
+        .function("setCapacity", &HunkCache::setCapacity)
+        .function("getImageCount", &HunkCache::getImageCount)
+        .function("getCodeShareCount", &HunkCache::getCodeShareCount)
+        .function("getEntryPoint", &HunkCache::getEntryPoint)
+        .function("getEnd", &HunkCache::getEnd)
+        .function("getSegmentCount", &HunkCache::getSegmentCount)
+        .function("getSegmentAddress", &HunkCache::getSegmentAddress)
+        .function("getSegmentSize", &HunkCache::getSegmentSize)
+        .function("getSegmentType", &HunkCache::getSegmentType)
+        ;
 
-// Emscripten bindings
-EMSCRIPTEN_BINDINGS(moira_module) {
-    class_<MoiraCPU>("MoiraCPU")
-        .constructor<size_t>()
-        .function("setMemoryByte", &MoiraCPU::setMemoryByte)
-        .function("getMemoryByte", &MoiraCPU::getMemoryByte)
-        .function("loadProgram", &MoiraCPU::loadProgram)
-        .function("resetCPU", &MoiraCPU::resetCPU)
-        .function("executeCycles", &MoiraCPU::executeCycles)
-        .function("getRegister", &MoiraCPU::getRegister)
-        .function("setRegister", &MoiraCPU::setRegister)
-        .function("setTrapHandler", &MoiraCPU::setTrapHandler)
+    class_<DoorHost>("DoorHost")
+        .constructor<>()
+        .function("createContext", &createContext)
+        .function("destroyContext", &DoorHost::destroyContext)
+        .function("getContext", &DoorHost::getContext, allow_raw_pointers())
+        .function("setProfile", &setProfile)
+        .function("resume", &DoorHost::resume)
+        .function("suspend", &DoorHost::suspend)
+        .function("tick", &DoorHost::tick)
+        .function("getEventsPointer", &DoorHost::getEventsPointer)
         ;
 
-    register_vector<uint8_t>("VectorUint8");
+#ifdef __EMSCRIPTEN_PTHREADS__
+    class_<DoorThread>("DoorThread")
+        .constructor<DoorCPU *, int>(allow_raw_pointers())
+        .function("start", &DoorThread::start)
+        .function("resume", &DoorThread::resume)
+        .function("stop", &DoorThread::stop)
+        .function("pollEvent", &DoorThread::pollEvent)
+        .function("getEventRecordPointer", &DoorThread::getEventRecordPointer)
+        .function("getSignalPointer", &DoorThread::getSignalPointer)
+        ;
+#endif
 }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free ring buffer for one producer thread and one consumer thread.
+//
+// The producer only writes tail and the consumer only writes head; each side
+// reads the other's index with acquire semantics, so an element is fully
+// written before the consumer can see it. Indices run freely and wrap at
+// 2^32; N must be a power of two. The ring lives in the (shared) WASM heap
+// like every other object, so no extra shared buffer is needed.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    // Separate cache lines, so producer and consumer do not share one
+    alignas(64) std::atomic<uint32_t> head {0};   // Next slot to read
+    alignas(64) std::atomic<uint32_t> tail {0};   // Next slot to write
+    T slots[N];
+
+public:
+    // Producer side. Returns false if the ring is full.
+    bool push(const T &value) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool pop(T &value) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side. Pushes up to count elements at once and returns how
+    // many fit.
+    size_t push(const T *values, size_t count) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        size_t n = std::min<size_t>(count, N - (t - head.load(std::memory_order_acquire)));
+        size_t first = std::min(n, N - (t & (N - 1)));
+        std::copy_n(values, first, slots + (t & (N - 1)));
+        std::copy_n(values + first, n - first, slots);
+        tail.store(t + (uint32_t)n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side. Pops up to count elements at once and returns how many
+    // there were.
+    size_t pop(T *values, size_t count) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        size_t n = std::min<size_t>(count, tail.load(std::memory_order_acquire) - h);
+        size_t first = std::min(n, N - (h & (N - 1)));
+        std::copy_n(slots + (h & (N - 1)), first, values);
+        std::copy_n(slots, n - first, values + first);
+        head.store(h + (uint32_t)n, std::memory_order_release);
+        return n;
+    }
+
+    // Producer side
+    size_t space() const {
+        return N - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+    }
+
+    // Either side (a snapshot)
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Consumer side
+    bool empty() const {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+    // Producer side
+    bool full() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == N;
+    }
+};
@@ -49,7 +49,7 @@ export function setupDoorHandlers(socket: Socket): void {
       const session = new AmigaDoorSession(socket, {
         executablePath,
         timeout: 600,  // 10 minutes
-        memorySize: 1024 * 1024  // 1MB
+        memorySize: 8 * 1024 * 1024  // 8MB, committed as the door touches it
       });
 
       activeSessions.set(socket.id, session);
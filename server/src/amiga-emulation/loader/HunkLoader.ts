@@ -191,9 +191,7 @@ export class HunkLoader {
       console.log(`[HunkLoader] Loading ${segment.type} segment at 0x${segment.address.toString(16)}`);
 
       // Copy segment data to emulator memory
-      for (let i = 0; i < segment.data.length; i++) {
-        emulator.writeMemory(segment.address + i, segment.data[i]);
-      }
+      emulator.writeMemoryBlock(segment.address, segment.data);
     }
 
     // Apply relocations
@@ -206,22 +204,9 @@ export class HunkLoader {
         const targetSegment = hunkFile.segments[reloc.targetSegment];
         const relocAddress = segment.address + reloc.offset;
 
-        // Read the current value at the relocation point
-        const byte0 = emulator.readMemory(relocAddress);
-        const byte1 = emulator.readMemory(relocAddress + 1);
-        const byte2 = emulator.readMemory(relocAddress + 2);
-        const byte3 = emulator.readMemory(relocAddress + 3);
-
-        const currentValue = (byte0 << 24) | (byte1 << 16) | (byte2 << 8) | byte3;
-
-        // Add the target segment's base address
-        const newValue = currentValue + targetSegment.address;
-
-        // Write back the relocated address (big-endian)
-        emulator.writeMemory(relocAddress, (newValue >> 24) & 0xFF);
-        emulator.writeMemory(relocAddress + 1, (newValue >> 16) & 0xFF);
-        emulator.writeMemory(relocAddress + 2, (newValue >> 8) & 0xFF);
-        emulator.writeMemory(relocAddress + 3, newValue & 0xFF);
+        // Add the target segment's base address to the value at the relocation point
+        const currentValue = emulator.readLong(relocAddress);
+        emulator.writeLong(relocAddress, currentValue + targetSegment.address);
       }
     }
 
@@ -127,9 +127,7 @@ export class LibraryLoader {
         console.log(`[LibraryLoader] Loading ${segment.type} segment (${segment.size} bytes) at 0x${currentAddress.toString(16)}`);
 
         // Copy segment data to memory
-        for (let i = 0; i < segment.data.length; i++) {
-          this.emulator.writeMemory(currentAddress + i, segment.data[i]);
-        }
+        this.emulator.writeMemoryBlock(currentAddress, segment.data);
 
         if (segment.type === 'code') {
           codeSegments.push({ address: currentAddress, size: segment.size });
@@ -197,21 +195,9 @@ export class LibraryLoader {
         const targetSegment = hunkFile.segments[reloc.targetSegment];
         const relocAddress = baseAddress + reloc.offset;
 
-        // Read current value (big-endian 32-bit)
-        const byte0 = this.emulator.readMemory(relocAddress);
-        const byte1 = this.emulator.readMemory(relocAddress + 1);
-        const byte2 = this.emulator.readMemory(relocAddress + 2);
-        const byte3 = this.emulator.readMemory(relocAddress + 3);
-        const currentValue = (byte0 << 24) | (byte1 << 16) | (byte2 << 8) | byte3;
-
-        // Add base address
-        const newValue = currentValue + baseAddress;
-
-        // Write back (big-endian)
-        this.emulator.writeMemory(relocAddress, (newValue >> 24) & 0xFF);
-        this.emulator.writeMemory(relocAddress + 1, (newValue >> 16) & 0xFF);
-        this.emulator.writeMemory(relocAddress + 2, (newValue >> 8) & 0xFF);
-        this.emulator.writeMemory(relocAddress + 3, newValue & 0xFF);
+        // Add base address (big-endian 32-bit)
+        const currentValue = this.emulator.readLong(relocAddress);
+        this.emulator.writeLong(relocAddress, currentValue + baseAddress);
       }
     }
   }
@@ -257,11 +243,7 @@ export class LibraryLoader {
 
       if (opcode === 0x4EF9) {
         // Read target address (next 4 bytes)
-        const addr0 = this.emulator.readMemory(address + 2);
-        const addr1 = this.emulator.readMemory(address + 3);
-        const addr2 = this.emulator.readMemory(address + 4);
-        const addr3 = this.emulator.readMemory(address + 5);
-        const targetAddress = (addr0 << 24) | (addr1 << 16) | (addr2 << 8) | addr3;
+        const targetAddress = this.emulator.readLong(address + 2);
 
         jumpTable.set(offset, targetAddress);
         console.log(`[LibraryLoader] Jump table entry: offset ${offset} -> 0x${targetAddress.toString(16)}`);
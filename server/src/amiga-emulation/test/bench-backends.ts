@@ -0,0 +1,108 @@
+/**
+ * Backend benchmark - runs the same door binaries on the native addon and
+ * the WASM module and compares throughput
+ *
+ * Usage: bench-backends.ts [door...] (default: the doors in server/BBS/Doors)
+ * Build the native addon with cpu/build-native.sh and the WASM module with
+ * cpu/build-wasm.sh first.
+ */
+
+import { MoiraEmulator, MoiraBackend, ExecEvent } from '../cpu/MoiraEmulator';
+import { AmigaDosEnvironment } from '../api/AmigaDosEnvironment';
+import { HunkLoader } from '../loader/HunkLoader';
+import * as fs from 'fs';
+import * as path from 'path';
+
+const SLICE_CYCLES = 100000;
+const MAX_CYCLES = 200_000_000;  // Per run
+const MAX_MILLISECONDS = 10000;  // Per run
+const MIN_MILLISECONDS = 1000;   // Short doors are rerun until they add up to this
+
+interface BenchResult {
+  event: ExecEvent;
+  cycles: number;   // Executed (without fast-forwarded idle cycles)
+  milliseconds: number; // Execution only, without loading the door
+  runs: number;
+}
+
+/**
+ * Load a door like AmigaDoorSession does and run it until it exits, fails
+ * or hits one of the limits
+ */
+async function runDoor(backend: MoiraBackend, binary: Buffer): Promise<BenchResult> {
+  const emulator = new MoiraEmulator(1024 * 1024, null, backend);
+  await emulator.initialize();
+  const environment = new AmigaDosEnvironment(emulator);
+  environment.setOutputCallback(() => {});
+  // Doors that prompt get an answer instead of idling until the limit
+  environment.queueInput('\r'.repeat(64));
+
+  const hunkLoader = new HunkLoader();
+  const hunkFile = hunkLoader.parse(binary);
+  hunkLoader.load(emulator, hunkFile);
+  emulator.writeLong(0x0, 0xFE000);
+  emulator.writeLong(0x4, hunkFile.entryPoint);
+  emulator.reset();
+  emulator.writeLong(0x4, 0xFF8000);
+  const sp = emulator.getRegister(15) - 4;
+  emulator.writeLong(sp, MoiraEmulator.EXIT_ADDRESS);
+  emulator.setRegister(15, sp);
+
+  const start = process.hrtime.bigint();
+  let cycles = 0;
+  let event = ExecEvent.BUDGET;
+  let milliseconds = 0;
+  while (cycles < MAX_CYCLES && milliseconds < MAX_MILLISECONDS) {
+    const result = emulator.runUntilEvent(SLICE_CYCLES);
+    cycles += result.cycles - result.idle;
+    event = result.event;
+    milliseconds = Number(process.hrtime.bigint() - start) / 1e6;
+    if (event !== ExecEvent.BUDGET && event !== ExecEvent.IDLE) break;
+  }
+
+  emulator.cleanup();
+  return { event, cycles, milliseconds, runs: 1 };
+}
+
+async function benchDoor(backend: MoiraBackend, binary: Buffer): Promise<BenchResult> {
+  const total = await runDoor(backend, binary);
+  while (total.milliseconds < MIN_MILLISECONDS) {
+    const result = await runDoor(backend, binary);
+    total.cycles += result.cycles;
+    total.milliseconds += result.milliseconds;
+    total.runs++;
+  }
+  return total;
+}
+
+async function bench() {
+  const doorsDir = path.join(__dirname, '../../../BBS/Doors');
+  const doors = process.argv.length > 2 ? process.argv.slice(2) :
+    fs.readdirSync(doorsDir).flatMap(dir =>
+      fs.readdirSync(path.join(doorsDir, dir)).filter(f => f.endsWith('.XIM')).map(f => path.join(doorsDir, dir, f)));
+
+  console.log('=== Moira backend benchmark ===\n');
+  for (const door of doors) {
+    const binary = fs.readFileSync(door);
+    console.log(`${path.basename(door)} (${binary.length} bytes)`);
+
+    const rates: Partial<Record<MoiraBackend, number>> = {};
+    for (const backend of ['native', 'wasm'] as MoiraBackend[]) {
+      try {
+        const result = await benchDoor(backend, binary);
+        rates[backend] = result.cycles / result.milliseconds / 1000;
+        console.log(`  ${backend.padEnd(6)} ${ExecEvent[result.event].padEnd(7)} ` +
+          `${result.runs} run(s), ${(result.cycles / 1e6).toFixed(1)} Mcycles, ` +
+          `${result.milliseconds.toFixed(1)} ms, ${rates[backend]!.toFixed(1)} Mcycles/s`);
+      } catch (error) {
+        console.log(`  ${backend.padEnd(6)} unavailable (${error instanceof Error ? error.message : error})`);
+      }
+    }
+    if (rates.native && rates.wasm) {
+      console.log(`  native/wasm: ${(rates.native / rates.wasm).toFixed(2)}x`);
+    }
+    console.log();
+  }
+}
+
+bench().catch(console.error);
@@ -0,0 +1,39 @@
+import type { MoiraEmulator, MoiraProfile } from '../cpu/MoiraEmulator';
+
+/** The CPU profiles, for tests that run the same door on each of them */
+export const PROFILES: MoiraProfile[] = ['fast', 'accurate'];
+
+/**
+ * Pass/fail bookkeeping of the test scripts: check() prints one line per
+ * check, summary() prints the outcome of the script
+ */
+export function createChecks() {
+  let failures = 0;
+  return {
+    check(name: string, ok: boolean): void {
+      console.log(`  ${ok ? '✓' : '✗'} ${name}`);
+      if (!ok) failures++;
+    },
+    summary(suite: string): void {
+      console.log(failures === 0 ? `All ${suite} tests passed` : `${failures} ${suite} test(s) failed`);
+    },
+  };
+}
+
+/** Big-endian bytes of a list of 68000 instruction words */
+export function assemble(words: number[]): Uint8Array {
+  const code = new Uint8Array(words.length * 2);
+  words.forEach((w, i) => { code[i * 2] = w >> 8; code[i * 2 + 1] = w & 0xFF; });
+  return code;
+}
+
+/**
+ * Load code at base (unless it is already in memory) and reset the CPU
+ * into it, with the supervisor stack below 0x8000
+ */
+export function bootDoor(emu: MoiraEmulator, code: Uint8Array | null, base: number = 0x1000): void {
+  emu.writeLong(0, 0x8000);
+  emu.writeLong(4, base);
+  if (code) emu.loadProgram(code, base);
+  emu.reset();
+}
@@ -0,0 +1,91 @@
+import { MoiraEmulator, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Exercise the console rings: dos.library Read/Write/Input/Output and the
+ * AEDoor console functions, serviced by the CPU without reaching the host
+ */
+async function test() {
+  console.log('Testing door console...');
+
+  const { check, summary } = createChecks();
+
+  const MESSAGE = 0x2000;
+  const DONE = 0x2010;
+  const READ_BUFFER = 0x3000;
+  const LINE_BUFFER = 0x3100;
+
+  // A door writing a line 1000 times through dos.library, one more through
+  // AEPuts, then reading 3 bytes with Read, a line with AEGets and a
+  // character with AEGetCh
+  const door = [
+    0x4EB9, 0xFFFF, 0xFFC4,         //        jsr     $FFFFFFC4       Output
+    0x2200,                         //        move.l  d0,d1
+    0x243C, 0x0000, MESSAGE,        //        move.l  #MESSAGE,d2
+    0x7606,                         //        moveq   #6,d3
+    0x3E3C, 0x03E7,                 //        move.w  #999,d7
+    0x4EB9, 0xFFFF, 0xFFD0,         // loop:  jsr     $FFFFFFD0       Write
+    0x51CF, 0xFFF8,                 //        dbra    d7,loop
+    0x2C78, 0x0004,                 //        movea.l 4.w,a6
+    0x43F9, 0x0000, DONE,           //        lea     DONE,a1
+    0x4EAE, 0xFDD8,                 //        jsr     -552(a6)        AEPuts
+    0x4EB9, 0xFFFF, 0xFFCA,         //        jsr     $FFFFFFCA       Input
+    0x2200,                         //        move.l  d0,d1
+    0x243C, 0x0000, READ_BUFFER,    //        move.l  #READ_BUFFER,d2
+    0x7603,                         //        moveq   #3,d3
+    0x4EB9, 0xFFFF, 0xFFD6,         //        jsr     $FFFFFFD6       Read
+    0x2A00,                         //        move.l  d0,d5
+    0x41F8, LINE_BUFFER,            //        lea     LINE_BUFFER.w,a0
+    0x7050,                         //        moveq   #80,d0
+    0x4EAE, 0xFDCE,                 //        jsr     -562(a6)        AEGets
+    0x2C00,                         //        move.l  d0,d6
+    0x4EAE, 0xFDBA,                 //        jsr     -582(a6)        AEGetCh
+    0x4E75,                         //        rts
+  ];
+  const code = assemble(door);
+
+  for (const profile of PROFILES) {
+    const emu = new MoiraEmulator(64 * 1024, null, undefined, profile);
+    await emu.initialize();
+    bootDoor(emu, code);
+    emu.writeMemoryBlock(MESSAGE, Buffer.from('hello\n', 'latin1'));
+    emu.writeMemoryBlock(DONE, Buffer.from('done\r\n\0', 'latin1'));
+    emu.writeLong(4, 0xFF8000);
+    emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+    emu.setRegister(CPURegister.A7, 0x7FFC);
+
+    let output = '';
+    let calls = 0;
+    emu.setConsoleOutput(data => output += data);
+    emu.setTrapHandler(() => calls++);
+    emu.queueConsoleInput('abcHELLO\rX');
+
+    const result = emu.runUntilEvent(10000000);
+    check(`${profile} profile: console calls never reach the host`, result.event === ExecEvent.EXIT && calls === 0);
+    check(`${profile} profile: output arrives complete and in order`, output === 'hello\n'.repeat(1000) + 'done\r\n');
+    check(`${profile} profile: Read takes the requested bytes`,
+      emu.getRegister(CPURegister.D5) === 3 && emu.readString(READ_BUFFER, 3) === 'abc');
+    check(`${profile} profile: AEGets takes one line`,
+      emu.getRegister(CPURegister.D6) === 6 && emu.readString(LINE_BUFFER) === 'HELLO\r');
+    check(`${profile} profile: AEGetCh takes the next character`, emu.getRegister(CPURegister.D0) === 0x58);
+    check(`${profile} profile: input is used up`, !emu.hasConsoleInput());
+    emu.cleanup();
+  }
+
+  // Host side: input waits in the ring until it is taken
+  const emu = new MoiraEmulator(64 * 1024, null, undefined, 'fast');
+  await emu.initialize();
+  emu.queueConsoleInput('xyz');
+  check('queued input is pending', emu.hasConsoleInput());
+  const taken = Buffer.from(emu.readConsoleInput(2)).toString('latin1');
+  check('the host takes input in order', taken === 'xy' && emu.hasConsoleInput());
+
+  // The console moves along with the door to the other profile
+  emu.setProfile('accurate');
+  check('input survives a profile switch', Buffer.from(emu.readConsoleInput(8)).toString('latin1') === 'z');
+  emu.cleanup();
+
+  summary('door console');
+}
+
+test().catch(console.error);
@@ -0,0 +1,97 @@
+import { MoiraEmulator, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Fork doors from a frozen image and check that they share the pages none of
+ * them writes, and that writes stay private to the door making them. Pages
+ * that are all zero in the image are not shared but left untouched.
+ */
+async function test() {
+  console.log('Testing door forks...');
+
+  const { check, summary } = createChecks();
+
+  const MEMORY_SIZE = 64 * 1024;
+  const COUNTER = 0x3000;
+  const TABLE = 0x5000;
+
+  // A door counting in D0 and storing the count after every step
+  const door = [
+    0x7005,                         //        moveq   #5,d0
+    0x5280,                         // loop:  addq.l  #1,d0
+    0x21C0, COUNTER,                //        move.l  d0,COUNTER.w
+    0x60F8,                         //        bra.s   loop
+  ];
+  const source = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await source.initialize();
+  bootDoor(source, assemble(door));
+  source.writeLong(TABLE, 0xCAFEBABE);
+  source.initHeap(0x6000, 0x7000);
+  const image = source.freeze();
+
+  const forks: MoiraEmulator[] = [];
+  for (const profile of PROFILES) {
+    const emu = new MoiraEmulator(MEMORY_SIZE, null, undefined, profile);
+    await emu.initialize();
+    check(`${profile} profile: the door is forked`, emu.fork(image));
+    // Vectors, code and table
+    check(`${profile} profile: the written pages start out shared`,
+      emu.getSharedPageCount() === 3 && emu.getCommittedPageCount() === 0);
+    check(`${profile} profile: registers and heap come from the image`,
+      emu.getRegister(CPURegister.PC) === 0x1000 && emu.availMem() === source.availMem());
+    forks.push(emu);
+  }
+
+  // Forks keep what they need when the image goes away
+  image.delete();
+
+  const [fast, accurate] = forks;
+  const first = fast.runUntilEvent(1000);
+  accurate.runUntilEvent(2000);
+  check('a fork runs the door', first.event === ExecEvent.BUDGET &&
+    fast.readLong(COUNTER) === fast.getRegister(CPURegister.D0) && fast.readLong(COUNTER) > 5);
+  check('only the written page is committed',
+    fast.getCommittedPageCount() === 1 && fast.getSharedPageCount() === 3);
+  check('forks do not see each other\'s writes',
+    accurate.readLong(COUNTER) === accurate.getRegister(CPURegister.D0) &&
+    accurate.readLong(COUNTER) !== fast.readLong(COUNTER));
+  check('the frozen door is left alone', source.readLong(COUNTER) === 0);
+
+  fast.writeLong(TABLE, 1);
+  check('a host write copies the page', fast.getSharedPageCount() === 2 && fast.getCommittedPageCount() === 2 &&
+    fast.readLong(TABLE) === 1 && accurate.readLong(TABLE) === 0xCAFEBABE);
+
+  // A snapshot of a fork holds the shared pages too
+  const snapshot = accurate.saveSnapshot();
+  const restored = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await restored.initialize();
+  check('a snapshot of a fork is complete', restored.restoreSnapshot(snapshot) &&
+    restored.readLong(TABLE) === 0xCAFEBABE && restored.readLong(COUNTER) === accurate.readLong(COUNTER) &&
+    restored.getSharedPageCount() === 0);
+  snapshot.delete();
+  restored.cleanup();
+
+  // Switching profiles keeps sharing the pages
+  const count = accurate.getRegister(CPURegister.D0);
+  const shared = accurate.getSharedPageCount();
+  accurate.setProfile('fast');
+  check('switching profiles keeps the shared pages', shared > 0 && accurate.getSharedPageCount() === shared);
+  accurate.runUntilEvent(1000);
+  check('the fork continues after switching profiles',
+    accurate.getRegister(CPURegister.D0) > count && accurate.readLong(TABLE) === 0xCAFEBABE);
+
+  // Images of another RAM size are refused
+  const other = source.freeze();
+  const larger = new MoiraEmulator(2 * MEMORY_SIZE, null, undefined, 'fast');
+  await larger.initialize();
+  check('an image of another RAM size is refused', !larger.fork(other));
+  larger.cleanup();
+  other.delete();
+
+  forks.forEach(emu => emu.cleanup());
+  source.cleanup();
+
+  summary('door fork');
+}
+
+test().catch(console.error);
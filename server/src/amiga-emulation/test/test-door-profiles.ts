@@ -0,0 +1,79 @@
+import { MoiraEmulator, MoiraProfile, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { DoorScheduler } from '../DoorScheduler';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Run doors on the fast and the accurate core and switch between them
+ */
+async function test() {
+  console.log('Testing door profiles...');
+
+  const { check, summary } = createChecks();
+
+  // Load a program at 0x1000, reset, and push the exit address like AmigaDoorSession
+  const load = (emu: MoiraEmulator, words: number[]) => {
+    bootDoor(emu, assemble(words));
+    emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+    emu.setRegister(CPURegister.A7, 0x7FFC);
+    emu.setRegister(CPURegister.A6, 0xFF8000);
+  };
+
+  const create = async (profile: MoiraProfile): Promise<MoiraEmulator> => {
+    const emu = new MoiraEmulator(64 * 1024, null, undefined, profile);
+    await emu.initialize();
+    return emu;
+  };
+
+  // moveq #0,d0; moveq #31,d1; sum: add.l d1,d0; ror.l #3,d0; jsr -48(a6); dbra d1,sum; rts
+  const checksum = [0x7000, 0x721F, 0xD081, 0xE698, 0x4EAE, 0xFFD0, 0x51C9, 0xFFF6, 0x4E75];
+  const runChecksum = async (profile: MoiraProfile, switchTo?: MoiraProfile) => {
+    const emu = await create(profile);
+    load(emu, checksum);
+    let calls = 0;
+    emu.setTrapHandler(() => {
+      if (++calls === 5 && switchTo) emu.setProfile(switchTo);
+    });
+    const result = emu.runUntilEvent(100000);
+    const run = { event: result.event, d0: emu.getRegister(CPURegister.D0), calls, profile: emu.getProfile() };
+    emu.cleanup();
+    return run;
+  };
+
+  const fast = await runChecksum('fast');
+  const accurate = await runChecksum('accurate');
+  check('fast profile runs the door', fast.event === ExecEvent.EXIT && fast.calls === 32);
+  check('accurate profile computes the same result', accurate.event === ExecEvent.EXIT &&
+    accurate.calls === 32 && accurate.d0 === fast.d0);
+
+  const switched = await runChecksum('fast', 'accurate');
+  check('switching inside a library call continues the door', switched.event === ExecEvent.EXIT &&
+    switched.calls === 32 && switched.d0 === fast.d0 && switched.profile === 'accurate');
+
+  // move.w $1001,d0; rts (odd word access)
+  for (const profile of PROFILES) {
+    const emu = await create(profile);
+    load(emu, [0x3039, 0x0000, 0x1001, 0x4E75]);
+    const result = emu.runUntilEvent(5000);
+    check(`${profile} profile: odd word access ${profile === 'fast' ? 'is ignored' : 'raises an address error'}`,
+      profile === 'fast' ? result.event === ExecEvent.EXIT : result.event === ExecEvent.FAULT && result.pc === 0x1000);
+    emu.cleanup();
+  }
+
+  // loop: addq.l #1,d0; cmp.l #100000,d0; bne.s loop; rts (switched by the door host)
+  const scheduler = await DoorScheduler.getInstance();
+  const emu = await scheduler.createEmulator(64 * 1024, 'accurate');
+  load(emu, [0x5280, 0xB0BC, 0x0001, 0x86A0, 0x66F6, 0x4E75]);
+  emu.runUntilEvent(20000);
+  const d0 = emu.getRegister(CPURegister.D0);
+  const pc = emu.getRegister(CPURegister.PC);
+  emu.setProfile('fast');
+  check('door host context keeps registers when switched', emu.getProfile() === 'fast' &&
+    emu.getRegister(CPURegister.D0) === d0 && emu.getRegister(CPURegister.PC) === pc && d0 > 0);
+  const result = emu.runUntilEvent(10000000);
+  check('switched context runs to the end', result.event === ExecEvent.EXIT && emu.getRegister(CPURegister.D0) === 100000);
+  emu.cleanup();
+
+  summary('door profile');
+}
+
+test().catch(console.error);
@@ -0,0 +1,72 @@
+import { MoiraEmulator, CPURegister, ExecEvent, RunResult } from '../cpu/MoiraEmulator';
+import { DoorScheduler } from '../DoorScheduler';
+import { createChecks, assemble, bootDoor } from './checks';
+
+/**
+ * Run several doors as contexts of one door host
+ */
+async function test() {
+  const scheduler = await DoorScheduler.getInstance();
+  console.log('Testing door scheduler...');
+
+  const { check, summary } = createChecks();
+
+  // Create a door with its program at 0x1000 and the exit address on the stack
+  const create = async (words: number[]): Promise<MoiraEmulator> => {
+    const emu = await scheduler.createEmulator(64 * 1024);
+    bootDoor(emu, assemble(words));
+    emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+    emu.setRegister(CPURegister.A7, 0x7FFC);
+    emu.setRegister(CPURegister.A6, 0xFF8000);
+    return emu;
+  };
+
+  // moveq #0,d1; loop: jsr -48(a6); addq.l #1,d1; cmp.w #200,d1; bne.s loop; rts
+  const caller = await create([0x7200, 0x4EAE, 0xFFD0, 0x5281, 0xB27C, 200, 0x66F4, 0x4E75]);
+  let calls = 0;
+  caller.setTrapHandler(() => { calls++; });
+
+  // move.w #9999,d0; dbra d0,*; rts
+  const delay = await create([0x303C, 9999, 0x51C8, 0xFFFE, 0x4E75]);
+
+  // bra.s *
+  const spinner = await create([0x60FE]);
+
+  const contexts = new Set([caller.getContextId(), delay.getContextId(), spinner.getContextId()]);
+  check('every door gets its own context', contexts.size === 3);
+
+  // Run until both finite doors have exited
+  const finished = new Map<MoiraEmulator, RunResult>();
+  let spinnerSlices = 0;
+  await new Promise<void>((resolve) => {
+    const onExit = (emu: MoiraEmulator) => (result: RunResult) => {
+      if (result.event === ExecEvent.EXIT) {
+        finished.set(emu, result);
+        scheduler.stop(emu);
+        if (finished.size === 2) resolve();
+      }
+    };
+    const onError = (error: unknown) => { console.error(error); resolve(); };
+    scheduler.start(caller, onExit(caller), onError);
+    scheduler.start(delay, onExit(delay), onError);
+    scheduler.start(spinner, (result) => { if (result.event === ExecEvent.IDLE) spinnerSlices++; }, onError);
+  });
+
+  check('library calls are serviced between ticks', calls === 200 && caller.getRegister(CPURegister.D1) === 200);
+  check('delay loop door exits', finished.get(delay)?.event === ExecEvent.EXIT);
+  check('idle door keeps getting slices', spinnerSlices > 0);
+
+  scheduler.stop(spinner);
+  caller.cleanup();
+  delay.cleanup();
+  spinner.cleanup();
+
+  // Destroyed contexts are reused
+  const reused = await scheduler.createEmulator(4096);
+  check('context ids are reused', contexts.has(reused.getContextId()));
+  reused.cleanup();
+
+  summary('door scheduler');
+}
+
+test().catch(console.error);
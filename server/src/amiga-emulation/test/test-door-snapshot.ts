@@ -0,0 +1,98 @@
+import { MoiraEmulator, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Save a door halfway through its run and continue it from the snapshot in
+ * fresh emulators of both profiles
+ */
+async function test() {
+  console.log('Testing door snapshots...');
+
+  const { check, summary } = createChecks();
+
+  const MEMORY_SIZE = 64 * 1024;
+  const BUFFER = 0x3000;
+
+  // A door filling a buffer with a running checksum and allocating a block
+  // through ExecBase after every 256 bytes
+  const door = [
+    0x2C78, 0x0004,                 //        movea.l 4.w,a6
+    0x41F8, BUFFER,                 //        lea     BUFFER.w,a0
+    0x7000,                         //        moveq   #0,d0
+    0x7E0F,                         //        moveq   #15,d7
+    0x3C3C, 0x00FF,                 // outer: move.w  #255,d6
+    0xD03C, 0x0007,                 // inner: add.b   #7,d0
+    0x10C0,                         //        move.b  d0,(a0)+
+    0x51CE, 0xFFF8,                 //        dbra    d6,inner
+    0x2F00,                         //        move.l  d0,-(sp)
+    0x7040,                         //        moveq   #64,d0
+    0x7200,                         //        moveq   #0,d1
+    0x4EAE, 0xFF3A,                 //        jsr     -198(a6)        AllocMem
+    0x2A40,                         //        movea.l d0,a5
+    0x201F,                         //        move.l  (sp)+,d0
+    0x51CF, 0xFFE2,                 //        dbra    d7,outer
+    0x4E75,                         //        rts
+  ];
+  const source = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await source.initialize();
+  bootDoor(source, assemble(door));
+  source.writeLong(4, 0xFF8000);
+  source.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+  source.setRegister(CPURegister.A7, 0x7FFC);
+  source.initHeap(0x4000, 0x7000);
+  source.protectMemory(0x9000, 0x1000);
+
+  // Stop halfway, then finish the original for reference
+  source.runUntilEvent(20000);
+  const snapshot = source.saveSnapshot();
+  const pc = source.getRegister(CPURegister.PC);
+  const free = source.availMem();
+  check('the door is stopped halfway', source.getRegister(CPURegister.D7) > 0 && source.getRegister(CPURegister.D7) < 15);
+  check('zero pages are left out of the image', snapshot.getSize() < MEMORY_SIZE / 2);
+  const finished = source.runUntilEvent(10000000);
+  const expected = source.readMemoryBlock(BUFFER, 16 * 256);
+
+  for (const profile of PROFILES) {
+    const emu = new MoiraEmulator(MEMORY_SIZE, null, undefined, profile);
+    await emu.initialize();
+    check(`${profile} profile: the snapshot is restored`, emu.restoreSnapshot(snapshot));
+    check(`${profile} profile: registers and heap come back`,
+      emu.getRegister(CPURegister.PC) === pc && emu.availMem() === free);
+
+    let calls = 0;
+    emu.setTrapHandler(() => calls++);
+    const result = emu.runUntilEvent(10000000);
+    check(`${profile} profile: the door finishes like the original`,
+      result.event === ExecEvent.EXIT && finished.event === ExecEvent.EXIT && calls === 0 &&
+      emu.readMemoryBlock(BUFFER, expected.length).every((v, i) => v === expected[i]) &&
+      emu.getRegister(CPURegister.D0) === source.getRegister(CPURegister.D0));
+    check(`${profile} profile: the heap ends up like the original`, emu.availMem() === source.availMem());
+    emu.cleanup();
+  }
+
+  // Stored and loaded again
+  const copy = source.importSnapshot(source.exportSnapshot(snapshot));
+  const emu = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await emu.initialize();
+  check('an exported snapshot can be restored', emu.restoreSnapshot(copy) && emu.getRegister(CPURegister.PC) === pc);
+
+  // A damaged image, or one of another RAM size
+  emu.writeLong(0x100, 0x12345678);
+  copy.resize(copy.getSize() - 1);
+  check('a truncated snapshot is refused', !emu.restoreSnapshot(copy));
+  check('a refused snapshot leaves the emulator alone', emu.readLong(0x100) === 0x12345678);
+  emu.cleanup();
+
+  const larger = new MoiraEmulator(2 * MEMORY_SIZE, null, undefined, 'fast');
+  await larger.initialize();
+  check('a snapshot of another RAM size is refused', !larger.restoreSnapshot(snapshot));
+  larger.cleanup();
+
+  copy.delete();
+  snapshot.delete();
+  source.cleanup();
+
+  summary('door snapshot');
+}
+
+test().catch(console.error);
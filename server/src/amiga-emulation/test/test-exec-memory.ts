@@ -0,0 +1,102 @@
+import { MoiraEmulator, MoiraProfile, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Exercise the exec.library heap (AllocMem, FreeMem, AllocVec, FreeVec,
+ * AvailMem) from the host and from a door calling through ExecBase
+ */
+async function test() {
+  console.log('Testing exec.library memory functions...');
+
+  const { check, summary } = createChecks();
+
+  const MEMF_CLEAR = 1 << 16;
+  const MEMF_LARGEST = 1 << 17;
+  const MEMF_TOTAL = 1 << 19;
+  const HEAP_START = 0x2000;
+  const HEAP_END = 0x7000;
+
+  const create = async (profile: MoiraProfile): Promise<MoiraEmulator> => {
+    const emu = new MoiraEmulator(64 * 1024, null, undefined, profile);
+    await emu.initialize();
+    emu.initHeap(HEAP_START, HEAP_END);
+    return emu;
+  };
+
+  // Host calls
+  const emu = await create('fast');
+  const total = emu.availMem(MEMF_TOTAL);
+  check('heap covers the given range', total === HEAP_END - HEAP_START && emu.availMem() === total);
+
+  emu.fillMemory(HEAP_START, 0xAA, total);
+  const a = emu.allocMem(100, MEMF_CLEAR);
+  const b = emu.allocMem(100);
+  check('blocks are 8-byte aligned and do not overlap', a % 8 === 0 && b % 8 === 0 && Math.abs(b - a) >= 104);
+  check('MEMF_CLEAR clears the block', emu.readMemoryBlock(a, 100).every(v => v === 0));
+  check('blocks without MEMF_CLEAR are left alone', emu.readMemory(b) === 0xAA);
+
+  emu.freeMem(a, 100);
+  check('freed memory is reused', emu.allocMem(64) === a);
+  check('AvailMem counts allocated blocks', emu.availMem() === total - 104 - 64);
+  check('too large requests fail', emu.allocMem(total + 8) === 0);
+
+  const v = emu.allocVec(40, MEMF_CLEAR);
+  check('AllocVec stores the size in front of the block', v !== 0 && emu.readLong(v - 4) === 44);
+  emu.freeVec(v);
+  emu.freeVec(0);
+
+  // Free everything: neighbours merge back into one block
+  emu.freeMem(a, 64);
+  emu.freeMem(b, 100);
+  check('freed blocks merge again', emu.availMem() === total && emu.availMem(MEMF_LARGEST) === total);
+  emu.freeMem(b, 100);
+  check('freeing a block twice is ignored', emu.availMem() === total);
+
+  // The heap moves along with the door to the other profile
+  const kept = emu.allocMem(256);
+  emu.setProfile('accurate');
+  check('heap survives a profile switch', emu.availMem() === total - 256 && emu.allocMem(8) !== kept);
+  emu.cleanup();
+
+  // A door allocating and freeing 1000 bytes 10000 times, then asking for
+  // the free memory. The CPU services every call itself.
+  const door = [
+    0x2C78, 0x0004,                 //        movea.l 4.w,a6
+    0x3E3C, 0x270F,                 //        move.w  #9999,d7
+    0x203C, 0x0000, 0x03E8,         // loop:  move.l  #1000,d0
+    0x223C, 0x0001, 0x0000,         //        move.l  #MEMF_CLEAR,d1
+    0x4EAE, 0xFF3A,                 //        jsr     -198(a6)        AllocMem
+    0x4A80,                         //        tst.l   d0
+    0x671C,                         //        beq.s   fail
+    0x2240,                         //        movea.l d0,a1
+    0x12BC, 0x0001,                 //        move.b  #1,(a1)
+    0x203C, 0x0000, 0x03E8,         //        move.l  #1000,d0
+    0x4EAE, 0xFF2E,                 //        jsr     -210(a6)        FreeMem
+    0x51CF, 0xFFDA,                 //        dbra    d7,loop
+    0x7200,                         //        moveq   #0,d1
+    0x4EAE, 0xFF28,                 //        jsr     -216(a6)        AvailMem
+    0x4E75,                         //        rts
+    0x70FF,                         // fail:  moveq   #-1,d0
+    0x4E75,                         //        rts
+  ];
+  const code = assemble(door);
+
+  for (const profile of PROFILES) {
+    const emu = await create(profile);
+    bootDoor(emu, code);
+    emu.writeLong(4, 0xFF8000);
+    emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+    emu.setRegister(CPURegister.A7, 0x7FFC);
+
+    let calls = 0;
+    emu.setTrapHandler(() => calls++);
+    const result = emu.runUntilEvent(10000000);
+    check(`${profile} profile: door calls never reach the host and leak nothing`,
+      result.event === ExecEvent.EXIT && calls === 0 && emu.getRegister(CPURegister.D0) === total);
+    emu.cleanup();
+  }
+
+  summary('exec memory');
+}
+
+test().catch(console.error);
@@ -0,0 +1,105 @@
+import { MoiraEmulator } from '../cpu/MoiraEmulator';
+import { createChecks } from './checks';
+
+/**
+ * Build an executable with code, data and BSS hunks, 32-bit and short
+ * relocations, symbols and debug information
+ */
+function generateExecutable(): Buffer {
+  const longs: number[] = [];
+  const words = (...values: number[]) => {
+    for (let i = 0; i < values.length; i += 2) longs.push((values[i] << 16 | (values[i + 1] ?? 0)) >>> 0);
+  };
+
+  longs.push(0x3F3, 0, 3, 0, 2);        // HUNK_HEADER: 3 hunks
+  longs.push(4, 3 | 0x40000000, 64);    // Sizes in longwords (data in chip memory)
+
+  longs.push(0x3E9, 4);                 // HUNK_CODE
+  longs.push(0x41F90000, 0x00044E75);   // lea data+4,a0; rts
+  longs.push(0x00000000, 0x00000010);   // Pointers to data+0 and bss+16
+  longs.push(0x3EC);                    // HUNK_RELOC32
+  longs.push(1, 1, 2);                  //   offset 2 -> data
+  longs.push(1, 2, 12);                 //   offset 12 -> bss
+  longs.push(0);
+  longs.push(0x3F0, 1, 0x6D61696E, 0, 0); // HUNK_SYMBOL: "main" = 0
+  longs.push(0x3F2);                    // HUNK_END
+
+  longs.push(0x3EA, 3);                 // HUNK_DATA
+  longs.push(0x48656C6C, 0x6F000000, 0x00000004); // "Hello", pointer to code+4
+  longs.push(0x3FC);                    // HUNK_RELOC32SHORT
+  words(1, 0, 8, 0);                    //   offset 8 -> code, end
+  longs.push(0x3F1, 2, 0x12345678, 0x9ABCDEF0); // HUNK_DEBUG
+  longs.push(0x3F2);                    // HUNK_END
+
+  longs.push(0x3EB, 64);                // HUNK_BSS
+  longs.push(0x3F2);                    // HUNK_END
+
+  const file = Buffer.alloc(longs.length * 4);
+  longs.forEach((value, i) => file.writeUInt32BE(value, i * 4));
+  return file;
+}
+
+async function test() {
+  console.log('Testing the native hunk loader...');
+
+  const { check, summary } = createChecks();
+
+  const file = generateExecutable();
+  const emu = new MoiraEmulator(64 * 1024, null, undefined, 'fast');
+  await emu.initialize();
+  emu.fillMemory(0, 0xFF, 64 * 1024);
+
+  const loaded = emu.loadExecutable(file);
+  const [code, data, bss] = loaded.segments;
+  check('segments follow each other in 256-byte steps',
+    loaded.segments.length === 3 && code.type === 'code' && data.type === 'data' && bss.type === 'bss' &&
+    data.address === 0x1100 && data.size === 12 && bss.address === 0x1200);
+  check('the entry point is the code hunk', loaded.entryPoint === 0x1000 && code.address === 0x1000);
+  check('the end is the end of BSS', loaded.end === bss.address + 256);
+  check('the first load parses the file', !loaded.cached);
+
+  check('RELOC32 fixups point at their hunks',
+    emu.readLong(code.address + 2) === data.address + 4 && emu.readLong(code.address + 12) === bss.address + 16);
+  check('RELOC32SHORT fixups point at their hunks', emu.readLong(data.address + 8) === code.address + 4);
+  check('data is copied', emu.readString(data.address) === 'Hello');
+  check('BSS is cleared', emu.readMemoryBlock(bss.address, 256).every(b => b === 0));
+
+  // The same file again, into another emulator
+  const other = new MoiraEmulator(64 * 1024, null, undefined, 'accurate');
+  await other.initialize();
+  const again = other.loadExecutable(new Uint8Array(file));
+  check('a second load comes from the cache', again.cached && again.entryPoint === loaded.entryPoint);
+  check('the cached image is the same',
+    other.readMemoryBlock(0x1000, loaded.end - 0x1000).every((b, i) => b === emu.readMemory(0x1000 + i)));
+
+  // Another load base relocates again
+  const moved = other.loadExecutable(file, 0x4000);
+  check('another base is relocated anew', !moved.cached && moved.entryPoint === 0x4000 &&
+    other.readLong(0x4000 + 2) === moved.segments[1].address + 4);
+
+  // A full cache evicts the least recently loaded image
+  other.setHunkCacheCapacity(1);
+  const reloaded = other.loadExecutable(file);
+  check('a full cache evicts the least recently loaded image',
+    !reloaded.cached && other.loadExecutable(file).cached && !other.loadExecutable(file, 0x4000).cached);
+  other.setHunkCacheCapacity(16);
+
+  // Damaged and oversized files
+  const truncated = file.subarray(0, file.length - 8);
+  let refused = false;
+  try { emu.loadExecutable(truncated); } catch { refused = true; }
+  check('a truncated file is refused', refused);
+
+  const huge = Buffer.from(file);
+  huge.writeUInt32BE(0x10000, 7 * 4); // BSS of 256 KB
+  refused = false;
+  try { emu.loadExecutable(huge); } catch { refused = true; }
+  check('a file larger than guest RAM is refused', refused);
+
+  other.cleanup();
+  emu.cleanup();
+
+  summary('hunk loader');
+}
+
+test().catch(console.error);
@@ -0,0 +1,210 @@
+import { MoiraEmulator, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { MoiraJit } from '../cpu/jit/MoiraJit';
+import { createChecks, assemble, bootDoor } from './checks';
+
+/**
+ * Differential test of the JIT: random register-only loops run on the
+ * interpreter and with compiled loops must end with the same registers,
+ * flags and cycle count
+ */
+
+const CODE = 0x1000;
+const PROGRAMS = 300;
+
+// xorshift32, so failures can be reproduced from the seed
+let seed = Number(process.env.JIT_TEST_SEED) || 0x2545F491;
+function random(n: number): number {
+  seed ^= seed << 13;
+  seed ^= seed >>> 17;
+  seed ^= seed << 5;
+  return (seed >>> 0) % n;
+}
+
+function imm(size: number): number[] {
+  const value = random(0x100000000) >>> 0;
+  if (size === 2) return [value >>> 16, value & 0xFFFF];
+  return [size === 0 ? value & 0xFF : value & 0xFFFF];
+}
+
+/**
+ * One random instruction the JIT translates. D6 and D7 are the loop
+ * counters and A7 the stack pointer, so they are never written.
+ */
+function randomInstruction(): number[] {
+  const dn = random(6);
+  const dm = random(8);
+  const an = random(6);
+  const am = random(8);
+  const size = random(3); // 0 = byte, 1 = word, 2 = long
+  switch (random(17)) {
+    case 0: return [0x7000 | (dn << 9) | random(256)];                              // MOVEQ
+    case 1: return [([0x1000, 0x3000, 0x2000][size]) | (dn << 9) | dm];            // MOVE Dm,Dn
+    case 2: return [([0x103C, 0x303C, 0x203C][size]) | (dn << 9), ...imm(size)];   // MOVE #,Dn
+    case 3: return [(size === 2 ? 0x2040 : 0x3040) | (an << 9) | dm];              // MOVEA Dm,An
+    case 4: {
+      // ADD, SUB, AND, OR, CMP Dm,Dn / Am,Dn / #,Dn
+      const group = [0xD000, 0x9000, 0xC000, 0x8000, 0xB000][random(5)];
+      const base = group | (dn << 9) | (size << 6);
+      const source = random(3);
+      if (source === 0) return [base | dm];
+      if (source === 1 && size !== 0 && (group === 0xD000 || group === 0x9000 || group === 0xB000)) return [base | 0x08 | am];
+      return [base | 0x3C, ...imm(size)];
+    }
+    case 5: return [0xB100 | (dm << 9) | (size << 6) | dn];                        // EOR Dm,Dn
+    case 6: {
+      // ORI, ANDI, SUBI, ADDI, EORI, CMPI
+      const op = [0, 1, 2, 3, 5, 6][random(6)];
+      return [(op << 9) | (size << 6) | dn, ...imm(size)];
+    }
+    case 7: return [0x5000 | (random(8) << 9) | (random(2) << 8) | (size << 6) | dn]; // ADDQ, SUBQ Dn
+    case 8: return [0x5000 | (random(8) << 9) | (random(2) << 8) | ((1 + random(2)) << 6) | 0x08 | an];
+    case 9: return [[0x4200, 0x4400, 0x4600, 0x4A00][random(4)] | (size << 6) | dn]; // CLR, NEG, NOT, TST
+    case 10: return [[0x4880, 0x48C0, 0x4840][random(3)] | dn];                    // EXT, SWAP
+    case 11: return [0x4E71];                                                     // NOP
+    case 12: {
+      // ADDA, SUBA
+      const base = (random(2) ? 0xD0C0 : 0x90C0) | (an << 9) | (random(2) << 8);
+      return random(2) ? [base | 0x3C, ...imm(base & 0x100 ? 2 : 1)] : [base | dm];
+    }
+    case 13: return [0x41D0 | (an << 9) | am];                                     // LEA (Am),An
+    case 14: return [0x41E8 | (an << 9) | am, random(0x10000)];                    // LEA d16(Am),An
+    default: {
+      // ASd, LSd, ROd #count,Dn
+      const type = [0, 1, 3][random(3)];
+      return [0xE000 | (random(8) << 9) | (random(2) << 8) | (size << 6) | (type << 3) | dn];
+    }
+  }
+}
+
+/**
+ * Outer loop running a random inner loop, which ends with a DBcc or a Bcc
+ * and may leave early through conditional branches:
+ *
+ *         move.w  #outer,d6
+ * outer:  move.w  #inner,d7
+ * inner:  <random instructions and bcc.w next>
+ *         dbcc d7,inner / subq.w #1,d7; bcc.w inner
+ * next:   dbra    d6,outer
+ *         rts
+ */
+function randomProgram(): number[] {
+  const words: number[] = [0x3C3C, 2 + random(20), 0x3E3C, 1 + random(200)];
+  const inner = words.length;
+  const exits: number[] = [];
+  const count = 1 + random(12);
+  for (let i = 0; i < count; i++) {
+    if (random(6) === 0) {
+      exits.push(words.length);
+      words.push(0x6000 | ((2 + random(14)) << 8), 0);
+    }
+    words.push(...randomInstruction());
+  }
+  if (random(2)) {
+    // dbcc d7,inner (F or a random condition)
+    const cc = random(2) ? 1 : 2 + random(14);
+    words.push(0x50CF | (cc << 8), (2 * (inner - words.length - 1)) & 0xFFFF);
+  } else {
+    // subq.w #1,d7; bne.w / bpl.w / bgt.w inner
+    words.push(0x5347);
+    const cc = [0x6, 0xA, 0xE][random(3)];
+    words.push(0x6000 | (cc << 8), (2 * (inner - words.length - 1)) & 0xFFFF);
+  }
+  const next = words.length;
+  for (const at of exits) words[at + 1] = 2 * (next - at - 1);
+  words.push(0x51CE, (2 * (2 - words.length - 1)) & 0xFFFF, 0x4E75);
+  return words;
+}
+
+function load(emu: MoiraEmulator, words: number[], registers: number[]): void {
+  bootDoor(emu, assemble(words), CODE);
+  emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+  emu.setRegister(CPURegister.A7, 0x7FFC);
+  registers.forEach((value, i) => emu.setRegister(i, value));
+  emu.setRegister(CPURegister.SR, 0x2700 | random(32));
+}
+
+interface Outcome {
+  event: ExecEvent;
+  cycles: number;
+  registers: number[]; // D0 - A6, SR
+}
+
+function run(emu: MoiraEmulator): Outcome {
+  let cycles = 0;
+  let event = ExecEvent.BUDGET;
+  while (cycles < 50_000_000) {
+    const result = emu.runUntilEvent(100000);
+    cycles += result.cycles;
+    event = result.event;
+    if (event !== ExecEvent.BUDGET) break;
+  }
+  const registers: number[] = [];
+  for (let i = 0; i < 15; i++) registers.push(emu.getRegister(i));
+  registers.push(emu.getRegister(CPURegister.SR));
+  return { event, cycles, registers };
+}
+
+function same(a: Outcome, b: Outcome): boolean {
+  return a.event === b.event && a.cycles === b.cycles && a.registers.every((value, i) => value === b.registers[i]);
+}
+
+async function test() {
+  console.log('Testing the JIT against the interpreter...');
+  const interpreter = new MoiraEmulator(64 * 1024);
+  const jit = new MoiraEmulator(64 * 1024);
+  await interpreter.initialize();
+  await jit.initialize();
+  interpreter.setJitThreshold(0);
+  jit.setJitThreshold(3);
+
+  const { check, summary } = createChecks();
+
+  const compare = (words: number[]): boolean => {
+    const registers: number[] = [];
+    for (let i = 0; i < 15; i++) registers.push(random(0x100000000) >>> 0);
+    const sr = seed;
+    load(interpreter, words, registers);
+    seed = sr;
+    load(jit, words, registers);
+    const expected = run(interpreter);
+    const actual = run(jit);
+    if (same(expected, actual)) return true;
+    console.log(`    program: ${words.map(w => w.toString(16).padStart(4, '0')).join(' ')}`);
+    console.log(`    interpreter: ${ExecEvent[expected.event]} ${expected.cycles} ${expected.registers.map(r => r.toString(16)).join(' ')}`);
+    console.log(`    jit:         ${ExecEvent[actual.event]} ${actual.cycles} ${actual.registers.map(r => r.toString(16)).join(' ')}`);
+    return false;
+  };
+
+  // Random loops
+  let mismatches = 0;
+  let translated = 0;
+  const probe = new MoiraJit();
+  for (let i = 0; i < PROGRAMS && mismatches < 3; i++) {
+    const words = randomProgram();
+    const code = new Uint8Array(CODE + words.length * 2);
+    code.set(assemble(words), CODE);
+    const read16 = (address: number) => address + 2 <= code.length ? (code[address] << 8) | code[address + 1] : 0x4AFC;
+    if (probe.compile(read16, CODE + 8)) translated++;
+    if (!compare(words)) mismatches++;
+  }
+  check(`${PROGRAMS} random loops give the same registers, flags and cycles`, mismatches === 0);
+  check('random loops are translated', translated > PROGRAMS / 2);
+
+  // Loops with untranslatable instructions run on the interpreter
+  // loop: mulu d1,d0; addq.l #1,d1; dbra d7,loop
+  const mulu = [0x7E00 | 99, 0x7001, 0x7203, 0xC0C1, 0x5281, 0x51CF, 0xFFFA, 0x4E75];
+  check('untranslatable loops fall back to the interpreter', compare(mulu));
+
+  // Host writes to a compiled loop: the loop is translated again
+  // loop: addq.l #1,d0; dbra d7,loop
+  const loop = [0x3E3C, 999, 0x7000, 0x5280, 0x51CF, 0xFFFC, 0x4E75];
+  check('loop runs compiled', compare(loop) && jit.getRegister(CPURegister.D0) === 1000);
+  loop[3] = 0x5480; // addq.l #2,d0
+  check('rewritten loop is translated again', compare(loop) && jit.getRegister(CPURegister.D0) === 2000);
+
+  interpreter.cleanup();
+  jit.cleanup();
+  summary('JIT');
+}
+
+test().catch(console.error);
@@ -0,0 +1,49 @@
+import { MoiraEmulator } from '../cpu/MoiraEmulator';
+import { createChecks } from './checks';
+
+/**
+ * Exercise the block memory API (HEAPU8 view, fill, copy, strings, longs)
+ */
+async function test() {
+  const emu = new MoiraEmulator(64 * 1024);
+  await emu.initialize();
+  console.log('Testing block memory API...');
+
+  const { check, summary } = createChecks();
+
+  // Block write and read back
+  const pattern = new Uint8Array(4096);
+  for (let i = 0; i < pattern.length; i++) pattern[i] = (i * 7) & 0xFF;
+  emu.writeMemoryBlock(0x1000, pattern);
+  const back = emu.readMemoryBlock(0x1000, pattern.length);
+  check('writeMemoryBlock/readMemoryBlock round trip', back.every((b, i) => b === pattern[i]));
+  check('single byte access sees block data', emu.readMemory(0x1003) === pattern[3]);
+
+  // Fill and copy
+  emu.fillMemory(0x1000, 0xAA, 16);
+  check('fillMemory', emu.readMemoryBlock(0x1000, 16).every(b => b === 0xAA) && emu.readMemory(0x1010) === pattern[16]);
+  emu.copyMemory(0x2000, 0x1000, 32);
+  check('copyMemory', emu.readMemory(0x2000) === 0xAA && emu.readMemory(0x2010) === pattern[16]);
+
+  // Longs and strings
+  emu.writeLong(0x3000, 0xDEADBEEF);
+  check('writeLong/readLong', emu.readLong(0x3000) === 0xDEADBEEF && emu.readMemory(0x3000) === 0xDE);
+  emu.writeMemoryBlock(0x3100, Buffer.from('Hello AmiExpress\0junk', 'latin1'));
+  check('readString stops at NUL', emu.readString(0x3100) === 'Hello AmiExpress');
+  check('readString honours maxLength', emu.readString(0x3100, 5) === 'Hello');
+
+  // Clipping at the end of guest RAM
+  emu.writeMemoryBlock(64 * 1024 - 2, new Uint8Array([1, 2, 3, 4]));
+  check('writes are clipped to RAM size', emu.readMemoryBlock(64 * 1024 - 2, 4).length === 2);
+
+  // The view aliases guest RAM directly
+  const view = emu.getMemoryView();
+  view[0x4000] = 0x42;
+  emu.copyMemory(0x4001, 0x4000, 1);
+  check('view writes are visible to the wrapper', emu.readMemory(0x4001) === 0x42);
+
+  emu.cleanup();
+  summary('block memory');
+}
+
+test().catch(console.error);
@@ -0,0 +1,81 @@
+import { MoiraEmulator, CPURegister, ExecEvent } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor } from './checks';
+
+/**
+ * Exercise the run-until-event API (traps, exit address, STOP, illegal, faults)
+ */
+async function test() {
+  const emu = new MoiraEmulator(64 * 1024);
+  await emu.initialize();
+  console.log('Testing run-until-event API...');
+
+  const { check, summary } = createChecks();
+
+  // Load a program at 0x1000, reset, and push the exit address like AmigaDoorSession
+  const load = (words: number[]) => {
+    bootDoor(emu, assemble(words));
+    emu.writeLong(0x7FFC, MoiraEmulator.EXIT_ADDRESS);
+    emu.setRegister(CPURegister.A7, 0x7FFC);
+    emu.setRegister(CPURegister.A6, 0xFF8000);
+  };
+
+  // moveq #1,d1; jsr -48(a6); move.l d0,d2; rts
+  let offset = 0;
+  emu.setTrapHandler((o) => {
+    offset = o;
+    emu.setRegister(CPURegister.D0, emu.getRegister(CPURegister.D1) + 41);
+  });
+  load([0x7201, 0x4EAE, 0xFFD0, 0x2400, 0x4E75]);
+  let result = emu.runUntilEvent(100000);
+  check('library call is serviced and the door exits', result.event === ExecEvent.EXIT);
+  check('trap handler sees the library offset', offset === 0xFF7FD0);
+  check('registers set by the trap handler reach the CPU', emu.getRegister(CPURegister.D2) === 42);
+
+  // loop: addq.l #1,d0; bra.s loop (runs until the budget is used up)
+  load([0x5280, 0x60FC]);
+  result = emu.runUntilEvent(5000);
+  check('budget', result.event === ExecEvent.BUDGET && result.cycles >= 5000 && result.idle === 0);
+
+  // bra.s * (fast-forwarded to the end of the slice)
+  load([0x60FE]);
+  result = emu.runUntilEvent(5000);
+  check('branch to itself reports IDLE', result.event === ExecEvent.IDLE && result.cycles >= 5000 && result.idle > 0);
+
+  // move.w #999,d0; dbra d0,*; rts (delay loop, fast-forwarded in one step)
+  load([0x303C, 999, 0x51C8, 0xFFFE, 0x4E75]);
+  result = emu.runUntilEvent(100000);
+  check('DBRA delay loop is skipped', result.event === ExecEvent.EXIT && result.idle > 0 &&
+    emu.getRegister(CPURegister.D0) === 0xFFFF);
+
+  // stop #$2000
+  load([0x4E72, 0x2000]);
+  check('STOP', emu.runUntilEvent(5000).event === ExecEvent.STOP);
+
+  // nop; illegal
+  load([0x4E71, 0x4AFC]);
+  result = emu.runUntilEvent(5000);
+  check('illegal instruction', result.event === ExecEvent.ILLEGAL && result.pc === 0x1002);
+
+  // nop; move.l $200000,d0 (unmapped page)
+  load([0x4E71, 0x2039, 0x0020, 0x0000]);
+  result = emu.runUntilEvent(5000);
+  check('bus error', result.event === ExecEvent.FAULT && result.pc === 0x1002 && emu.getBusFault() === 0x200000);
+
+  // move.l $200000,$2000 (the faulting instruction writes nothing)
+  load([0x23F9, 0x0020, 0x0000, 0x0000, 0x2000]);
+  emu.writeLong(0x2000, 0x12345678);
+  result = emu.runUntilEvent(5000);
+  check('faulting instruction does not write', result.event === ExecEvent.FAULT && emu.readLong(0x2000) === 0x12345678);
+
+  // move.l $200000,d0 with the stack in unmapped memory (double fault)
+  load([0x2039, 0x0020, 0x0000]);
+  emu.setRegister(CPURegister.A7, 0x200100);
+  result = emu.runUntilEvent(5000);
+  check('bus error while stacking the frame halts the CPU', result.event === ExecEvent.FAULT &&
+    emu.getRegister(CPURegister.PC) === 0x1000);
+
+  emu.cleanup();
+  summary('run-until-event');
+}
+
+test().catch(console.error);
@@ -0,0 +1,76 @@
+import { MoiraEmulator, CPURegister } from '../cpu/MoiraEmulator';
+import { createChecks, bootDoor, PROFILES } from './checks';
+
+const CODE_SIZE = 0x2000;
+
+/**
+ * Build an executable with two pages of code that patch their own first
+ * instruction, and a BSS hunk
+ */
+function generateExecutable(): Buffer {
+  const longs = [
+    0x3F3, 0, 2, 0, 1,                   // HUNK_HEADER: 2 hunks
+    CODE_SIZE / 4, 0x4000,               // Sizes in longwords
+    0x3E9, CODE_SIZE / 4,                // HUNK_CODE
+  ];
+  const code = new Array(CODE_SIZE / 4).fill(0x4E714E71); // nop; nop
+  code[0] = 0x23FCDEAD;                  // move.l  #$DEADBEEF,$1000
+  code[1] = 0xBEEF0000;
+  code[2] = 0x100060FE;                  // bra.s   *
+  longs.push(...code);
+  longs.push(0x3F2);                     // HUNK_END
+  longs.push(0x3EB, 0x4000, 0x3F2);      // HUNK_BSS, HUNK_END
+
+  const file = Buffer.alloc(longs.length * 4);
+  longs.forEach((value, i) => file.writeUInt32BE(value >>> 0, i * 4));
+  return file;
+}
+
+/**
+ * Load the same door into several emulators and check that they share its
+ * code pages until one of them writes to them
+ */
+async function test() {
+  console.log('Testing shared code pages...');
+
+  const { check, summary } = createChecks();
+
+  const file = generateExecutable();
+  const doors: MoiraEmulator[] = [];
+  for (const profile of PROFILES) {
+    const emu = new MoiraEmulator(1024 * 1024, null, undefined, profile);
+    await emu.initialize();
+    emu.loadExecutable(file);
+    check(`${profile} profile: the code pages are shared`,
+      emu.getSharedPageCount() === CODE_SIZE / 4096 && emu.getCommittedPageCount() === 0);
+    doors.push(emu);
+  }
+
+  // The first door patches its code
+  const [first, second] = doors;
+  bootDoor(first, null);
+  first.runUntilEvent(100);
+  check('a door writing its code gets its own copy of the page',
+    first.getSharedPageCount() === CODE_SIZE / 4096 - 1 && first.getRegister(CPURegister.PC) === 0x100A);
+  check('the other door keeps the original code', second.readLong(0x1000) === 0x23FCDEAD);
+  check('reading the code leaves it shared', second.getSharedPageCount() === CODE_SIZE / 4096);
+  check('the patch stays in the door making it', first.readLong(0x1000) === 0xDEADBEEF);
+
+  // Frozen doors and their forks share the same pages
+  const fresh = new MoiraEmulator(1024 * 1024, null, undefined, 'fast');
+  await fresh.initialize();
+  fresh.loadExecutable(file);
+  const image = fresh.freeze();
+  const fork = new MoiraEmulator(1024 * 1024, null, undefined, 'fast');
+  await fork.initialize();
+  check('forks share the code pages', fork.fork(image) && fork.getSharedPageCount() === CODE_SIZE / 4096);
+  image.delete();
+  fresh.cleanup();
+  doors.forEach(emu => emu.cleanup());
+  check('the code outlives the doors that loaded it', fork.readLong(0x1004) === 0xBEEF0000);
+  fork.cleanup();
+
+  summary('shared code');
+}
+
+test().catch(console.error);
@@ -0,0 +1,149 @@
+import { MoiraEmulator, CPURegister } from '../cpu/MoiraEmulator';
+import { createChecks, assemble, bootDoor, PROFILES } from './checks';
+
+/**
+ * Build an executable with a short code hunk and a large BSS hunk
+ */
+function generateExecutable(bssSize: number): Buffer {
+  const longs = [
+    0x3F3, 0, 2, 0, 1,                   // HUNK_HEADER: 2 hunks
+    2, bssSize / 4,                      // Sizes in longwords
+    0x3E9, 2, 0x70014E75, 0x4E714E71,    // HUNK_CODE: moveq #1,d0; rts; nop; nop
+    0x3F2,                               // HUNK_END
+    0x3EB, bssSize / 4,                  // HUNK_BSS
+    0x3F2,                               // HUNK_END
+  ];
+  const file = Buffer.alloc(longs.length * 4);
+  longs.forEach((value, i) => file.writeUInt32BE(value, i * 4));
+  return file;
+}
+
+/**
+ * Give doors a large guest RAM and check that only the pages they write are
+ * committed
+ */
+async function test() {
+  console.log('Testing lazily committed guest RAM...');
+
+  const { check, summary } = createChecks();
+
+  const MEMORY_SIZE = 16 * 1024 * 1024;
+  const MEMF_CLEAR = 1 << 16;
+  const FAR = 0x7F0000;
+
+  // A door writing one longword far up in RAM
+  const door = [
+    0x23FC, 0x1234, 0x5678,           // move.l  #$12345678,FAR
+    FAR >>> 16, FAR & 0xFFFF,
+    0x60FE,                           // bra.s   *
+  ];
+  const code = assemble(door);
+
+  for (const profile of PROFILES) {
+    const emu = new MoiraEmulator(MEMORY_SIZE, null, undefined, profile);
+    await emu.initialize();
+    check(`${profile} profile: a new door has no pages committed`, emu.getCommittedPageCount() === 0);
+
+    // Vectors and code
+    bootDoor(emu, code);
+    const loaded = emu.getCommittedPageCount();
+    check(`${profile} profile: host writes commit their pages`, loaded === 2);
+
+    emu.runUntilEvent(100);
+    check(`${profile} profile: a door write commits one page`,
+      emu.getCommittedPageCount() === loaded + 1 && emu.getRegister(CPURegister.PC) === 0x100A);
+
+    emu.initHeap(0x100000, 0x800000);
+    const block = emu.allocMem(4 * 1024 * 1024, MEMF_CLEAR);
+    check(`${profile} profile: a cleared allocation commits nothing`,
+      block !== 0 && emu.getCommittedPageCount() === loaded + 1);
+
+    emu.fillMemory(FAR, 0, 4096);
+    check(`${profile} profile: clearing a whole page releases it`, emu.getCommittedPageCount() === loaded);
+    check(`${profile} profile: untouched pages read as zero`,
+      emu.readLong(FAR) === 0 && emu.readLong(block + 0x10000) === 0);
+
+    emu.cleanup();
+  }
+
+  // The BSS of an executable is free until the door writes to it
+  const emu = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await emu.initialize();
+  const loaded = emu.loadExecutable(generateExecutable(2 * 1024 * 1024));
+  check('a large BSS commits nothing', emu.getCommittedPageCount() === 0 &&
+    loaded.segments[1].size === 2 * 1024 * 1024 && loaded.end > 0x200000);
+
+  // Frozen images hold only the pages that are not all zero
+  const image = emu.freeze();
+  const fork = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'accurate');
+  await fork.initialize();
+  check('a fork shares the code and nothing else', fork.fork(image) &&
+    fork.getSharedPageCount() === 1 && fork.getCommittedPageCount() === 0);
+  fork.cleanup();
+  image.delete();
+  emu.cleanup();
+
+  // A word at the last byte of a page reaches into the next page, however
+  // that one is backed (odd word accesses only pass on the fast profile)
+  const boot = async (words: number[]): Promise<MoiraEmulator> => {
+    const door = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+    await door.initialize();
+    bootDoor(door, assemble(words));
+    return door;
+  };
+
+  const zero = await boot([
+    0x33FC, 0xABCD, 0x0000, 0x2FFF,   // move.w  #$ABCD,$2FFF
+    0x3239, 0x0000, 0x2FFF,           // move.w  $2FFF,d1
+    0x1439, 0x0000, 0x3000,           // move.b  $3000,d2
+    0x60FE,                           // bra.s   *
+  ]);
+  zero.runUntilEvent(200);
+  check('a word crossing into an untouched page writes both pages',
+    zero.readMemory(0x2FFF) === 0xAB && zero.readMemory(0x3000) === 0xCD &&
+    (zero.getRegister(CPURegister.D1) & 0xFFFF) === 0xABCD && (zero.getRegister(CPURegister.D2) & 0xFF) === 0xCD);
+
+  // Page 5 of the image is all zero and not stored, page 6 is
+  zero.writeMemory(0x4FFF, 0x12);
+  zero.writeMemory(0x6000, 0x9A);
+  const crossed = zero.freeze();
+  const shared = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await shared.initialize();
+  shared.fork(crossed);
+  bootDoor(shared, assemble([
+    0x3239, 0x0000, 0x4FFF,           // move.w  $4FFF,d1
+    0x33FC, 0x5678, 0x0000, 0x5FFF,   // move.w  #$5678,$5FFF
+    0x60FE,                           // bra.s   *
+  ]));
+  shared.runUntilEvent(200);
+  check('a word read from a shared page ends in its own neighbour',
+    (shared.getRegister(CPURegister.D1) & 0xFFFF) === 0x1200);
+  check('a word crossing into a shared page gives it its own copy',
+    shared.readMemory(0x5FFF) === 0x56 && shared.readMemory(0x6000) === 0x78);
+  const sibling = new MoiraEmulator(MEMORY_SIZE, null, undefined, 'fast');
+  await sibling.initialize();
+  check('the image keeps the shared page', sibling.fork(crossed) && sibling.readMemory(0x6000) === 0x9A);
+  sibling.cleanup();
+  shared.cleanup();
+  crossed.delete();
+  zero.cleanup();
+
+  // The loop patches its first instruction from the page below, turning
+  // addq.w #1,d3 into moveq #$43,d0; the cached block must be dropped
+  const code = await boot([
+    0x5243,                           // addq.w  #1,d3
+    0x0C43, 0x0003,                   // cmp.w   #3,d3
+    0x66F8,                           // bne.s   $1000
+    0x33FC, 0x0070, 0x0000, 0x0FFF,   // move.w  #$0070,$0FFF
+    0x60EE,                           // bra.s   $1000
+  ]);
+  code.runUntilEvent(2000);
+  check('a word crossing into a code page drops its cached code',
+    code.readMemory(0x1000) === 0x70 && (code.getRegister(CPURegister.D3) & 0xFFFF) === 3 &&
+    code.getRegister(CPURegister.D0) === 0x43);
+  code.cleanup();
+
+  summary('sparse memory');
+}
+
+test().catch(console.error);